@@ -16993,12 +16993,55 @@ namespace cimg_library {
 
       unsigned int mempos, mem_img_median, mem_img_norm, mem_img_index, debug_indent,
         result_dim, result_end_dim, break_type, constcache_size;
-      bool is_parallelizable, is_noncritical_run, is_end_code, is_fill, need_input_copy, return_comp;
+      bool is_parallelizable, is_noncritical_run, is_end_code, is_fill, need_input_copy, return_comp, is_cacheable;
       double *result, *result_end;
       cimg_uint64 rng;
       const char *const calling_function, *s_op, *ss_op;
       typedef double (*mp_func)(_cimg_math_parser&);
 
+#ifdef cimg_mp_cache_size
+      // Process-wide cache of compiled expressions (define 'cimg_mp_cache_size' as the number of entries to enable it).
+      // An entry is keyed by the expression and the shapes of the input, output and list images, and holds the
+      // state of the parser right after compilation. Expressions that depend on image values or on external
+      // variables at compile time are not cached.
+      // The whole cache is bounded by 'cimg_mp_cache_bytes', least recently used entries are evicted first.
+#ifndef cimg_mp_cache_bytes
+#define cimg_mp_cache_bytes ((cimg_uint64)64<<20)
+#endif
+      struct _cimg_mp_cached {
+        CImg<charT> key;
+        CImg<doubleT> mem;
+        CImg<intT> memmerge;
+        CImgList<ulongT> code, code_begin, code_end, code_begin_t, code_end_t;
+        unsigned int ind_result, ind_result_end, result_dim, result_end_dim;
+        bool is_parallelizable, is_noncritical_run, need_input_copy;
+        cimg_uint64 last_use, bytes;
+        _cimg_mp_cached():ind_result(0),ind_result_end(~0U),result_dim(0),result_end_dim(0),
+                          is_parallelizable(true),is_noncritical_run(false),need_input_copy(false),
+                          last_use(0),bytes(0) {}
+
+        void clear() {
+          key.assign(); mem.assign(); memmerge.assign();
+          code.assign(); code_begin.assign(); code_end.assign(); code_begin_t.assign(); code_end_t.assign();
+          last_use = bytes = 0;
+        }
+      };
+
+      static _cimg_mp_cached *cache_entries(cimg_uint64 **const p_clock=0, cimg_uint64 **const p_bytes=0) {
+        static _cimg_mp_cached entries[cimg_mp_cache_size];
+        static cimg_uint64 clock = 0, bytes = 0;
+        if (p_clock) *p_clock = &clock;
+        if (p_bytes) *p_bytes = &bytes;
+        return entries;
+      }
+
+      static cimg_uint64 cache_bytes(const CImgList<ulongT>& list) {
+        cimg_uint64 res = 0;
+        cimglist_for(list,l) res+=list[l].size()*sizeof(ulongT);
+        return res;
+      }
+#endif
+
 #define _cimg_mp_calling_function s_calling_function()._data
 #define _cimg_mp_check_const_scalar(arg,n_arg,mode) check_const_scalar(arg,n_arg,mode,ss,se,saved_char)
 #define _cimg_mp_check_const_index(arg) check_const_index(arg,ss,se,saved_char)
@@ -17049,7 +17092,7 @@ namespace cimg_library {
         img_stats(_img_stats),list_stats(_list_stats),list_median(_list_median),list_norm(_list_norm),user_macro(0),
         mem_img_median(~0U),mem_img_norm(~0U),mem_img_index(~0U),debug_indent(0),result_dim(0),result_end_dim(0),
         break_type(0),constcache_size(0),is_parallelizable(true),is_noncritical_run(false),is_fill(_is_fill),
-        need_input_copy(false),result_end(0),rng((cimg::_rand(),cimg::rng())),
+        need_input_copy(false),is_cacheable(true),result_end(0),rng((cimg::_rand(),cimg::rng())),
         calling_function(funcname?funcname:"cimg_math_parser") {
 
 #if cimg_use_openmp!=0
@@ -17061,6 +17104,10 @@ namespace cimg_library {
                                       pixel_type(),_cimg_mp_calling_function);
         const char *_expression = expression;
         while (*_expression && (cimg::is_blank(*_expression) || *_expression==';')) ++_expression;
+#ifdef cimg_mp_cache_size
+        const CImg<charT> key = cache_key(_expression);
+        if (cache_get(key)) { init_evaluation(); return; }
+#endif
         CImg<charT>::string(_expression).move_to(expr);
         char *ps = &expr.back() - 1;
         while (ps>expr._data && (cimg::is_blank(*ps) || *ps==';')) --ps;
@@ -17133,8 +17180,15 @@ namespace cimg_library {
         if (mem._width>=256 && mem._width - mempos>=mem._width/2) mem.resize(mempos,1,1,1,-1);
         result_dim = size(ind_result);
         result = mem._data + ind_result;
+#ifdef cimg_mp_cache_size
+        if (is_cacheable && !img_stats && !list_stats && !list_median && !list_norm &&
+            mem_img_median==~0U && mem_img_norm==~0U) cache_put(key);
+#endif
+        init_evaluation();
+      }
 
-        // Free resources used for compiling expression and prepare evaluation.
+      // Free resources used for compiling expression and prepare evaluation.
+      void init_evaluation() {
         memtype.assign();
         constcache_vals.assign();
         constcache_inds.assign();
@@ -17159,13 +17213,129 @@ namespace cimg_library {
         p_code_end = code.end();
       }
 
+#ifdef cimg_mp_cache_size
+      // Return key of an expression in the cache of compiled expressions.
+      CImg<charT> cache_key(const char *const expression) const {
+        unsigned int ind_out = ~0U;
+        if (&imgout>=imglist.data() && &imgout<imglist.end()) ind_out = (unsigned int)(&imgout - imglist.data());
+        else cimglist_for(imglist,l)
+          if (imgout._data==imglist[l]._data && imgout.is_sameXYZC(imglist[l])) { ind_out = l; break; }
+        CImg<uintT> props(12 + 5*imglist._width);
+        unsigned int *ptrd = props._data;
+        *(ptrd++) = (unsigned int)is_fill;
+        *(ptrd++) = imgin._width; *(ptrd++) = imgin._height; *(ptrd++) = imgin._depth; *(ptrd++) = imgin._spectrum;
+        *(ptrd++) = (unsigned int)imgin._is_shared;
+        *(ptrd++) = imgout._width; *(ptrd++) = imgout._height; *(ptrd++) = imgout._depth; *(ptrd++) = imgout._spectrum;
+        *(ptrd++) = ind_out;
+        *(ptrd++) = imglist._width;
+        cimglist_for(imglist,l) {
+          const CImg<T> &img = imglist[l];
+          *(ptrd++) = img._width; *(ptrd++) = img._height; *(ptrd++) = img._depth; *(ptrd++) = img._spectrum;
+          *(ptrd++) = (unsigned int)img._is_shared;
+        }
+        const unsigned int
+          l_expr = (unsigned int)std::strlen(expression) + 1,
+          l_props = (unsigned int)(props._width*sizeof(unsigned int));
+        CImg<charT> res(l_expr + l_props);
+        std::memcpy(res._data,expression,l_expr);
+        std::memcpy(res._data + l_expr,props._data,l_props);
+        return res;
+      }
+
+      // Restore state of parser from the cache of compiled expressions (return 'false' if not found).
+      bool cache_get(const CImg<charT>& key) {
+        cimg_uint64 *p_clock;
+        _cimg_mp_cached *const entries = cache_entries(&p_clock);
+        bool is_found = false;
+        cimg::mutex(16);
+        for (unsigned int i = 0; i<cimg_mp_cache_size && !is_found; ++i) {
+          _cimg_mp_cached &entry = entries[i];
+          if (entry.key._width==key._width && !std::memcmp(entry.key._data,key._data,key._width)) {
+            mem.assign(entry.mem);
+            memmerge.assign(entry.memmerge);
+            _code.assign(entry.code);
+            code_begin.assign(entry.code_begin);
+            code_end.assign(entry.code_end);
+            _code_begin_t.assign(entry.code_begin_t);
+            _code_end_t.assign(entry.code_end_t);
+            result = mem._data + entry.ind_result;
+            result_end = entry.ind_result_end!=~0U?mem._data + entry.ind_result_end:0;
+            result_dim = entry.result_dim;
+            result_end_dim = entry.result_end_dim;
+            is_parallelizable = entry.is_parallelizable;
+            is_noncritical_run = entry.is_noncritical_run;
+            need_input_copy = entry.need_input_copy;
+            entry.last_use = ++*p_clock;
+            is_found = true;
+          }
+        }
+        cimg::mutex(16,0);
+        return is_found;
+      }
+
+      // Store state of parser (right after compilation) in the cache of compiled expressions.
+      void cache_put(const CImg<charT>& key) {
+        if (mem._width>(1U<<20)) return; // Do not keep large memory blocks alive
+        if (result_end && (result_end<mem._data || result_end>=mem.end())) return;
+        const cimg_uint64 bytes = key.size()*sizeof(charT) + mem.size()*sizeof(double) +
+          memmerge.size()*sizeof(int) + cache_bytes(_code) + cache_bytes(code_begin) + cache_bytes(code_end) +
+          cache_bytes(_code_begin_t) + cache_bytes(_code_end_t);
+        if (bytes>cimg_mp_cache_bytes) return;
+        cimg_uint64 *p_clock, *p_bytes;
+        _cimg_mp_cached *const entries = cache_entries(&p_clock,&p_bytes);
+        cimg::mutex(16);
+        unsigned int ind = 0;
+        bool is_found = false;
+        for (unsigned int i = 0; i<cimg_mp_cache_size && !is_found; ++i) {
+          const _cimg_mp_cached &entry = entries[i];
+          if (entry.key._width==key._width && !std::memcmp(entry.key._data,key._data,key._width)) {
+            ind = i; is_found = true; // Compiled concurrently by another thread
+          } else if (entry.last_use<entries[ind].last_use) ind = i;
+        }
+        _cimg_mp_cached &entry = entries[ind];
+        if (!is_found) {
+          *p_bytes-=entry.bytes;
+          entry.clear();
+          // Evict least recently used entries until the new one fits in the cache.
+          while (*p_bytes + bytes>cimg_mp_cache_bytes) {
+            unsigned int ind_lru = ~0U;
+            for (unsigned int i = 0; i<cimg_mp_cache_size; ++i)
+              if (i!=ind && entries[i].bytes && (ind_lru==~0U || entries[i].last_use<entries[ind_lru].last_use))
+                ind_lru = i;
+            if (ind_lru==~0U) break;
+            *p_bytes-=entries[ind_lru].bytes;
+            entries[ind_lru].clear();
+          }
+          entry.key.assign(key);
+          entry.mem.assign(mem);
+          entry.memmerge.assign(memmerge);
+          entry.code.assign(_code);
+          entry.code_begin.assign(code_begin);
+          entry.code_end.assign(code_end);
+          entry.code_begin_t.assign(_code_begin_t);
+          entry.code_end_t.assign(_code_end_t);
+          entry.ind_result = (unsigned int)(result - mem._data);
+          entry.ind_result_end = result_end?(unsigned int)(result_end - mem._data):~0U;
+          entry.result_dim = result_dim;
+          entry.result_end_dim = result_end_dim;
+          entry.is_parallelizable = is_parallelizable;
+          entry.is_noncritical_run = is_noncritical_run;
+          entry.need_input_copy = need_input_copy;
+          entry.bytes = bytes;
+          *p_bytes+=bytes;
+        }
+        entry.last_use = ++*p_clock;
+        cimg::mutex(16,0);
+      }
+#endif
+
       _cimg_math_parser():
         code(_code),code_begin_t(_code_begin_t),code_end_t(_code_end_t),
         p_code_end(0),p_break((CImg<ulongT>*)(cimg_ulong)-2),
         imgin(CImg<T>::const_empty()),imgout(CImg<T>::empty()),imglist(CImgList<T>::empty()),
         img_stats(_img_stats),list_stats(_list_stats),list_median(_list_median),list_norm(_list_norm),debug_indent(0),
         result_dim(0),result_end_dim(0),break_type(0),constcache_size(0),is_parallelizable(true),
-        is_noncritical_run(false),is_fill(false),need_input_copy(false),
+        is_noncritical_run(false),is_fill(false),need_input_copy(false),is_cacheable(false),
         result_end(0),rng(0),calling_function(0) {
         mem.assign(1 + _cimg_mp_slot_c,1,1,1,0); // Allow to skip 'is_empty?' test in operator()()
         result = mem._data;
@@ -17178,7 +17348,7 @@ namespace cimg_library {
         img_stats(mp.img_stats),list_stats(mp.list_stats),list_median(mp.list_median),list_norm(mp.list_norm),
         debug_indent(0),result_dim(mp.result_dim),result_end_dim(mp.result_end_dim),break_type(0),constcache_size(0),
         is_parallelizable(mp.is_parallelizable),is_noncritical_run(mp.is_noncritical_run),is_fill(mp.is_fill),
-        need_input_copy(mp.need_input_copy),
+        need_input_copy(mp.need_input_copy),is_cacheable(false),
         result(mem._data + (mp.result - mp.mem._data)),
         result_end(mp.result_end?mem._data + (mp.result_end - mp.mem._data):0),
         rng((cimg::_rand(),cimg::rng())),calling_function(0) {
@@ -23615,8 +23785,10 @@ namespace cimg_library {
         variable_name.assign(ss,(unsigned int)(se + 1 - ss)).back() = 0;
 
 #ifdef cimg_mp_operator_dollar
-        if (*ss=='$' && ss1<se) // External variable '$varname'.
+        if (*ss=='$' && ss1<se) { // External variable '$varname'.
+          is_cacheable = false;
           _cimg_mp_const_scalar(cimg_mp_operator_dollar(variable_name._data + 1));
+        }
 #endif
 
         // No known item found, assuming this is an already initialized variable.
@@ -2611,6 +2611,83 @@ const char* gmic::basename(const char *const str)  {
   return p;
 }
 
+// Command profiler.
+//------------------
+void gmic_profiler::enter_run(const unsigned long long image_bytes) {
+  frames.push_back(frame());
+  frames.back().start = now_ms();
+  frames.back().command_bytes = image_bytes;
+}
+
+void gmic_profiler::leave_run(const unsigned long long image_bytes) {
+  if (frames.empty()) return;
+  const double now = now_ms();
+  end_command(frames.back(),now,image_bytes);
+  const double run_ms = now - frames.back().start;
+  frames.pop_back();
+  if (!frames.empty() && frames.back().is_open) frames.back().child_ms+=run_ms;
+}
+
+void gmic_profiler::begin_command(const char *const name, const bool is_custom,
+                                  const unsigned long long image_bytes) {
+  if (frames.empty()) return;
+  frame &f = frames.back();
+  const double now = now_ms();
+  end_command(f,now,image_bytes);
+  f.name.assign(name);
+  f.is_custom = is_custom;
+  f.command_start = now;
+  f.child_ms = 0;
+  f.command_bytes = image_bytes;
+  f.is_open = true;
+}
+
+void gmic_profiler::end_command(frame& f, const double now, const unsigned long long image_bytes) {
+  if (!f.is_open) return;
+  command_stats &s = stats[f.name];
+  const double inclusive_ms = now - f.command_start;
+  ++s.calls;
+  s.inclusive_ms+=inclusive_ms;
+  s.exclusive_ms+=inclusive_ms>f.child_ms?inclusive_ms - f.child_ms:0;
+  if (image_bytes>f.command_bytes) s.allocated_bytes+=image_bytes - f.command_bytes;
+  s.is_custom = f.is_custom;
+  f.is_open = false;
+}
+
+namespace {
+  bool gmic_profiler_compare(const std::pair<std::string,gmic_profiler::command_stats>& a,
+                             const std::pair<std::string,gmic_profiler::command_stats>& b) {
+    return a.second.exclusive_ms>b.second.exclusive_ms;
+  }
+}
+
+std::vector<std::pair<std::string,gmic_profiler::command_stats> > gmic_profiler::sorted() const {
+  std::vector<std::pair<std::string,command_stats> > list(stats.begin(),stats.end());
+  std::sort(list.begin(),list.end(),gmic_profiler_compare);
+  return list;
+}
+
+template<typename T>
+static unsigned long long gmic_list_bytes(const CImgList<T>& list) {
+  unsigned long long bytes = 0;
+  cimglist_for(list,l) bytes+=(unsigned long long)list[l].size()*sizeof(T);
+  return bytes;
+}
+
+// Scope of a call to '_run()' for the profiler (also left when an exception is thrown).
+template<typename T>
+struct gmic_profiler_run {
+  gmic_profiler *const profiler;
+  const CImgList<T>& images;
+  gmic_profiler_run(gmic_profiler *const p_profiler, const CImgList<T>& p_images):
+    profiler(p_profiler),images(p_images) {
+    if (profiler) profiler->enter_run(gmic_list_bytes(images));
+  }
+  ~gmic_profiler_run() {
+    if (profiler) profiler->leave_run(gmic_list_bytes(images));
+  }
+};
+
 // Constructors / destructors.
 //----------------------------
 #define gmic_display_window(n) (*(CImgDisplay*)display_windows[n])
@@ -2635,6 +2712,7 @@ gmic &gmic::assign(const gmic &gmic_instance) {
   CImgList<gmic_pixel_type> images;
   CImgList<char> images_names;
   _gmic(0,images,images_names,0,false,0,0);
+  is_expansion_cache = gmic_instance.is_expansion_cache;
   cimg::mutex(23);
   for (unsigned int i = 0; i<gmic_comslots; ++i) {
     commands[i].assign(gmic_instance.commands[i],true);
@@ -3393,6 +3471,14 @@ const char *gmic::set_variable(const char *const name, const char operation,
     varlengths[ind] = 0;
   }
 
+  // Detach variable from a shared buffer (see 'share_variable()') before modifying it.
+  if (vars[ind]._is_shared) {
+    if (is_arithmetic || operation=='.' || operation==',' || (value && *value==gmic_store)) {
+      CImg<char> tmp(vars[ind],false);
+      tmp.move_to(vars[ind].assign());
+    } else vars[ind].assign();
+  }
+
   // If arithmetic operation, get current variable value ('cvalue').
   double cvalue = 0;
   if (is_arithmetic) {
@@ -3540,6 +3626,7 @@ const char *gmic::set_variable(const char *const name, const CImg<unsigned char>
     if (ind>=varlengths._width) varlengths.resize(std::max(8U,2*varlengths._width + 1),1,1,1,0);
     varlengths[ind] = 0;
   }
+  if (vars[ind]._is_shared) vars[ind].assign(); // Detach from shared buffer
   s_value.move_to(vars[ind]); // Update variable
   varlengths[ind] = 7 + varnames[ind]._width;
 
@@ -3547,6 +3634,65 @@ const char *gmic::set_variable(const char *const name, const CImg<unsigned char>
   return vars[ind].data();
 }
 
+// Set variable value as a shared view of an existing buffer (no copy).
+//----------------------------------------------------------------------
+// 'value' is either a string or an image-encoded value (starting with 'gmic_store').
+// The buffer must stay alive and unchanged as long as the variable refers to it.
+// Any further modification of the variable detaches it from 'value' first.
+const char *gmic::share_variable(const char *const name, const CImg<char>& value) {
+  if (!name || !value) return "";
+  const bool
+    is_global = *name=='_',
+    is_thread_global = is_global && name[1]=='_';
+  if (is_thread_global) cimg::mutex(30);
+  const unsigned int hash = hashcode(name,true);
+  CImgList<char> &vars = *variables[hash], &varnames = *variables_names[hash];
+  CImg<unsigned int> &varlengths = *variables_lengths[hash];
+  unsigned int ind = ~0U;
+
+  // Retrieve index of current definition.
+  for (int l = vars.width() - 1; l>=0; --l) if (!std::strcmp(varnames[l],name)) { ind = l; break; }
+  if (ind==~0U) { // Create new variable slot if needed
+    ind = vars._width;
+    vars.insert(1);
+    CImg<char>::string(name).move_to(varnames);
+    if (ind>=varlengths._width) varlengths.resize(std::max(8U,2*varlengths._width + 1),1,1,1,0);
+  }
+  vars[ind].assign(value,true);
+  if (*value==gmic_store) varlengths[ind] = 7 + varnames[ind]._width;
+  else {
+    const char *const end = (const char*)std::memchr(value._data,0,value.size());
+    varlengths[ind] = (unsigned int)(end?end - value._data:value.size());
+  }
+
+  if (is_thread_global) cimg::mutex(30,0);
+  return vars[ind].data();
+}
+
+// Move variable value out of its slot (no copy).
+//-----------------------------------------------
+// A variable still sharing the buffer set by 'share_variable()' is returned as a shared view of it.
+// Return 'false' if the variable does not exist.
+bool gmic::take_variable(const char *const name, CImg<char>& value) {
+  if (!name) return false;
+  const bool
+    is_global = *name=='_',
+    is_thread_global = is_global && name[1]=='_';
+  if (is_thread_global) cimg::mutex(30);
+  const unsigned int hash = hashcode(name,true);
+  CImgList<char> &vars = *variables[hash], &varnames = *variables_names[hash];
+  CImg<unsigned int> &varlengths = *variables_lengths[hash];
+  unsigned int ind = ~0U;
+  for (int l = vars.width() - 1; l>=0; --l) if (!std::strcmp(varnames[l],name)) { ind = l; break; }
+  if (ind!=~0U) {
+    value.assign();
+    value.swap(vars[ind]);
+    varlengths[ind] = 0;
+  }
+  if (is_thread_global) cimg::mutex(30,0);
+  return ind!=~0U;
+}
+
 // Add custom commands from a char* buffer.
 //------------------------------------------
 gmic& gmic::add_commands(const char *const data_commands, const char *const commands_file, const bool add_debug_info,
@@ -3660,6 +3806,8 @@ gmic& gmic::add_commands(const char *const data_commands, const char *const comm
       } else commands[hash][pos].append(body,'x'); // Insert code without debug info
     }
   }
+  commands_expansions.clear();
+  ++commands_generation;
   cimg::mutex(23,0);
   return *this;
 }
@@ -4020,6 +4168,8 @@ gmic& gmic::_gmic(const char *const commands_line,
   commands_names = new CImgList<char>[gmic_comslots];
   delete[] commands_has_arguments;
   commands_has_arguments = new CImgList<char>[gmic_comslots];
+  commands_expansions.clear();
+  ++commands_generation;
   delete[] _variables;
   _variables = new CImgList<char>[gmic_varslots];
   delete[] _variables_names;
@@ -4978,6 +5128,7 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
   const unsigned int
     initial_callstack_size = callstack.size(),
     initial_debug_line = debug_line;
+  const gmic_profiler_run<T> profiler_run(profiler,images);
 
   CImgList<_gmic_parallel<T> > gmic_threads;
   CImgList<unsigned int> primitives;
@@ -5357,6 +5508,18 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
         command[_command.width() - 2] = *s_selection = 0;
       }
       position = position_argument;
+#if cimg_use_openmp!=0
+      if (thread_budget) {
+        const int budget = thread_budget->load(std::memory_order_relaxed);
+        if (budget>0 && budget!=thread_budget_applied) {
+          thread_budget_applied = budget;
+          omp_set_num_threads(thread_budget_applied);
+        }
+      }
+#endif
+      if (profiler)
+        profiler->begin_command(is_command?command:"(input or assignment)",is_command && ind_custom!=~0U,
+                                gmic_list_bytes(images));
       if (_s_selection._width!=selsiz) { // Go back to initial size for selection image.
         _s_selection.assign(selsiz);
         s_selection = _s_selection.data();
@@ -12170,6 +12333,8 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
               commands_names[i].assign();
               commands_has_arguments[i].assign();
             }
+            commands_expansions.clear();
+            ++commands_generation;
             print(0,"Discard definitions of all custom commands (%u command%s).",
                   nb_commands,nb_commands>1?"s":"");
             cimg::mutex(23,0);
@@ -12195,6 +12360,8 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
                 }
               }
             }
+            commands_expansions.clear();
+            ++commands_generation;
             if (is_verbose) {
               cimg::mutex(29);
               unsigned int isiz = 0;
@@ -13132,10 +13299,22 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
               }
             }
 
+            // Look for the items of a previous expansion of the command (not when debugging,
+            // to keep the expansion messages).
+            std::map<const char*,command_expansion>::iterator it_expansion = commands_expansions.find(command_code);
+            if (it_expansion==commands_expansions.end()) {
+              it_expansion = commands_expansions.insert(std::make_pair(command_code,command_expansion())).first;
+              it_expansion->second.is_constant = !std::strchr(command_code,'$');
+            }
+            const unsigned int expansion_generation = commands_generation;
+            const bool is_constant_expansion = it_expansion->second.is_constant;
+            const bool use_expansion_cache = is_expansion_cache && !is_debug;
+            bool is_cached_expansion = use_expansion_cache && is_constant_expansion && it_expansion->second.items;
+
             // Substitute arguments in custom command expression.
             CImg<char> inbraces;
 
-            for (const char *nsource = command_code; *nsource;)
+            for (const char *nsource = is_cached_expansion?command_code_back:command_code; *nsource;)
               if (*nsource!='$') {
 
                 // If not starting with '$'.
@@ -13369,8 +13548,13 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
               debug("Expand command line for command '%s' to: '%s'.",command_name,command_code_text.data());
             }
 
-            const CImgList<char>
-              ncommands_line = commands_line_to_CImgList(substituted_command.data());
+            CImgList<char> ncommands_line;
+            if (use_expansion_cache && !is_cached_expansion && !is_constant_expansion && it_expansion->second.items &&
+                it_expansion->second.text &&
+                !std::strcmp(it_expansion->second.text,substituted_command))
+              is_cached_expansion = true;
+            if (is_cached_expansion) ncommands_line.swap(it_expansion->second.items); // Taken back after the run
+            else commands_line_to_CImgList(substituted_command.data()).move_to(ncommands_line);
             CImg<unsigned int> nvariables_sizes;
             if (!run_subcommand) {
               nvariables_sizes.assign(gmic_varslots);
@@ -13466,6 +13650,15 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
                 g_list.move_to(images,uind0);
               }
             }
+            if (use_expansion_cache && commands_generation==expansion_generation) { // Keep items for the next call
+              it_expansion = commands_expansions.find(command_code);
+              if (it_expansion!=commands_expansions.end() && !it_expansion->second.items) {
+                if (!is_constant_expansion && !is_cached_expansion)
+                  it_expansion->second.text.assign(substituted_command.data(),
+                                                   (unsigned int)std::strlen(substituted_command) + 1);
+                ncommands_line.swap(it_expansion->second.items);
+              }
+            }
             if (!run_subcommand)
               for (unsigned int l = 0; l<gmic_varslots/2; ++l) if (variables[l]->size()>nvariables_sizes[l]) {
                   if (variables_lengths[l]->_width - nvariables_sizes[l]>variables_lengths[l]->_width/2)
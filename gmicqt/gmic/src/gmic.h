@@ -207,6 +207,10 @@ namespace gmic_library {
 #define cimg_appname "gmic"
 #endif
 
+#ifndef cimg_mp_cache_size
+#define cimg_mp_cache_size 256
+#endif
+
 #ifdef gmic_is_parallel
 #define cimg_use_pthread
 #endif
@@ -279,13 +283,22 @@ inline double gmic_mp_store(const double *const ptrs, const unsigned int siz,
 //--------------------------------------------------------
 // Public API for the 'gmic' and 'gmic_exception' classes.
 //--------------------------------------------------------
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <map>
+#include <string>
+#include <vector>
 #define gmic_new_attr commands(0), commands_names(0), commands_has_arguments(0), \
-    _variables(0), _variables_names(0), variables(0), variables_names(0), _variables_lengths(0), variables_lengths(0)
+    _variables(0), _variables_names(0), variables(0), variables_names(0), _variables_lengths(0), variables_lengths(0), \
+    profiler(0), thread_budget(0), thread_budget_applied(0), commands_generation(0), \
+    is_expansion_cache(true)
 
 using namespace gmic_library;
 
+struct gmic_profiler;
+
 // Class 'gmic'.
 //--------------
 struct gmic {
@@ -396,6 +409,8 @@ struct gmic {
                            const double dvalue=0, const unsigned int *const variables_sizes=0);
   const char *set_variable(const char *const name, const gmic_image<unsigned char>& value,
                            const unsigned int *const variables_sizes=0);
+  const char *share_variable(const char *const name, const gmic_image<char>& value);
+  bool take_variable(const char *const name, gmic_image<char>& value);
 
   gmic& add_commands(const char *const data_commands, const char *const commands_file=0,
                      const bool add_debug_info=false,
@@ -493,6 +508,24 @@ struct gmic {
   bool allow_main_, is_change, is_debug, is_running, is_start, is_return, is_quit, is_debug_info,
     _is_abort, *is_abort, is_abort_thread, is_lbrace_command;
   const char *starting_commands_line;
+  gmic_profiler *profiler; // Opt-in profiling of the commands run (not owned, not inherited by copies)
+  // Opt-in maximal number of threads of the multi-threaded operators, read before each command so that
+  // it can be changed by another thread during the run (not owned, not inherited by copies).
+  const std::atomic<int> *thread_budget;
+  int thread_budget_applied;
+
+  // Items of the last expansion of each custom command, keyed by command body. A body without '$'
+  // always expands to itself, so its items are reused without substitution. Cleared (and
+  // 'commands_generation' increased) each time the command definitions change.
+  struct command_expansion {
+    gmic_image<char> text;
+    gmic_list<char> items;
+    bool is_constant;
+    command_expansion():is_constant(false) {}
+  };
+  std::map<const char*,command_expansion> commands_expansions;
+  unsigned int commands_generation;
+  bool is_expansion_cache; // Can be disabled to compare outputs against the uncached expansion
 };
 
 // Class 'gmic_exception'.
@@ -524,6 +557,47 @@ struct gmic_exception {
   }
 };
 
+// Class 'gmic_profiler'.
+//-----------------------
+// Accumulates call counts, wall times and allocated image bytes per command, for the commands run
+// by an interpreter whose 'profiler' attribute points to it. Exclusive time of a custom command
+// excludes the time spent in the commands of its body. Commands run by threads of 'parallel'
+// (or by 'run()' in parallel math expressions) are accounted for in the calling command.
+struct gmic_profiler {
+  struct command_stats {
+    unsigned long long calls, allocated_bytes;
+    double inclusive_ms, exclusive_ms;
+    bool is_custom;
+    command_stats():calls(0),allocated_bytes(0),inclusive_ms(0),exclusive_ms(0),is_custom(false) {}
+  };
+
+  std::map<std::string,command_stats> stats;
+
+  void clear() { stats.clear(); frames.clear(); }
+
+  // Return statistics sorted by decreasing exclusive time.
+  std::vector<std::pair<std::string,command_stats> > sorted() const;
+
+  // Called by the interpreter.
+  void enter_run(const unsigned long long image_bytes);
+  void leave_run(const unsigned long long image_bytes);
+  void begin_command(const char *const name, const bool is_custom, const unsigned long long image_bytes);
+
+private:
+  struct frame {
+    std::string name;
+    double start, command_start, child_ms;
+    unsigned long long command_bytes;
+    bool is_open, is_custom;
+    frame():start(0),command_start(0),child_ms(0),command_bytes(0),is_open(false),is_custom(false) {}
+  };
+  void end_command(frame& f, const double now, const unsigned long long image_bytes);
+  static double now_ms() {
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  std::vector<frame> frames;
+};
+
 // Explicit declarations of functions.
 //-------------------------------------
 inline bool *gmic_current_is_abort() {
@@ -285,6 +285,7 @@ DEPENDPATH += $$PWD/src \
 HEADERS +=  \
   src/ClickableLabel.h \
   src/Common.h \
+  src/CompactImage.h \
   src/FilterParameters/CustomSpinBox.h \
   src/GmicQt.h \
   src/Host/GmicQtHost.h \
@@ -305,6 +306,7 @@ HEADERS +=  \
   src/FilterParameters/LinkParameter.h \
   src/FilterParameters/MultilineTextParameterWidget.h \
   src/FilterParameters/NoteParameter.h \
+  src/FilterParameters/ParameterPool.h \
   src/FilterParameters/PointParameter.h \
   src/FilterParameters/SeparatorParameter.h \
   src/FilterParameters/TextParameter.h \
@@ -329,6 +331,7 @@ HEADERS +=  \
   src/HeadlessProcessor.h \
   src/HtmlTranslator.h \
   src/IconLoader.h \
+  src/ImageBufferPool.h \
   src/ImageTools.h \
   src/InputOutputState.h \
   src/KeypointList.h \
@@ -336,13 +339,19 @@ HEADERS +=  \
   src/Logger.h \
   src/LanguageSettings.h \
   src/MainWindow.h \
+  src/MemoryEstimator.h \
   src/Misc.h \
   src/ParametersCache.h \
+  src/PerformanceStats.h \
   src/PersistentMemory.h \
+  src/PreviewScaleController.h \
+  src/ResourceUsage.h \
   src/Settings.h \
   src/SourcesWidget.h \
+  src/StartupTasks.h \
   src/Tags.h \
-  src/TimeLogger.h \
+  src/ThreadBudget.h \
+  src/Tracer.h \
   src/Updater.h \
   src/Utils.h \
   src/Widgets/VisibleTagSelector.h \
@@ -360,6 +369,7 @@ HEADERS +=  \
   src/Widgets/ZoomLevelSelector.h \
   src/Widgets/SearchFieldWidget.h \
   src/Widgets/LanguageSelectionWidget.h \
+  src/Widgets/PerformancePanel.h \
   src/Widgets/ProgressInfoWindow.h
 
 HEADERS += $$GMIC_PATH/gmic.h
@@ -367,6 +377,7 @@ HEADERS += $$GMIC_PATH/gmic.h
 SOURCES += \
   src/ClickableLabel.cpp \
   src/Common.cpp \
+  src/CompactImage.cpp \
   src/FilterParameters/CustomSpinBox.cpp \
   src/GmicQt.cpp \
   src/OverrideCursor.cpp \
@@ -386,6 +397,7 @@ SOURCES += \
   src/FilterParameters/LinkParameter.cpp \
   src/FilterParameters/MultilineTextParameterWidget.cpp \
   src/FilterParameters/NoteParameter.cpp \
+  src/FilterParameters/ParameterPool.cpp \
   src/FilterParameters/PointParameter.cpp \
   src/FilterParameters/SeparatorParameter.cpp \
   src/FilterParameters/TextParameter.cpp \
@@ -410,6 +422,7 @@ SOURCES += \
   src/HeadlessProcessor.cpp \
   src/HtmlTranslator.cpp \
   src/IconLoader.cpp \
+  src/ImageBufferPool.cpp \
   src/ImageTools.cpp \
   src/InputOutputState.cpp \
   src/KeypointList.cpp \
@@ -417,12 +430,18 @@ SOURCES += \
   src/LanguageSettings.cpp \
   src/Logger.cpp \
   src/MainWindow.cpp \
+  src/MemoryEstimator.cpp \
   src/ParametersCache.cpp \
+  src/PerformanceStats.cpp \
   src/PersistentMemory.cpp \
+  src/PreviewScaleController.cpp \
+  src/ResourceUsage.cpp \
   src/Settings.cpp \
   src/SourcesWidget.cpp \
+  src/StartupTasks.cpp \
   src/Tags.cpp \
-  src/TimeLogger.cpp \
+  src/ThreadBudget.cpp \
+  src/Tracer.cpp \
   src/Updater.cpp \
   src/Utils.cpp \
   src/Misc.cpp \
@@ -440,6 +459,7 @@ SOURCES += \
   src/Widgets/ZoomLevelSelector.cpp \
   src/Widgets/SearchFieldWidget.cpp \
   src/Widgets/LanguageSelectionWidget.cpp \
+  src/Widgets/PerformancePanel.cpp \
   src/Widgets/ProgressInfoWindow.cpp
 
 equals(GMIC_DYNAMIC_LINKING, "on" )|equals(GMIC_DYNAMIC_LINKING, "ON" ) {
@@ -28,7 +28,7 @@
 #include <QTime>
 #include <QtGlobal>
 #include <iostream>
-#include "TimeLogger.h"
+#include "Tracer.h"
 
 #ifdef _GMIC_QT_DEBUG_
 #define DEBUG_QTIMESTAMP QTime::currentTime().toString("[hh:mm:ss]")
@@ -62,13 +62,9 @@
 
 template <typename T> inline void unused(const T &, ...) {}
 
-#ifdef _TIMING_ENABLED_
-#define TIMING GmicQt::TimeLogger::getInstance()->step(__PRETTY_FUNCTION__, __LINE__, __FILE__)
-#else
 #define TIMING                                                                                                                                                                                         \
-  if (false)                                                                                                                                                                                           \
-  std::cout << ""
-#endif
+  if (GmicQt::Tracer::isEnabled())                                                                                                                                                                     \
+  GmicQt::Tracer::instant(__PRETTY_FUNCTION__, "timing", QString("%1:%2").arg(__FILE__).arg(__LINE__))
 
 #define QT_VERSION_GTE(MAJOR, MINOR, PATCH) (QT_VERSION >= QT_VERSION_CHECK(MAJOR, MINOR, PATCH))
 
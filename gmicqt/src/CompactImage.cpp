@@ -0,0 +1,242 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file CompactImage.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "CompactImage.h"
+#include <cstring>
+#include "ImageBufferPool.h"
+#include "gmic.h"
+
+namespace
+{
+
+const float HalfMax = 65504.0f; // Largest finite half-float
+
+union FloatBits {
+  float f;
+  unsigned int u;
+};
+
+// Round to nearest even, overflows to infinity
+unsigned short floatToHalf(float value)
+{
+  FloatBits bits;
+  bits.f = value;
+  const unsigned int sign = bits.u & 0x80000000u;
+  unsigned int x = bits.u ^ sign;
+  unsigned short result;
+  if (x >= 0x47800000u) { // Infinity or NaN
+    result = (x > 0x7F800000u) ? 0x7E00 : 0x7C00;
+  } else if (x < 0x38800000u) { // Subnormal or zero
+    FloatBits magic;
+    magic.u = ((127 - 15) + (23 - 10) + 1) << 23;
+    FloatBits f;
+    f.u = x;
+    f.f += magic.f;
+    result = static_cast<unsigned short>(f.u - magic.u);
+  } else {
+    const unsigned int odd = (x >> 13) & 1u;
+    x += (static_cast<unsigned int>(15 - 127) << 23) + 0xFFFu + odd;
+    result = static_cast<unsigned short>(x >> 13);
+  }
+  return static_cast<unsigned short>(result | (sign >> 16));
+}
+
+float halfToFloat(unsigned short value)
+{
+  const unsigned int shiftedExponent = 0x7C00u << 13;
+  FloatBits magic;
+  magic.u = 113u << 23;
+  FloatBits result;
+  result.u = (value & 0x7FFFu) << 13;
+  const unsigned int exponent = shiftedExponent & result.u;
+  result.u += (127u - 15u) << 23;
+  if (exponent == shiftedExponent) { // Infinity or NaN
+    result.u += (128u - 16u) << 23;
+  } else if (exponent == 0) { // Subnormal or zero
+    result.u += 1u << 23;
+    result.f -= magic.f;
+  }
+  result.u |= static_cast<unsigned int>(value & 0x8000u) << 16;
+  return result.f;
+}
+
+const float * halfToFloatTable()
+{
+  static const std::vector<float> table = []() {
+    std::vector<float> values(65536);
+    for (unsigned int i = 0; i < 65536; ++i) {
+      values[i] = halfToFloat(static_cast<unsigned short>(i));
+    }
+    return values;
+  }();
+  return table.data();
+}
+
+} // namespace
+
+namespace GmicQt
+{
+
+CompactImage::CompactImage() : _pixelType(PixelType::None), _width(0), _height(0), _depth(0), _spectrum(0) {}
+
+void CompactImage::store(const gmic_library::gmic_image<float> & image, bool allowLossy)
+{
+  clear();
+  if (image.is_empty()) {
+    return;
+  }
+  _width = image.width();
+  _height = image.height();
+  _depth = image.depth();
+  _spectrum = image.spectrum();
+  const size_t size = image.size();
+  const float * data = image.data();
+
+  bool fitsUInt8 = true;
+  bool fitsUInt16 = true;
+  bool fitsHalf = allowLossy;
+  for (size_t i = 0; (i < size) && (fitsUInt16 || fitsHalf); ++i) {
+    const float value = data[i];
+    if (!(value >= 0.0f && value <= 65535.0f) || (value != static_cast<float>(static_cast<unsigned int>(value)))) {
+      fitsUInt8 = fitsUInt16 = false;
+    } else if (value > 255.0f) {
+      fitsUInt8 = false;
+    }
+    if (!(value >= -HalfMax && value <= HalfMax)) { // Also false for NaN
+      fitsHalf = false;
+    }
+  }
+
+  if (fitsUInt8) {
+    _pixelType = PixelType::UInt8;
+    _bytes.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      _bytes[i] = static_cast<unsigned char>(data[i]);
+    }
+  } else if (fitsUInt16) {
+    _pixelType = PixelType::UInt16;
+    _words.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      _words[i] = static_cast<unsigned short>(data[i]);
+    }
+  } else if (fitsHalf) {
+    _pixelType = PixelType::Half;
+    _words.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+      _words[i] = floatToHalf(data[i]);
+    }
+  } else {
+    _pixelType = PixelType::Float;
+    _floats.assign(data, data + size);
+  }
+}
+
+void CompactImage::expandTo(gmic_library::gmic_image<float> & image) const
+{
+  if (_pixelType == PixelType::None) {
+    ImageBufferPool::release(image);
+    return;
+  }
+  ImageBufferPool::assign(image, _width, _height, _depth, _spectrum);
+  float * data = image.data();
+  switch (_pixelType) {
+  case PixelType::UInt8:
+    for (size_t i = 0; i < _bytes.size(); ++i) {
+      data[i] = static_cast<float>(_bytes[i]);
+    }
+    break;
+  case PixelType::UInt16:
+    for (size_t i = 0; i < _words.size(); ++i) {
+      data[i] = static_cast<float>(_words[i]);
+    }
+    break;
+  case PixelType::Half: {
+    const float * table = halfToFloatTable();
+    for (size_t i = 0; i < _words.size(); ++i) {
+      data[i] = table[_words[i]];
+    }
+  } break;
+  case PixelType::Float:
+    std::memcpy(data, _floats.data(), _floats.size() * sizeof(float));
+    break;
+  case PixelType::None:
+    break;
+  }
+}
+
+void CompactImage::clear()
+{
+  _pixelType = PixelType::None;
+  _width = _height = _depth = _spectrum = 0;
+  std::vector<unsigned char>().swap(_bytes);
+  std::vector<unsigned short>().swap(_words);
+  std::vector<float>().swap(_floats);
+}
+
+bool CompactImage::isEmpty() const
+{
+  return _pixelType == PixelType::None;
+}
+
+int CompactImage::width() const
+{
+  return _width;
+}
+
+int CompactImage::height() const
+{
+  return _height;
+}
+
+CompactImage::PixelType CompactImage::pixelType() const
+{
+  return _pixelType;
+}
+
+size_t CompactImage::byteCount() const
+{
+  return _bytes.size() + _words.size() * sizeof(unsigned short) + _floats.size() * sizeof(float);
+}
+
+void CompactImage::storeList(const gmic_library::gmic_list<float> & images, std::vector<CompactImage> & compactImages, bool allowLossy)
+{
+  compactImages.clear();
+  compactImages.resize(images.size());
+  for (unsigned int i = 0; i < images.size(); ++i) {
+    compactImages[i].store(images[i], allowLossy);
+  }
+}
+
+void CompactImage::expandList(const std::vector<CompactImage> & compactImages, gmic_library::gmic_list<float> & images)
+{
+  if (images.size() != compactImages.size()) {
+    ImageBufferPool::release(images);
+    images.assign(static_cast<unsigned int>(compactImages.size()));
+  }
+  for (unsigned int i = 0; i < images.size(); ++i) {
+    compactImages[i].expandTo(images[i]);
+  }
+}
+
+} // namespace GmicQt
@@ -0,0 +1,93 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file CompactImage.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_COMPACTIMAGE_H
+#define GMIC_QT_COMPACTIMAGE_H
+
+#include <cstddef>
+#include <vector>
+#include "GmicQt.h"
+
+namespace gmic_library
+{
+template <typename T> struct gmic_image;
+template <typename T> struct gmic_list;
+} // namespace gmic_library
+
+namespace GmicQt
+{
+
+/**
+ * Image stored with the smallest pixel type able to hold its values.
+ *
+ * Images with integer values in [0,255] (resp. [0,65535]) are stored as
+ * 8-bit (resp. 16-bit) unsigned integers, i.e. the native depth of most host
+ * layers. Other images are stored as half-floats if a lossy storage is
+ * allowed and all values are finite and within the half-float range (e.g.
+ * 8 or 16-bit host data after scaling), as floats otherwise (e.g. HDR data).
+ */
+class CompactImage {
+public:
+  enum class PixelType
+  {
+    None,
+    UInt8,
+    UInt16,
+    Half,
+    Float
+  };
+  CompactImage();
+
+  void store(const gmic_library::gmic_image<float> & image, bool allowLossy);
+
+  /**
+   * Assign a float image with the stored pixels (single pass conversion).
+   * The float buffer is taken from the ImageBufferPool.
+   */
+  void expandTo(gmic_library::gmic_image<float> & image) const;
+
+  void clear();
+  bool isEmpty() const;
+  int width() const;
+  int height() const;
+  PixelType pixelType() const;
+  size_t byteCount() const;
+
+  static void storeList(const gmic_library::gmic_list<float> & images, std::vector<CompactImage> & compactImages, bool allowLossy);
+  static void expandList(const std::vector<CompactImage> & compactImages, gmic_library::gmic_list<float> & images);
+
+private:
+  PixelType _pixelType;
+  int _width;
+  int _height;
+  int _depth;
+  int _spectrum;
+  std::vector<unsigned char> _bytes;
+  std::vector<unsigned short> _words; // UInt16 or Half
+  std::vector<float> _floats;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_COMPACTIMAGE_H
@@ -27,6 +27,7 @@
 #include <QDebug>
 #include "Common.h"
 #include "Host/GmicQtHost.h"
+#include "PerformanceStats.h"
 #include "gmic.h"
 
 namespace GmicQt
@@ -36,27 +37,32 @@ double CroppedActiveLayerProxy::_x = -1.0;
 double CroppedActiveLayerProxy::_y = -1.0;
 double CroppedActiveLayerProxy::_width = -1.0;
 double CroppedActiveLayerProxy::_height = -1.0;
-std::unique_ptr<gmic_library::gmic_image<gmic_pixel_type>> CroppedActiveLayerProxy::_cachedImage(new gmic_library::gmic_image<gmic_pixel_type>);
+CompactImage CroppedActiveLayerProxy::_cachedImage;
 
 void CroppedActiveLayerProxy::get(gmic_library::gmic_image<gmic_pixel_type> & image, double x, double y, double width, double height)
 {
-  if ((x != _x) || (y != _y) || (width != _width) || (height != _height)) {
+  const bool hit = (x == _x) && (y == _y) && (width == _width) && (height == _height);
+  PerformanceStats::recordCacheAccess(PerformanceStats::Cache::ActiveLayer, hit);
+  if (!hit) {
     update(x, y, width, height);
   }
-  image = *_cachedImage;
+  TRACE_SPAN("Layer expansion", "conversion");
+  _cachedImage.expandTo(image);
 }
 
 QSize CroppedActiveLayerProxy::getSize(double x, double y, double width, double height)
 {
-  if ((x != _x) || (y != _y) || (width != _width) || (height != _height)) {
+  const bool hit = (x == _x) && (y == _y) && (width == _width) && (height == _height);
+  PerformanceStats::recordCacheAccess(PerformanceStats::Cache::ActiveLayer, hit);
+  if (!hit) {
     update(x, y, width, height);
   }
-  return QSize(_cachedImage->width(), _cachedImage->height());
+  return QSize(_cachedImage.width(), _cachedImage.height());
 }
 
 void CroppedActiveLayerProxy::clear()
 {
-  _cachedImage->assign();
+  _cachedImage.clear();
   _x = _y = _width = _height = -1.0;
 }
 
@@ -69,10 +75,15 @@ void CroppedActiveLayerProxy::update(double x, double y, double width, double he
 
   gmic_library::gmic_list<gmic_pixel_type> images;
   gmic_library::gmic_list<char> imageNames;
-  GmicQtHost::getCroppedImages(images, imageNames, _x, _y, _width, _height, InputMode::Active);
+  {
+    TRACE_SPAN("Host fetch", "fetch");
+    GmicQtHost::getCroppedImages(images, imageNames, _x, _y, _width, _height, InputMode::Active);
+  }
   if (images.size() > 0) {
+    TRACE_SPAN("Colour profile", "calibration");
     GmicQtHost::applyColorProfile(images.front());
-    _cachedImage->swap(images.front());
+    // Only used for display, hence may be stored with a loss of precision
+    _cachedImage.store(images.front(), true);
   } else {
     clear();
   }
@@ -26,7 +26,7 @@
 #define GMIC_QT_CROPPEDACTIVELAYERPROXY_H
 
 #include <QSize>
-#include <memory>
+#include "CompactImage.h"
 #include "GmicQt.h"
 
 namespace gmic_library
@@ -47,7 +47,7 @@ public:
 
 private:
   static void update(double x, double y, double width, double height);
-  static std::unique_ptr<gmic_library::gmic_image<float>> _cachedImage;
+  static CompactImage _cachedImage; // Compact storage, expanded to float by get()
   static double _x;
   static double _y;
   static double _width;
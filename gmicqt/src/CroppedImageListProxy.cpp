@@ -28,6 +28,7 @@
 #include <cmath>
 #include "Common.h"
 #include "Host/GmicQtHost.h"
+#include "PerformanceStats.h"
 #include "gmic.h"
 
 namespace GmicQt
@@ -39,19 +40,29 @@ double CroppedImageListProxy::_width = -1.0;
 double CroppedImageListProxy::_height = -1.0;
 double CroppedImageListProxy::_zoom = 0.0;
 InputMode CroppedImageListProxy::_inputMode = InputMode::Unspecified;
-std::unique_ptr<gmic_library::gmic_list<gmic_pixel_type>> CroppedImageListProxy::_cachedImageList(new gmic_library::gmic_list<gmic_pixel_type>);
+std::vector<CompactImage> CroppedImageListProxy::_cachedImages;
 std::unique_ptr<gmic_library::gmic_list<char>> CroppedImageListProxy::_cachedImageNames(new gmic_library::gmic_list<char>);
 
 void CroppedImageListProxy::get(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames,
                                 double x, double y, double width, double height, InputMode mode, double zoom)
 {
-  if ((x != _x) || (y != _y) || (width != _width) || (height != _height) || (mode != _inputMode) || (zoom != _zoom)) {
+  const bool hit = isCached(x, y, width, height, mode, zoom);
+  PerformanceStats::recordCacheAccess(PerformanceStats::Cache::CroppedImages, hit);
+  if (!hit) {
     update(x, y, width, height, mode, zoom);
   }
-  images = *_cachedImageList;
+  {
+    TRACE_SPAN("Input expansion", "conversion");
+    CompactImage::expandList(_cachedImages, images);
+  }
   imageNames = *_cachedImageNames;
 }
 
+bool CroppedImageListProxy::isCached(double x, double y, double width, double height, InputMode mode, double zoom)
+{
+  return (x == _x) && (y == _y) && (width == _width) && (height == _height) && (mode == _inputMode) && (zoom == _zoom);
+}
+
 void CroppedImageListProxy::update(double x, double y, double width, double height, InputMode mode, double zoom)
 {
   _x = x;
@@ -60,18 +71,27 @@ void CroppedImageListProxy::update(double x, double y, double width, double heig
   _height = height;
   _inputMode = mode;
   _zoom = zoom;
-  GmicQtHost::getCroppedImages(*_cachedImageList, *_cachedImageNames, _x, _y, _width, _height, _inputMode);
+  _cachedImages.clear();
+  gmic_library::gmic_list<gmic_pixel_type> images;
+  {
+    TRACE_SPAN("Host fetch", "fetch");
+    GmicQtHost::getCroppedImages(images, *_cachedImageNames, _x, _y, _width, _height, _inputMode);
+  }
   if (zoom < 1.0) {
-    for (unsigned int i = 0; i < _cachedImageList->size(); ++i) {
-      gmic_image<float> & image = (*_cachedImageList)[i];
+    TRACE_SPAN("Input downscale", "conversion");
+    for (unsigned int i = 0; i < images.size(); ++i) {
+      gmic_image<float> & image = images[i];
       image.resize(std::round(image.width() * zoom), std::round(image.height() * zoom), 1, -100, 1);
     }
   }
+  // Downscaled images are only used for previews, hence may be stored with a loss of precision
+  TRACE_SPAN("Compact storage", "conversion");
+  CompactImage::storeList(images, _cachedImages, zoom < 1.0);
 }
 
 void CroppedImageListProxy::clear()
 {
-  _cachedImageList->assign();
+  _cachedImages.clear();
   _cachedImageNames->assign();
   _x = _y = _width = _height = -1.0;
   _inputMode = InputMode::Unspecified;
@@ -26,6 +26,8 @@
 #define GMIC_QT_CROPPEDIMAGELISTPROXY_H
 
 #include <memory>
+#include <vector>
+#include "CompactImage.h"
 #include "GmicQt.h"
 
 namespace gmic_library
@@ -43,10 +45,11 @@ public:
 
   static void get(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames, double x, double y, double width, double height, InputMode mode, double zoom);
   static void update(double x, double y, double width, double height, InputMode mode, double zoom);
+  static bool isCached(double x, double y, double width, double height, InputMode mode, double zoom); // get() would not fetch from the host
   static void clear();
 
 private:
-  static std::unique_ptr<gmic_library::gmic_list<float>> _cachedImageList;
+  static std::vector<CompactImage> _cachedImages; // Compact storage, expanded to float by get()
   static std::unique_ptr<gmic_library::gmic_list<char>> _cachedImageNames;
   static double _x;
   static double _y;
@@ -78,6 +78,10 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
   }
 
   ui->sbPreviewTimeout->setRange(0, 999);
+  ui->sbPreviewLatency->setRange(0, 5000);
+  ui->sbPreviewLatency->setSingleStep(50);
+  ui->sbPreviewLatency->setSpecialValueText(tr("Off"));
+  ui->sbPreviewLatency->setToolTip(tr("Slow previews are computed at a lower resolution while parameters change, then at full resolution"));
 
   ui->rbLeftPreview->setChecked(Settings::previewPosition() == MainWindow::PreviewPosition::Left);
   ui->rbRightPreview->setChecked(Settings::previewPosition() == MainWindow::PreviewPosition::Right);
@@ -97,8 +101,11 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
   ui->cbShowLogos->setVisible(false);
 #endif
   ui->sbPreviewTimeout->setValue(Settings::previewTimeout());
+  ui->sbPreviewLatency->setValue(Settings::previewLatencyTarget());
   ui->cbPreviewZoom->setChecked(Settings::previewZoomAlwaysEnabled());
   ui->cbNotifyFailedUpdate->setChecked(Settings::notifyFailedStartupUpdate());
+  ui->cbPerformancePanel->setChecked(Settings::performancePanelEnabled());
+  ui->cbPerformancePanel->setToolTip(tr("Show time spent in each processing stage, memory usage and cache statistics"));
 
   connect(ui->pbOk, &QPushButton::clicked, this, &DialogSettings::onOk);
   connect(ui->rbLeftPreview, &QRadioButton::toggled, this, &DialogSettings::onRadioLeftPreviewToggled);
@@ -115,8 +122,10 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
   connect(ui->cbShowLogos, &QCheckBox::toggled, this, &DialogSettings::onVisibleLogosToggled);
   connect(ui->cbPreviewZoom, &QCheckBox::toggled, this, &DialogSettings::onPreviewZoomToggled);
   connect(ui->sbPreviewTimeout, QOverload<int>::of(&QSpinBox::valueChanged), this, &DialogSettings::onPreviewTimeoutChange);
+  connect(ui->sbPreviewLatency, QOverload<int>::of(&QSpinBox::valueChanged), this, &DialogSettings::onPreviewLatencyChange);
   connect(ui->outputMessages, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &DialogSettings::onOutputMessageModeChanged);
   connect(ui->cbNotifyFailedUpdate, &QCheckBox::toggled, this, &DialogSettings::onNotifyStartupUpdateFailedToggle);
+  connect(ui->cbPerformancePanel, &QCheckBox::toggled, this, &DialogSettings::onPerformancePanelToggled);
 
 #ifndef _GMIC_QT_DISABLE_HDPI_
 #if QT_VERSION_GTE(6, 0, 0)
@@ -149,6 +158,7 @@ DialogSettings::DialogSettings(QWidget * parent) : QDialog(parent), ui(new Ui::D
     ui->rbRightPreview->setPalette(p);
     ui->cbShowLogos->setPalette(p);
     ui->cbNotifyFailedUpdate->setPalette(p);
+    ui->cbPerformancePanel->setPalette(p);
     ui->cbHighDPI->setPalette(p);
   }
 #endif
@@ -189,6 +199,11 @@ void DialogSettings::onPreviewTimeoutChange(int value)
   Settings::setPreviewTimeout(value);
 }
 
+void DialogSettings::onPreviewLatencyChange(int value)
+{
+  Settings::setPreviewLatencyTarget(value);
+}
+
 void DialogSettings::onOutputMessageModeChanged(int)
 {
   const OutputMessageMode mode = static_cast<OutputMessageMode>(ui->outputMessages->currentData().toInt());
@@ -211,6 +226,11 @@ void DialogSettings::onHighDPIToggled(bool on)
   Settings::setHighDPIEnabled(on);
 }
 
+void DialogSettings::onPerformancePanelToggled(bool on)
+{
+  Settings::setPerformancePanelEnabled(on);
+}
+
 void DialogSettings::enableUpdateButton()
 {
   ui->pbUpdate->setEnabled(true);
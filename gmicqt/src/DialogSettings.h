@@ -57,10 +57,12 @@ public slots:
   void done(int r) override;
   void onVisibleLogosToggled(bool);
   void onPreviewTimeoutChange(int);
+  void onPreviewLatencyChange(int);
   void onOutputMessageModeChanged(int);
   void onPreviewZoomToggled(bool);
   void onNotifyStartupUpdateFailedToggle(bool);
   void onHighDPIToggled(bool);
+  void onPerformancePanelToggled(bool);
 
 private:
   Ui::DialogSettings * ui;
@@ -40,6 +40,7 @@
 #include "FilterParameters/IntParameter.h"
 #include "FilterParameters/LinkParameter.h"
 #include "FilterParameters/NoteParameter.h"
+#include "FilterParameters/ParameterPool.h"
 #include "FilterParameters/PointParameter.h"
 #include "FilterParameters/SeparatorParameter.h"
 #include "FilterParameters/TextParameter.h"
@@ -86,43 +87,61 @@ void AbstractParameter::addToKeypointList(KeypointList &) const {}
 
 void AbstractParameter::extractPositionFromKeypointList(KeypointList &) {}
 
-AbstractParameter * AbstractParameter::createFromText(const QString & filterName, const char * text, int & length, QString & error, QObject * parent)
+namespace
+{
+template <typename T> AbstractParameter * newParameter(QObject * parent, ParameterPool * pool)
+{
+  AbstractParameter * parameter = pool ? pool->take(T::staticMetaObject) : nullptr;
+  if (parameter) {
+    parameter->setParent(parent);
+    return parameter;
+  }
+  return new T(parent);
+}
+} // namespace
+
+AbstractParameter * AbstractParameter::createFromText(const QString & filterName, const char * text, int & length, QString & error, QObject * parent, ParameterPool * pool)
 {
   AbstractParameter * result = nullptr;
   QString line = text;
   error.clear();
 
-#define IS_OF_TYPE(ptype) QRegularExpression("^[^=]*\\s*=\\s*[_~]{0,2}" ptype, QRegularExpression::CaseInsensitiveOption).match(line).hasMatch()
+  // Type names only contain letters, so matching the word following '=' is
+  // equivalent to matching each type name with its own expression.
+  static const QRegularExpression typeWordRegExp("^[^=]*\\s*=\\s*[_~]{0,2}([a-z]*)", QRegularExpression::CaseInsensitiveOption);
+  const QString typeWord = typeWordRegExp.match(line).captured(1);
+#define IS_OF_TYPE(ptype) typeWord.startsWith(ptype, Qt::CaseInsensitive)
 
   if (IS_OF_TYPE("int")) {
-    result = new IntParameter(parent);
+    result = newParameter<IntParameter>(parent, pool);
   } else if (IS_OF_TYPE("float")) {
-    result = new FloatParameter(parent);
+    result = newParameter<FloatParameter>(parent, pool);
   } else if (IS_OF_TYPE("bool")) {
-    result = new BoolParameter(parent);
+    result = newParameter<BoolParameter>(parent, pool);
   } else if (IS_OF_TYPE("choice")) {
-    result = new ChoiceParameter(parent);
+    result = newParameter<ChoiceParameter>(parent, pool);
   } else if (IS_OF_TYPE("color")) {
-    result = new ColorParameter(parent);
+    result = newParameter<ColorParameter>(parent, pool);
   } else if (IS_OF_TYPE("separator")) {
-    result = new SeparatorParameter(parent);
+    result = newParameter<SeparatorParameter>(parent, pool);
   } else if (IS_OF_TYPE("note")) {
-    result = new NoteParameter(parent);
+    result = newParameter<NoteParameter>(parent, pool);
   } else if (IS_OF_TYPE("file") || IS_OF_TYPE("filein") || IS_OF_TYPE("fileout")) {
-    result = new FileParameter(parent);
+    result = newParameter<FileParameter>(parent, pool);
   } else if (IS_OF_TYPE("folder")) {
-    result = new FolderParameter(parent);
+    result = newParameter<FolderParameter>(parent, pool);
   } else if (IS_OF_TYPE("text")) {
-    result = new TextParameter(parent);
+    result = newParameter<TextParameter>(parent, pool);
   } else if (IS_OF_TYPE("link")) {
-    result = new LinkParameter(parent);
+    result = newParameter<LinkParameter>(parent, pool);
   } else if (IS_OF_TYPE("value")) {
-    result = new ConstParameter(parent);
+    result = newParameter<ConstParameter>(parent, pool);
   } else if (IS_OF_TYPE("button")) {
-    result = new ButtonParameter(parent);
+    result = newParameter<ButtonParameter>(parent, pool);
   } else if (IS_OF_TYPE("point")) {
-    result = new PointParameter(parent);
+    result = newParameter<PointParameter>(parent, pool);
   }
+#undef IS_OF_TYPE
   if (result) {
     if (!result->initFromText(filterName, text, length)) {
       delete result;
@@ -223,6 +242,28 @@ bool AbstractParameter::acceptRandom() const
   return _acceptRandom;
 }
 
+bool AbstractParameter::prepareForReuse()
+{
+  if (!releaseWidgets()) {
+    return false;
+  }
+  hideWidgets();
+  disconnect(this, &AbstractParameter::valueChanged, nullptr, nullptr);
+  _update = true;
+  _visibilityState = _defaultVisibilityState = VisibilityState::Visible;
+  _visibilityPropagation = VisibilityPropagation::NoPropagation;
+  _row = -1;
+  _grid = nullptr;
+  _acceptRandom = false;
+  return true;
+}
+
+bool AbstractParameter::releaseWidgets()
+{
+  // By default, widgets are not reused
+  return false;
+}
+
 void AbstractParameter::setTextSelectable(QLabel * label)
 {
   Qt::TextInteractionFlags flags = label->textInteractionFlags();
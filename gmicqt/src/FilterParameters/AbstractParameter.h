@@ -33,6 +33,7 @@ class QLabel;
 namespace GmicQt
 {
 class KeypointList;
+class ParameterPool;
 
 class AbstractParameter : public QObject {
   Q_OBJECT
@@ -54,7 +55,7 @@ public:
   virtual void addToKeypointList(KeypointList &) const;
   virtual void extractPositionFromKeypointList(KeypointList &);
 
-  static AbstractParameter * createFromText(const QString & filterName, const char * text, int & length, QString & error, QObject * parent);
+  static AbstractParameter * createFromText(const QString & filterName, const char * text, int & length, QString & error, QObject * parent, ParameterPool * pool = nullptr);
   virtual bool initFromText(const QString & filterName, const char * text, int & textLength) = 0;
 
   enum class VisibilityState
@@ -80,6 +81,7 @@ public:
   VisibilityState visibilityState() const;
   VisibilityPropagation visibilityPropagation() const;
   bool acceptRandom() const;
+  bool prepareForReuse();
 
 signals:
   void valueChanged();
@@ -89,6 +91,7 @@ protected:
   QStringList parseText(const QString & type, const char * text, int & length);
   bool matchType(const QString & type, const char * text) const;
   void notifyIfRelevant();
+  virtual bool releaseWidgets();
   VisibilityState _defaultVisibilityState;
   QGridLayout * _grid;
   int _row;
@@ -59,19 +59,26 @@ bool BoolParameter::addTo(QWidget * widget, int row)
   _grid = dynamic_cast<QGridLayout *>(widget->layout());
   Q_ASSERT_X(_grid, __PRETTY_FUNCTION__, "No grid layout in widget");
   _row = row;
-  delete _checkBox;
-  delete _label;
-  _checkBox = new QCheckBox(widget);
-  _checkBox->setChecked(_value);
-  _label = new QLabel(_name, widget);
+  if (_checkBox && (_checkBox->parentWidget() == widget)) {
+    // Recycled parameter, reconfigure its widgets
+    disconnectCheckBox();
+    _label->setText(_name);
+  } else {
+    delete _checkBox;
+    delete _label;
+    _connected = false;
+    _checkBox = new QCheckBox(widget);
+    _label = new QLabel(_name, widget);
 #ifndef _GMIC_QT_DISABLE_THEMING_
-  if (Settings::darkThemeEnabled()) {
-    QPalette p = _checkBox->palette();
-    p.setColor(QPalette::Text, Settings::CheckBoxTextColor);
-    p.setColor(QPalette::Base, Settings::CheckBoxBaseColor);
-    _checkBox->setPalette(p);
-  }
+    if (Settings::darkThemeEnabled()) {
+      QPalette p = _checkBox->palette();
+      p.setColor(QPalette::Text, Settings::CheckBoxTextColor);
+      p.setColor(QPalette::Base, Settings::CheckBoxBaseColor);
+      _checkBox->setPalette(p);
+    }
 #endif
+  }
+  _checkBox->setChecked(_value);
   _grid->addWidget(_label, row, 0, 1, 1);
   _grid->addWidget(_checkBox, row, 1, 1, 2);
   connectCheckBox();
@@ -120,6 +127,11 @@ void BoolParameter::onCheckBoxChanged(bool on)
   notifyIfRelevant();
 }
 
+bool BoolParameter::releaseWidgets()
+{
+  return true;
+}
+
 void BoolParameter::connectCheckBox()
 {
   if (_connected) {
@@ -49,6 +49,9 @@ public:
 public slots:
   void onCheckBoxChanged(bool);
 
+protected:
+  bool releaseWidgets() override;
+
 private:
   void connectCheckBox();
   void disconnectCheckBox();
@@ -55,15 +55,23 @@ bool ChoiceParameter::addTo(QWidget * widget, int row)
   _grid = dynamic_cast<QGridLayout *>(widget->layout());
   Q_ASSERT_X(_grid, __PRETTY_FUNCTION__, "No grid layout in widget");
   _row = row;
-  delete _comboBox;
-  delete _label;
-
-  _comboBox = new QComboBox(widget);
+  if (_comboBox && (_comboBox->parentWidget() == widget)) {
+    // Recycled parameter, reconfigure its widgets
+    disconnectComboBox();
+    _label->setText(_name);
+    _comboBox->clear();
+  } else {
+    delete _comboBox;
+    delete _label;
+    _connected = false;
+    _comboBox = new QComboBox(widget);
+    _label = new QLabel(_name, widget);
+    setTextSelectable(_label);
+  }
   _comboBox->addItems(_choices);
   _comboBox->setCurrentIndex(_value);
 
-  _grid->addWidget(_label = new QLabel(_name, widget), row, 0, 1, 1);
-  setTextSelectable(_label);
+  _grid->addWidget(_label, row, 0, 1, 1);
   _grid->addWidget(_comboBox, row, 1, 1, 2);
   connectComboBox();
   return true;
@@ -86,7 +94,7 @@ void ChoiceParameter::setValue(const QString & value)
   if (!ok || (k < 0)) {
     return;
   }
-  if (_comboBox && (k >= _comboBox->count())) {
+  if (_comboBox && (k >= _choices.size())) {
     return;
   }
   _value = k;
@@ -149,6 +157,11 @@ void ChoiceParameter::onComboBoxIndexChanged(int i)
   notifyIfRelevant();
 }
 
+bool ChoiceParameter::releaseWidgets()
+{
+  return true;
+}
+
 void ChoiceParameter::connectComboBox()
 {
   if (_connected) {
@@ -50,6 +50,9 @@ public:
 public slots:
   void onComboBoxIndexChanged(int);
 
+protected:
+  bool releaseWidgets() override;
+
 private:
   void connectComboBox();
   void disconnectComboBox();
@@ -24,8 +24,10 @@
  */
 #include "FilterParameters/CustomDoubleSpinBox.h"
 #include <QFontMetrics>
+#include <QHash>
 #include <QKeyEvent>
 #include <QLineEdit>
+#include <QPair>
 #include <QShowEvent>
 #include <QSizePolicy>
 #include <QString>
@@ -41,22 +43,36 @@ namespace GmicQt
 CustomDoubleSpinBox::CustomDoubleSpinBox(QWidget * parent, float min, float max) : QDoubleSpinBox(parent)
 {
   setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+  setBoundaries(min, max);
+  connect(this, &QDoubleSpinBox::editingFinished, [this]() { _unfinishedKeyboardEditing = false; });
+}
+
+CustomDoubleSpinBox::~CustomDoubleSpinBox() {}
+
+void CustomDoubleSpinBox::setBoundaries(float min, float max)
+{
   const int decimals = std::max(2, MAX_DIGITS - std::max(integerPartDigitCount(min), integerPartDigitCount(max)));
   setDecimals(decimals);
   setRange(min, max);
 
-  QDoubleSpinBox * dummy = new QDoubleSpinBox(this);
-  dummy->hide();
-  dummy->setRange(min, max);
-  dummy->setDecimals(decimals);
-  _sizeHint = dummy->sizeHint();
-  _minimumSizeHint = dummy->minimumSizeHint();
-  delete dummy;
-  connect(this, &QDoubleSpinBox::editingFinished, [this]() { _unfinishedKeyboardEditing = false; });
+  // Size hints only depend on the range and decimals, computing them with a
+  // dummy spin box is costly when many parameters are built at once.
+  static QHash<QString, QPair<QSize, QSize>> sizeHints;
+  const QString key = QString("%1 %2 %3").arg(double(min)).arg(double(max)).arg(decimals);
+  auto it = sizeHints.constFind(key);
+  if (it == sizeHints.constEnd()) {
+    QDoubleSpinBox * dummy = new QDoubleSpinBox(this);
+    dummy->hide();
+    dummy->setRange(min, max);
+    dummy->setDecimals(decimals);
+    it = sizeHints.insert(key, qMakePair(dummy->sizeHint(), dummy->minimumSizeHint()));
+    delete dummy;
+  }
+  _sizeHint = it.value().first;
+  _minimumSizeHint = it.value().second;
+  updateGeometry();
 }
 
-CustomDoubleSpinBox::~CustomDoubleSpinBox() {}
-
 QString CustomDoubleSpinBox::textFromValue(double value) const
 {
   QString text = QString::number(value, 'g', MAX_DIGITS);
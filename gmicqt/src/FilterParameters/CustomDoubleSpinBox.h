@@ -38,6 +38,7 @@ class CustomDoubleSpinBox : public QDoubleSpinBox {
 public:
   CustomDoubleSpinBox(QWidget * parent, float min, float max);
   ~CustomDoubleSpinBox() override;
+  void setBoundaries(float min, float max);
   QString textFromValue(double value) const override;
   inline bool unfinishedKeyboardEditing() const;
 
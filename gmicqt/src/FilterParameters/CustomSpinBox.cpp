@@ -24,8 +24,10 @@
  */
 #include "FilterParameters/CustomSpinBox.h"
 #include <QFontMetrics>
+#include <QHash>
 #include <QKeyEvent>
 #include <QLineEdit>
+#include <QPair>
 #include <QShowEvent>
 #include <QSizePolicy>
 #include <QString>
@@ -41,19 +43,32 @@ namespace GmicQt
 CustomSpinBox::CustomSpinBox(QWidget * parent, int min, int max) : QSpinBox(parent)
 {
   setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
-  setRange(min, max);
-
-  QSpinBox * dummy = new QSpinBox(this);
-  dummy->hide();
-  dummy->setRange(min, max);
-  _sizeHint = dummy->sizeHint();
-  _minimumSizeHint = dummy->minimumSizeHint();
-  delete dummy;
+  setBoundaries(min, max);
   connect(this, &QSpinBox::editingFinished, [this]() { _unfinishedKeyboardEditing = false; });
 }
 
 CustomSpinBox::~CustomSpinBox() {}
 
+void CustomSpinBox::setBoundaries(int min, int max)
+{
+  setRange(min, max);
+
+  // Size hints only depend on the range, see CustomDoubleSpinBox::setBoundaries()
+  static QHash<QPair<int, int>, QPair<QSize, QSize>> sizeHints;
+  const QPair<int, int> key(min, max);
+  auto it = sizeHints.constFind(key);
+  if (it == sizeHints.constEnd()) {
+    QSpinBox * dummy = new QSpinBox(this);
+    dummy->hide();
+    dummy->setRange(min, max);
+    it = sizeHints.insert(key, qMakePair(dummy->sizeHint(), dummy->minimumSizeHint()));
+    delete dummy;
+  }
+  _sizeHint = it.value().first;
+  _minimumSizeHint = it.value().second;
+  updateGeometry();
+}
+
 QString CustomSpinBox::textFromValue(int value) const
 {
   return QString::number(value);
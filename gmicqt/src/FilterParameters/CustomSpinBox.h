@@ -38,6 +38,7 @@ class CustomSpinBox : public QSpinBox {
 public:
   CustomSpinBox(QWidget * parent, int min, int max);
   ~CustomSpinBox() override;
+  void setBoundaries(int min, int max);
   QString textFromValue(int value) const override;
   inline bool unfinishedKeyboardEditing() const;
 
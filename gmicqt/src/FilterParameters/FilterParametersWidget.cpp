@@ -55,7 +55,8 @@ QVector<AbstractParameter *> FilterParametersWidget::buildParameters(const QStri
                                                                      QObject * parent,           //
                                                                      int * actualParameterCount, //
                                                                      bool * acceptRandom,        //
-                                                                     QString * error)
+                                                                     QString * error,            //
+                                                                     ParameterPool * pool)
 {
   QVector<AbstractParameter *> result;
   QByteArray rawText = parameters.toUtf8();
@@ -70,7 +71,7 @@ QVector<AbstractParameter *> FilterParametersWidget::buildParameters(const QStri
 
   AbstractParameter * parameter;
   do {
-    parameter = AbstractParameter::createFromText(filterName, cstr, length, localError, parent);
+    parameter = AbstractParameter::createFromText(filterName, cstr, length, localError, parent, pool);
     if (parameter) {
       result.push_back(parameter);
       if (parameter->isActualParameter()) {
@@ -85,7 +86,11 @@ QVector<AbstractParameter *> FilterParametersWidget::buildParameters(const QStri
 
   if (!localError.isEmpty()) {
     for (AbstractParameter * p : result) {
-      delete p;
+      if (pool) {
+        pool->recycle(p);
+      } else {
+        delete p;
+      }
     }
     result.clear();
     localError = QString("Parameter #%1\n%2").arg(localActualParameterCount + 1).arg(localError);
@@ -171,15 +176,13 @@ bool FilterParametersWidget::build(const QString & name, const QString & hash, c
   _filterHash = hash;
   hide();
   clear();
-  delete layout();
-  auto grid = new QGridLayout(this);
-  grid->setRowStretch(1, 2);
+  QGridLayout * grid = emptyGrid();
 
   PointParameter::resetDefaultColorIndex();
 
   // Build parameters and count actual ones
   QString error;
-  _parameters = buildParameters(_filterName, parameters, this, &_actualParametersCount, &_acceptRandom, &error);
+  _parameters = buildParameters(_filterName, parameters, this, &_actualParametersCount, &_acceptRandom, &error, &_parameterPool);
   _quotedParameters = quotedParameters(_parameters);
 
   // Restore saved values
@@ -265,9 +268,7 @@ bool FilterParametersWidget::build(const QString & name, const QString & hash, c
 void FilterParametersWidget::setNoFilter(const QString & message)
 {
   clear();
-  delete layout();
-  auto grid = new QGridLayout(this);
-  grid->setRowStretch(1, 2);
+  QGridLayout * grid = emptyGrid();
 
   if (message.isEmpty()) {
     _labelNoParams = new QLabel(tr("<i>Select a filter</i>"), this);
@@ -490,9 +491,10 @@ void FilterParametersWidget::updateValueStringAndNotify()
 
 void FilterParametersWidget::clear()
 {
+  // Parameters keep their widgets in the pool, to be reconfigured by the next filter
   QVector<AbstractParameter *>::iterator it = _parameters.begin();
   while (it != _parameters.end()) {
-    delete *it;
+    _parameterPool.recycle(*it);
     ++it;
   }
   _parameters.clear();
@@ -505,6 +507,25 @@ void FilterParametersWidget::clear()
   _paddingWidget = nullptr;
 }
 
+QGridLayout * FilterParametersWidget::emptyGrid()
+{
+  auto grid = dynamic_cast<QGridLayout *>(layout());
+  if (grid) {
+    // Reuse the layout, only dropping its items (widgets are owned elsewhere)
+    while (QLayoutItem * item = grid->takeAt(0)) {
+      delete item;
+    }
+    for (int row = 0; row < grid->rowCount(); ++row) {
+      grid->setRowStretch(row, 0);
+    }
+  } else {
+    delete layout();
+    grid = new QGridLayout(this);
+  }
+  grid->setRowStretch(1, 2);
+  return grid;
+}
+
 void FilterParametersWidget::applyDefaultVisibilityStates()
 {
   setVisibilityStates(defaultVisibilityStates()); // Will propagate
@@ -32,7 +32,9 @@
 #include <QStringList>
 #include <QVector>
 #include <QWidget>
+#include "FilterParameters/ParameterPool.h"
 #include "KeypointList.h"
+class QGridLayout;
 class QLabel;
 
 namespace GmicQt
@@ -87,13 +89,15 @@ private:
                                                       QObject * parent,           //
                                                       int * actualParameterCount, //
                                                       bool * acceptRandom,        //
-                                                      QString * error);
+                                                      QString * error,            //
+                                                      ParameterPool * pool = nullptr);
   static QStringList defaultParameterList(const QVector<AbstractParameter *> & parameters, QVector<bool> * quoted);
   static QVector<bool> quotedParameters(const QVector<AbstractParameter *> & parameters);
   static QVector<int> parameterSizes(const QVector<AbstractParameter *> & parameters);
 
 protected:
   void clear();
+  QGridLayout * emptyGrid();
   QVector<AbstractParameter *> _parameters;
   int _actualParametersCount;
   bool _acceptRandom;
@@ -104,6 +108,7 @@ protected:
   QString _filterHash;
   bool _hasKeypoints;
   QVector<bool> _quotedParameters;
+  ParameterPool _parameterPool;
 };
 
 } // namespace GmicQt
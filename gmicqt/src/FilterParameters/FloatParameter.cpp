@@ -66,34 +66,41 @@ bool FloatParameter::addTo(QWidget * widget, int row)
   _grid = dynamic_cast<QGridLayout *>(widget->layout());
   Q_ASSERT_X(_grid, __PRETTY_FUNCTION__, "No grid layout in widget");
   _row = row;
-  delete _spinBox;
-  delete _slider;
-  delete _label;
-  _slider = new QSlider(Qt::Horizontal, widget);
-  _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
-  _slider->setRange(0, SLIDER_MAX_RANGE);
-  _slider->setValue(static_cast<int>(SLIDER_MAX_RANGE * (_value - _min) / (_max - _min)));
+  if (_slider && (_slider->parentWidget() == widget)) {
+    // Recycled parameter, reconfigure its widgets
+    disconnectSliderSpinBox();
+    _label->setText(_name);
+    _spinBox->setBoundaries(_min, _max);
+  } else {
+    delete _spinBox;
+    delete _slider;
+    delete _label;
+    _connected = false;
+    _slider = new QSlider(Qt::Horizontal, widget);
+    _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
+    _slider->setRange(0, SLIDER_MAX_RANGE);
 #ifndef _GMIC_QT_DISABLE_THEMING_
-  if (Settings::darkThemeEnabled()) {
-    QPalette p = _slider->palette();
-    p.setColor(QPalette::Button, QColor(100, 100, 100));
-    p.setColor(QPalette::Highlight, QColor(130, 130, 130));
-    _slider->setPalette(p);
-  }
+    if (Settings::darkThemeEnabled()) {
+      QPalette p = _slider->palette();
+      p.setColor(QPalette::Button, QColor(100, 100, 100));
+      p.setColor(QPalette::Highlight, QColor(130, 130, 130));
+      _slider->setPalette(p);
+    }
 #endif
-
-  _spinBox = new CustomDoubleSpinBox(widget, _min, _max);
+    _spinBox = new CustomDoubleSpinBox(widget, _min, _max);
+    _label = new QLabel(_name, widget);
+    setTextSelectable(_label);
+    connect(_spinBox, &CustomDoubleSpinBox::editingFinished, [this]() { notifyIfRelevant(); });
+  }
+  _slider->setValue(static_cast<int>(SLIDER_MAX_RANGE * (_value - _min) / (_max - _min)));
   _spinBox->setSingleStep(double(_max - _min) / 100.0);
   _spinBox->setValue((double)_value);
-  _grid->addWidget(_label = new QLabel(_name, widget), row, 0, 1, 1);
-  setTextSelectable(_label);
+  _grid->addWidget(_label, row, 0, 1, 1);
   _grid->addWidget(_slider, row, 1, 1, 1);
   _grid->addWidget(_spinBox, row, 2, 1, 1);
 
   connectSliderSpinBox();
 
-  connect(_spinBox, &CustomDoubleSpinBox::editingFinished, [this]() { notifyIfRelevant(); });
-
   return true;
 }
 
@@ -181,6 +188,15 @@ void FloatParameter::timerEvent(QTimerEvent * event)
   }
 }
 
+bool FloatParameter::releaseWidgets()
+{
+  if (_timerId) {
+    killTimer(_timerId);
+    _timerId = 0;
+  }
+  return true;
+}
+
 void FloatParameter::onSliderMoved(int value)
 {
   const float fValue = _min + (float(value) / static_cast<float>(SLIDER_MAX_RANGE)) * (_max - _min);
@@ -50,6 +50,7 @@ public:
 
 protected:
   void timerEvent(QTimerEvent * event) override;
+  bool releaseWidgets() override;
 
 public slots:
   void onSliderMoved(int);
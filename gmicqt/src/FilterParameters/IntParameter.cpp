@@ -63,11 +63,31 @@ bool IntParameter::addTo(QWidget * widget, int row)
   _grid = dynamic_cast<QGridLayout *>(widget->layout());
   Q_ASSERT_X(_grid, __PRETTY_FUNCTION__, "No grid layout in widget");
   _row = row;
-  delete _spinBox;
-  delete _slider;
-  delete _label;
-  _slider = new QSlider(Qt::Horizontal, widget);
-  _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
+  if (_slider && (_slider->parentWidget() == widget)) {
+    // Recycled parameter, reconfigure its widgets
+    disconnectSliderSpinBox();
+    _label->setText(_name);
+    _spinBox->setBoundaries(_min, _max);
+  } else {
+    delete _spinBox;
+    delete _slider;
+    delete _label;
+    _connected = false;
+    _slider = new QSlider(Qt::Horizontal, widget);
+    _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
+    _spinBox = new CustomSpinBox(widget, _min, _max);
+#ifndef _GMIC_QT_DISABLE_THEMING_
+    if (Settings::darkThemeEnabled()) {
+      QPalette p = _slider->palette();
+      p.setColor(QPalette::Button, QColor(100, 100, 100));
+      p.setColor(QPalette::Highlight, QColor(130, 130, 130));
+      _slider->setPalette(p);
+    }
+#endif
+    _label = new QLabel(_name, widget);
+    setTextSelectable(_label);
+    connect(_spinBox, &CustomSpinBox::editingFinished, [this]() { notifyIfRelevant(); });
+  }
   _slider->setRange(_min, _max);
   _slider->setValue(_value);
 
@@ -79,22 +99,11 @@ bool IntParameter::addTo(QWidget * widget, int row)
     _slider->setPageStep(fact * (delta / fact) / 10);
   }
 
-  _spinBox = new CustomSpinBox(widget, _min, _max);
   _spinBox->setValue(_value);
-#ifndef _GMIC_QT_DISABLE_THEMING_
-  if (Settings::darkThemeEnabled()) {
-    QPalette p = _slider->palette();
-    p.setColor(QPalette::Button, QColor(100, 100, 100));
-    p.setColor(QPalette::Highlight, QColor(130, 130, 130));
-    _slider->setPalette(p);
-  }
-#endif
-  _grid->addWidget(_label = new QLabel(_name, widget), row, 0, 1, 1);
-  setTextSelectable(_label);
+  _grid->addWidget(_label, row, 0, 1, 1);
   _grid->addWidget(_slider, row, 1, 1, 1);
   _grid->addWidget(_spinBox, row, 2, 1, 1);
   connectSliderSpinBox();
-  connect(_spinBox, &CustomSpinBox::editingFinished, [this]() { notifyIfRelevant(); });
 
   return true;
 }
@@ -175,6 +184,15 @@ void IntParameter::timerEvent(QTimerEvent * e)
   }
 }
 
+bool IntParameter::releaseWidgets()
+{
+  if (_timerId) {
+    killTimer(_timerId);
+    _timerId = 0;
+  }
+  return true;
+}
+
 void IntParameter::onSliderMoved(int value)
 {
   if (value != _value) {
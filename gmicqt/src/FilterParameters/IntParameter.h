@@ -50,6 +50,7 @@ public:
 
 protected:
   void timerEvent(QTimerEvent *) override;
+  bool releaseWidgets() override;
 public slots:
   void onSliderMoved(int);
   void onSliderValueChanged(int value);
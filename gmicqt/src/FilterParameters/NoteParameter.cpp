@@ -52,13 +52,18 @@ bool NoteParameter::addTo(QWidget * widget, int row)
   _grid = dynamic_cast<QGridLayout *>(widget->layout());
   Q_ASSERT_X(_grid, __PRETTY_FUNCTION__, "No grid layout in widget");
   _row = row;
-  delete _label;
-  _label = new QLabel(_text, widget);
-  _label->setTextFormat(Qt::RichText);
-  _label->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
-  _label->setWordWrap(true);
-  setTextSelectable(_label);
-  connect(_label, &QLabel::linkActivated, this, &NoteParameter::onLinkActivated);
+  if (_label && (_label->parentWidget() == widget)) {
+    // Recycled parameter, only the text changes
+    _label->setText(_text);
+  } else {
+    delete _label;
+    _label = new QLabel(_text, widget);
+    _label->setTextFormat(Qt::RichText);
+    _label->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+    _label->setWordWrap(true);
+    setTextSelectable(_label);
+    connect(_label, &QLabel::linkActivated, this, &NoteParameter::onLinkActivated);
+  }
   _grid->addWidget(_label, row, 0, 1, 3);
   return true;
 }
@@ -77,6 +82,11 @@ void NoteParameter::setValue(const QString &) {}
 
 void NoteParameter::reset() {}
 
+bool NoteParameter::releaseWidgets()
+{
+  return true;
+}
+
 bool NoteParameter::initFromText(const QString & /* filterName */, const char * text, int & textLength)
 {
   QList<QString> list = parseText("note", text, textLength);
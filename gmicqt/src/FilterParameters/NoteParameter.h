@@ -46,6 +46,9 @@ public:
 public slots:
   void onLinkActivated(const QString & link);
 
+protected:
+  bool releaseWidgets() override;
+
 private:
   QLabel * _label;
   QString _text;
@@ -0,0 +1,80 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParameterPool.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FilterParameters/ParameterPool.h"
+#include <QMetaObject>
+#include "FilterParameters/AbstractParameter.h"
+
+namespace GmicQt
+{
+
+ParameterPool::~ParameterPool()
+{
+  clear();
+}
+
+void ParameterPool::recycle(AbstractParameter * parameter)
+{
+  if (!parameter) {
+    return;
+  }
+  QVector<AbstractParameter *> & parameters = _parameters[parameter->metaObject()];
+  if ((parameters.size() < MaxParametersPerType) && parameter->prepareForReuse()) {
+    parameters.push_back(parameter);
+  } else {
+    delete parameter;
+  }
+}
+
+AbstractParameter * ParameterPool::take(const QMetaObject & type)
+{
+  auto it = _parameters.find(&type);
+  if ((it == _parameters.end()) || it.value().isEmpty()) {
+    return nullptr;
+  }
+  AbstractParameter * parameter = it.value().back();
+  it.value().pop_back();
+  return parameter;
+}
+
+int ParameterPool::size() const
+{
+  int count = 0;
+  for (const QVector<AbstractParameter *> & parameters : _parameters) {
+    count += parameters.size();
+  }
+  return count;
+}
+
+void ParameterPool::clear()
+{
+  for (const QVector<AbstractParameter *> & parameters : _parameters) {
+    for (AbstractParameter * parameter : parameters) {
+      delete parameter;
+    }
+  }
+  _parameters.clear();
+}
+
+} // namespace GmicQt
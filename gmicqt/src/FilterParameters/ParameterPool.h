@@ -0,0 +1,60 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParameterPool.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_PARAMETERPOOL_H
+#define GMIC_QT_PARAMETERPOOL_H
+
+#include <QHash>
+#include <QVector>
+struct QMetaObject;
+
+namespace GmicQt
+{
+class AbstractParameter;
+
+/**
+ * Parameters released by a FilterParametersWidget, kept with their widgets so
+ * that the next filter reconfigures them instead of allocating new ones.
+ * Parameters are pooled by type; types which cannot reuse their widgets are
+ * simply deleted.
+ */
+class ParameterPool {
+public:
+  ParameterPool() = default;
+  ParameterPool(const ParameterPool &) = delete;
+  ParameterPool & operator=(const ParameterPool &) = delete;
+  ~ParameterPool();
+  void recycle(AbstractParameter * parameter);
+  AbstractParameter * take(const QMetaObject & type);
+  int size() const;
+  void clear();
+
+private:
+  static const int MaxParametersPerType = 64;
+  QHash<const QMetaObject *, QVector<AbstractParameter *>> _parameters;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_PARAMETERPOOL_H
@@ -49,20 +49,22 @@ bool SeparatorParameter::addTo(QWidget * widget, int row)
   _grid = dynamic_cast<QGridLayout *>(widget->layout());
   Q_ASSERT_X(_grid, __PRETTY_FUNCTION__, "No grid layout in widget");
   _row = row;
-  delete _frame;
-  _frame = new QFrame(widget);
-  QSizePolicy sizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
-  sizePolicy.setHorizontalStretch(0);
-  sizePolicy.setVerticalStretch(0);
-  sizePolicy.setHeightForWidth(_frame->sizePolicy().hasHeightForWidth());
-  _frame->setSizePolicy(sizePolicy);
-  _frame->setFrameShape(QFrame::HLine);
-  _frame->setFrameShadow(QFrame::Sunken);
+  if (!_frame || (_frame->parentWidget() != widget)) {
+    delete _frame;
+    _frame = new QFrame(widget);
+    QSizePolicy sizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+    sizePolicy.setHorizontalStretch(0);
+    sizePolicy.setVerticalStretch(0);
+    sizePolicy.setHeightForWidth(_frame->sizePolicy().hasHeightForWidth());
+    _frame->setSizePolicy(sizePolicy);
+    _frame->setFrameShape(QFrame::HLine);
+    _frame->setFrameShadow(QFrame::Sunken);
 #ifndef _GMIC_QT_DISABLE_THEMING_
-  if (Settings::darkThemeEnabled()) {
-    _frame->setStyleSheet("QFrame{ border-top: 0px none #a0a0a0; border-bottom: 2px solid rgb(160,160,160);}");
-  }
+    if (Settings::darkThemeEnabled()) {
+      _frame->setStyleSheet("QFrame{ border-top: 0px none #a0a0a0; border-bottom: 2px solid rgb(160,160,160);}");
+    }
 #endif
+  }
   _grid->addWidget(_frame, row, 0, 1, 3);
   return true;
 }
@@ -81,6 +83,11 @@ void SeparatorParameter::setValue(const QString &) {}
 
 void SeparatorParameter::reset() {}
 
+bool SeparatorParameter::releaseWidgets()
+{
+  return true;
+}
+
 bool SeparatorParameter::initFromText(const QString & /* filterName */, const char * text, int & textLength)
 {
   QStringList list = parseText("separator", text, textLength);
@@ -44,6 +44,9 @@ public:
   void reset() override;
   bool initFromText(const QString & filterName, const char * text, int & textLength) override;
 
+protected:
+  bool releaseWidgets() override;
+
 private:
   QFrame * _frame;
 };
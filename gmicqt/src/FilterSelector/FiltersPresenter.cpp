@@ -71,6 +71,7 @@ void FiltersPresenter::setFiltersView(FiltersView * filtersView)
   connect(_filtersView, &FiltersView::faveRemovalRequested, this, &FiltersPresenter::removeFave);
   connect(_filtersView, &FiltersView::faveAdditionRequested, this, &FiltersPresenter::faveAdditionRequested);
   connect(_filtersView, &FiltersView::tagToggled, this, &FiltersPresenter::onTagToggled);
+  connect(_filtersView, &FiltersView::filterHighlighted, this, &FiltersPresenter::filterHighlighted);
 }
 
 void FiltersPresenter::setSearchField(SearchFieldWidget * searchField)
@@ -595,53 +596,65 @@ bool FiltersPresenter::danglingFaveIsSelected() const
   return false;
 }
 
+bool FiltersPresenter::filterFromHash(const QString & hash, Filter & filter) const
+{
+  if (_favesModel.contains(hash)) {
+    const FavesModel::Fave & fave = _favesModel.getFaveFromHash(hash);
+    const QString & originalHash = fave.originalHash();
+    if (!_filtersModel.contains(originalHash)) {
+      return false;
+    }
+    const FiltersModel::Filter & original = _filtersModel.getFilterFromHash(originalHash);
+    filter.command = fave.command();
+    filter.defaultParameterValues = fave.defaultValues();
+    filter.defaultVisibilityStates = fave.defaultVisibilityStates();
+    filter.defaultInputMode = original.defaultInputMode();
+    filter.hash = hash;
+    filter.isAFave = true;
+    filter.name = fave.name();
+    filter.plainTextName = fave.plainText();
+    filter.fullPath = fave.absolutePath();
+    filter.parameters = original.parameters();
+    filter.previewCommand = fave.previewCommand();
+    filter.isAccurateIfZoomed = original.isAccurateIfZoomed();
+    filter.previewFromFullImage = original.previewFromFullImage();
+    filter.previewFactor = original.previewFactor();
+    return true;
+  }
+  if (_filtersModel.contains(hash)) {
+    const FiltersModel::Filter & original = _filtersModel.getFilterFromHash(hash);
+    filter.command = original.command();
+    filter.defaultParameterValues = ParametersCache::getValues(hash); // FIXME : Unused unless it's a fave. Should be renamed.
+    filter.defaultVisibilityStates = ParametersCache::getVisibilityStates(hash);
+    filter.defaultInputMode = original.defaultInputMode();
+    filter.hash = hash;
+    filter.isAFave = false;
+    filter.name = original.name();
+    filter.plainTextName = original.plainText();
+    filter.fullPath = original.absolutePathNoTags();
+    filter.parameters = original.parameters();
+    filter.previewCommand = original.previewCommand();
+    filter.isAccurateIfZoomed = original.isAccurateIfZoomed();
+    filter.previewFromFullImage = original.previewFromFullImage();
+    filter.previewFactor = original.previewFactor();
+    return true;
+  }
+  return false;
+}
+
 void FiltersPresenter::setCurrentFilter(const QString & hash)
 {
   _errorMessage.clear();
   PersistentMemory::clear();
   if (hash.isEmpty()) {
     _currentFilter.setInvalid();
-  } else if (_favesModel.contains(hash)) {
-    const FavesModel::Fave & fave = _favesModel.getFaveFromHash(hash);
-    const QString & originalHash = fave.originalHash();
-    if (_filtersModel.contains(originalHash)) {
-      const FiltersModel::Filter & filter = _filtersModel.getFilterFromHash(originalHash);
-      _currentFilter.command = fave.command();
-      _currentFilter.defaultParameterValues = fave.defaultValues();
-      _currentFilter.defaultVisibilityStates = fave.defaultVisibilityStates();
-      _currentFilter.defaultInputMode = filter.defaultInputMode();
-      _currentFilter.hash = hash;
-      _currentFilter.isAFave = true;
-      _currentFilter.name = fave.name();
-      _currentFilter.plainTextName = fave.plainText();
-      _currentFilter.fullPath = fave.absolutePath();
-      _currentFilter.parameters = filter.parameters();
-      _currentFilter.previewCommand = fave.previewCommand();
-      _currentFilter.isAccurateIfZoomed = filter.isAccurateIfZoomed();
-      _currentFilter.previewFromFullImage = filter.previewFromFullImage();
-      _currentFilter.previewFactor = filter.previewFactor();
-    } else {
+  } else if (!filterFromHash(hash, _currentFilter)) {
+    if (_favesModel.contains(hash)) {
       setInvalidFilter();
       _errorMessage = tr("Cannot find this fave's original filter\n");
+    } else {
+      _currentFilter.setInvalid();
     }
-  } else if (_filtersModel.contains(hash)) {
-    const FiltersModel::Filter & filter = _filtersModel.getFilterFromHash(hash);
-    _currentFilter.command = filter.command();
-    _currentFilter.defaultParameterValues = ParametersCache::getValues(hash); // FIXME : Unused unless it's a fave. Should be renamed.
-    _currentFilter.defaultVisibilityStates = ParametersCache::getVisibilityStates(hash);
-    _currentFilter.defaultInputMode = filter.defaultInputMode();
-    _currentFilter.hash = hash;
-    _currentFilter.isAFave = false;
-    _currentFilter.name = filter.name();
-    _currentFilter.plainTextName = filter.plainText();
-    _currentFilter.fullPath = filter.absolutePathNoTags();
-    _currentFilter.parameters = filter.parameters();
-    _currentFilter.previewCommand = filter.previewCommand();
-    _currentFilter.isAccurateIfZoomed = filter.isAccurateIfZoomed();
-    _currentFilter.previewFromFullImage = filter.previewFromFullImage();
-    _currentFilter.previewFactor = filter.previewFactor();
-  } else {
-    _currentFilter.setInvalid();
   }
 }
 
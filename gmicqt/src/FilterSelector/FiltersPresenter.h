@@ -102,6 +102,11 @@ public:
   void selectFilterFromCommand(const QString & command);
   void setVisibleTagSelector(VisibleTagSelector * selector);
   const Filter & currentFilter() const;
+  /**
+   * Description of a filter or fave, without selecting it.
+   * Return false if there is no such filter, or if the original filter of a fave is missing.
+   */
+  bool filterFromHash(const QString & hash, Filter & filter) const;
 
   void loadSettings(const QSettings & settings);
   void saveSettings(QSettings & settings);
@@ -128,6 +133,7 @@ signals:
   void filterSelectionChanged();
   void faveAdditionRequested(QString);
   void faveNameChanged(QString);
+  void filterHighlighted(QString hash);
 
 public slots:
   void setVisibleTagColors(unsigned int color);
@@ -60,6 +60,9 @@ FiltersView::FiltersView(QWidget * parent) : QWidget(parent), ui(new Ui::Filters
   connect(delegate, &FilterTreeItemDelegate::commitData, this, &FiltersView::onRenameFaveFinished);
   connect(ui->treeView, &TreeView::returnKeyPressed, this, &FiltersView::onReturnKeyPressedInFiltersTree);
   connect(ui->treeView, &TreeView::clicked, this, &FiltersView::onItemClicked);
+  ui->treeView->setMouseTracking(true);
+  connect(ui->treeView, &TreeView::entered, this, &FiltersView::onItemHighlighted);
+  connect(ui->treeView, &TreeView::currentIndexChanged, this, &FiltersView::onItemHighlighted);
   connect(&_model, &QStandardItemModel::itemChanged, this, &FiltersView::onItemChanged);
 
   ui->treeView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -485,6 +488,14 @@ void FiltersView::onItemClicked(QModelIndex index)
   updateIndexBeforeClick();
 }
 
+void FiltersView::onItemHighlighted(QModelIndex index)
+{
+  FilterTreeItem * item = filterTreeItemFromIndex(index);
+  if (item) {
+    emit filterHighlighted(item->hash());
+  }
+}
+
 void FiltersView::onItemChanged(QStandardItem * item)
 {
   if (!item->isCheckable()) {
@@ -90,6 +90,7 @@ public:
 
 signals:
   void filterSelected(QString hash);
+  void filterHighlighted(QString hash); // Hovered, or current item of keyboard navigation
   void faveRenamed(QString hash, QString newName);
   void faveRemovalRequested(QString hash);
   void faveAdditionRequested(QString hash);
@@ -106,6 +107,7 @@ private slots:
   void onRenameFaveFinished(QWidget * editor);
   void onReturnKeyPressedInFiltersTree();
   void onItemClicked(QModelIndex index);
+  void onItemHighlighted(QModelIndex index);
   void onItemChanged(QStandardItem * item);
   void onContextMenuRemoveFave();
   void onContextMenuRenameFave();
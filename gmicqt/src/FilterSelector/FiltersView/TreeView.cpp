@@ -38,6 +38,12 @@ void TreeView::keyPressEvent(QKeyEvent * event)
   QTreeView::keyPressEvent(event);
 }
 
+void TreeView::currentChanged(const QModelIndex & current, const QModelIndex & previous)
+{
+  QTreeView::currentChanged(current, previous);
+  emit currentIndexChanged(current);
+}
+
 TreeView::~TreeView() {}
 
 } // namespace GmicQt
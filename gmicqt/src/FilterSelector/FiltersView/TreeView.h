@@ -40,6 +40,10 @@ public:
   void keyPressEvent(QKeyEvent * event) override;
 signals:
   void returnKeyPressed();
+  void currentIndexChanged(QModelIndex index);
+
+protected:
+  void currentChanged(const QModelIndex & current, const QModelIndex & previous) override;
 
 private:
 };
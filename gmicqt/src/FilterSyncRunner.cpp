@@ -30,8 +30,10 @@
 #include "GmicStdlib.h"
 #include "Logger.h"
 #include "Misc.h"
+#include "PerformanceStats.h"
 #include "PersistentMemory.h"
 #include "Settings.h"
+#include "ThreadBudget.h"
 #include "gmic.h"
 
 namespace GmicQt
@@ -40,8 +42,7 @@ namespace GmicQt
 FilterSyncRunner::FilterSyncRunner(QObject * parent, const QString & command, const QString & arguments, const QString & environment)
     : QObject(parent), _command(command), _arguments(arguments), _environment(environment), //
       _images(new gmic_library::gmic_list<float>),                                          //
-      _imageNames(new gmic_library::gmic_list<char>),                                       //
-      _persistentMemoryOutput(new gmic_library::gmic_image<char>)
+      _imageNames(new gmic_library::gmic_list<char>)
 {
 #ifdef _IS_MACOS_
   static bool stackSize8MB = false;
@@ -59,7 +60,6 @@ FilterSyncRunner::~FilterSyncRunner()
 {
   delete _images;
   delete _imageNames;
-  delete _persistentMemoryOutput;
 }
 
 void FilterSyncRunner::setArguments(const QString & str)
@@ -77,6 +77,18 @@ void FilterSyncRunner::swapImages(gmic_library::gmic_list<float> & images)
   _images->swap(images);
 }
 
+void FilterSyncRunner::giveImages(gmic_library::gmic_list<float> & images)
+{
+  _images->assign();
+  _images->swap(images);
+}
+
+void FilterSyncRunner::takeImages(gmic_library::gmic_list<float> & images)
+{
+  images.assign();
+  images.swap(*_images);
+}
+
 void FilterSyncRunner::setInputImages(const gmic_library::gmic_list<float> & list)
 {
   *_images = list;
@@ -92,9 +104,9 @@ const gmic_library::gmic_list<char> & FilterSyncRunner::imageNames() const
   return *_imageNames;
 }
 
-gmic_library::gmic_image<char> & FilterSyncRunner::persistentMemoryOutput()
+const PersistentMemory::Buffer & FilterSyncRunner::persistentMemoryOutput() const
 {
-  return *_persistentMemoryOutput;
+  return _persistentMemoryOutput;
 }
 
 QStringList FilterSyncRunner::gmicStatus() const
@@ -139,6 +151,11 @@ void FilterSyncRunner::setLogSuffix(const QString & text)
   _logSuffix = text;
 }
 
+const RunResources & FilterSyncRunner::resources() const
+{
+  return _resources;
+}
+
 void FilterSyncRunner::abortGmic()
 {
   _gmicAbort = true;
@@ -146,6 +163,15 @@ void FilterSyncRunner::abortGmic()
 
 void FilterSyncRunner::run()
 {
+  TRACE_SPAN_NAMED(span, "Interpreter run", "gmic");
+#if cimg_use_openmp != 0
+  // Runs on the GUI thread, which must not keep the budget of this run
+  const int threadCount = omp_get_max_threads();
+#endif
+  ThreadBudget::Job budgetJob(ThreadBudget::Priority::Interactive);
+  budgetJob.start();
+  ResourceMeter meter;
+  meter.start(*_images);
   _errorMessage.clear();
   _failed = false;
   QString fullCommandLine;
@@ -156,19 +182,21 @@ void FilterSyncRunner::run()
     _gmicAbort = false;
     _gmicProgress = -1;
     Logger::log(fullCommandLine, _logSuffix, true);
+    span.setDetail(fullCommandLine);
     gmic gmicInstance(_environment.isEmpty() ? nullptr : QString("%1").arg(_environment).toLocal8Bit().constData(), GmicStdLib::Array.constData(), true, &_gmicProgress, &_gmicAbort, 0.0f);
-    if (PersistentMemory::image()) {
-      if (*PersistentMemory::image() == gmic_store) {
-        gmicInstance.set_variable("_persistent", PersistentMemory::image());
-      } else {
-        gmicInstance.set_variable("_persistent", '=', PersistentMemory::image());
-      }
+    // Kept alive until the end of the run, as the interpreter reads it without a copy
+    const PersistentMemory::Buffer persistentMemoryInput = PersistentMemory::buffer();
+    if (persistentMemoryInput) {
+      gmicInstance.share_variable("_persistent", *persistentMemoryInput);
     }
     gmicInstance.set_variable("_host", '=', GmicQtHost::ApplicationShortname);
     gmicInstance.set_variable("_tk", '=', "qt");
+    gmicInstance.thread_budget = budgetJob.budget();
     gmicInstance.run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames);
     _gmicStatus = QString::fromLocal8Bit(gmicInstance.status);
-    gmicInstance.get_variable("_persistent").move_to(*_persistentMemoryOutput);
+    gmic_library::gmic_image<char> persistentMemory;
+    gmicInstance.take_variable("_persistent", persistentMemory);
+    _persistentMemoryOutput = PersistentMemory::adopt(persistentMemory, persistentMemoryInput);
   } catch (gmic_exception & e) {
     _images->assign();
     _imageNames->assign();
@@ -177,6 +205,17 @@ void FilterSyncRunner::run()
     Logger::error(QString("When running command '%1', this error occurred:\n%2").arg(fullCommandLine).arg(message), true);
     _failed = true;
   }
+  _resources = meter.stop(*_images);
+  _resources.command = fullCommand().toStdString();
+  _resources.failed = _failed;
+  _resources.aborted = _gmicAbort;
+  _resources.concurrent = !budgetJob.ranAlone();
+  ResourceMeter::record(_resources, _logSuffix);
+  PerformanceStats::addImageBytes(_resources.inputBytes, _resources.outputBytes);
+  budgetJob.finish();
+#if cimg_use_openmp != 0
+  omp_set_num_threads(threadCount);
+#endif
 }
 
 } // namespace GmicQt
@@ -32,6 +32,8 @@
 #include "Common.h"
 #include "GmicQt.h"
 #include "Host/GmicQtHost.h"
+#include "PersistentMemory.h"
+#include "ResourceUsage.h"
 class QObject;
 
 namespace gmic_library
@@ -52,9 +54,17 @@ public:
   void setInputImages(const gmic_library::gmic_list<float> & list);
   void setImageNames(const gmic_library::gmic_list<char> & imageNames);
   void swapImages(gmic_library::gmic_list<float> & images);
+  /**
+   * Take ownership of the input images, leaving the argument empty (no copy).
+   */
+  void giveImages(gmic_library::gmic_list<float> & images);
+  /**
+   * Release ownership of the output images to the caller (no copy).
+   */
+  void takeImages(gmic_library::gmic_list<float> & images);
   const gmic_library::gmic_list<float> & images() const;
   const gmic_library::gmic_list<char> & imageNames() const;
-  gmic_library::gmic_image<char> & persistentMemoryOutput();
+  const PersistentMemory::Buffer & persistentMemoryOutput() const;
   QStringList gmicStatus() const;
   QList<int> parametersVisibilityStates() const;
   QString errorMessage() const;
@@ -63,6 +73,7 @@ public:
   float progress() const;
   QString fullCommand() const;
   void setLogSuffix(const QString & text);
+  const RunResources & resources() const;
   void run();
   void abortGmic();
 
@@ -72,7 +83,7 @@ private:
   QString _environment;
   gmic_library::gmic_list<float> * _images;
   gmic_library::gmic_list<char> * _imageNames;
-  gmic_library::gmic_image<char> * _persistentMemoryOutput;
+  PersistentMemory::Buffer _persistentMemoryOutput;
   bool _gmicAbort;
   bool _failed;
   QString _gmicStatus;
@@ -80,6 +91,7 @@ private:
   QString _errorMessage;
   QString _name;
   QString _logSuffix;
+  RunResources _resources;
 };
 
 } // namespace GmicQt
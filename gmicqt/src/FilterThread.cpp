@@ -24,16 +24,74 @@
  */
 #include "FilterThread.h"
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QRegularExpression>
 #include <iostream>
 #include "FilterParameters/AbstractParameter.h"
+#include "Globals.h"
 #include "GmicStdlib.h"
+#include "ImageBufferPool.h"
 #include "Logger.h"
 #include "Misc.h"
+#include "PerformanceStats.h"
 #include "PersistentMemory.h"
 #include "Settings.h"
+#include "Utils.h"
 #include "gmic.h"
 
+namespace
+{
+const int ProfileReportMaxLines = 30;
+
+bool profilingRequested(const QString & environment)
+{
+  static const bool fromProcessEnvironment = !qgetenv("GMIC_QT_PROFILE").isEmpty();
+  static const QRegularExpression re("(^|\\s)_profile=1(\\s|$)");
+  return fromProcessEnvironment || environment.contains(re);
+}
+
+void reportProfile(const gmic_profiler & profiler, const QString & command, const QString & logSuffix)
+{
+  const std::vector<std::pair<std::string, gmic_profiler::command_stats>> stats = profiler.sorted();
+  QString text = QString("Command profile (%1 commands, sorted by exclusive time)\n").arg(stats.size());
+  text += QString("%1 %2 %3 %4 %5\n").arg("Command", -24).arg("Calls", 8).arg("Incl. (ms)", 12).arg("Excl. (ms)", 12).arg("Allocated", 12);
+  QJsonArray commands;
+  for (const auto & entry : stats) {
+    const gmic_profiler::command_stats & s = entry.second;
+    const QString name = QString::fromStdString(entry.first) + (s.is_custom ? "*" : "");
+    if (commands.size() < ProfileReportMaxLines) {
+      text += QString("%1 %2 %3 %4 %5\n")
+                  .arg(name, -24)
+                  .arg(s.calls, 8)
+                  .arg(s.inclusive_ms, 12, 'f', 2)
+                  .arg(s.exclusive_ms, 12, 'f', 2)
+                  .arg(GmicQt::readableSize(s.allocated_bytes), 12);
+    }
+    QJsonObject object;
+    object.insert("name", QString::fromStdString(entry.first));
+    object.insert("custom", s.is_custom);
+    object.insert("calls", static_cast<double>(s.calls));
+    object.insert("inclusive_ms", s.inclusive_ms);
+    object.insert("exclusive_ms", s.exclusive_ms);
+    object.insert("allocated_bytes", static_cast<double>(s.allocated_bytes));
+    commands.append(object);
+  }
+  text += "(* custom command)";
+  GmicQt::Logger::log(text, logSuffix, true);
+
+  QJsonObject documentObject;
+  documentObject.insert("command", command);
+  documentObject.insert("commands", commands);
+  const QString jsonFilename = QString("%1%2").arg(GmicQt::gmicConfigPath(true), COMMAND_PROFILE_FILENAME);
+  if (!GmicQt::safelyWrite(QJsonDocument(documentObject).toJson(), jsonFilename)) {
+    GmicQt::Logger::error("Cannot write " + jsonFilename);
+  }
+}
+
+} // namespace
+
 namespace GmicQt
 {
 
@@ -41,11 +99,14 @@ FilterThread::FilterThread(QObject * parent, const QString & command, const QStr
     : QThread(parent), _command(command), _arguments(arguments), _environment(environment), //
       _images(new gmic_library::gmic_list<float>),                                          //
       _imageNames(new gmic_library::gmic_list<char>),                                       //
-      _persistentMemoryOutput(new gmic_library::gmic_image<char>)
+      _persistentMemoryInput(PersistentMemory::buffer())
 {
   _gmicAbort = false;
   _failed = false;
   _gmicProgress = 0.0f;
+  _previewFinalization = false;
+  _hasRandomSeed = false;
+  _randomSeed = 0;
 #ifdef _IS_MACOS_
   setStackSize(8 * 1024 * 1024);
 #endif
@@ -55,7 +116,6 @@ FilterThread::~FilterThread()
 {
   delete _images;
   delete _imageNames;
-  delete _persistentMemoryOutput;
 }
 
 void FilterThread::setImageNames(const gmic_library::gmic_list<char> & imageNames)
@@ -68,6 +128,18 @@ void FilterThread::swapImages(gmic_library::gmic_list<float> & images)
   _images->swap(images);
 }
 
+void FilterThread::giveImages(gmic_library::gmic_list<float> & images)
+{
+  _images->assign();
+  _images->swap(images);
+}
+
+void FilterThread::takeImages(gmic_library::gmic_list<float> & images)
+{
+  images.assign();
+  images.swap(*_images);
+}
+
 void FilterThread::setInputImages(const gmic_library::gmic_list<float> & list)
 {
   *_images = list;
@@ -83,9 +155,9 @@ const gmic_library::gmic_list<char> & FilterThread::imageNames() const
   return *_imageNames;
 }
 
-gmic_library::gmic_image<char> & FilterThread::persistentMemoryOutput()
+const PersistentMemory::Buffer & FilterThread::persistentMemoryOutput() const
 {
-  return *_persistentMemoryOutput;
+  return _persistentMemoryOutput;
 }
 
 QStringList FilterThread::status2StringList(QString status)
@@ -191,17 +263,59 @@ void FilterThread::setLogSuffix(const QString & text)
   _logSuffix = text;
 }
 
+const RunResources & FilterThread::resources() const
+{
+  return _resources;
+}
+
+void FilterThread::setPreviewFinalization(const QSize & expectedSize, const QSize & areaSize, const QSize & upscaledSize)
+{
+  _previewFinalization = true;
+  _previewExpectedSize = expectedSize;
+  _previewAreaSize = areaSize;
+  _previewUpscaledSize = upscaledSize;
+}
+
+const PreviewResult & FilterThread::previewResult() const
+{
+  return _previewResult;
+}
+
+void FilterThread::setBudgetPriority(ThreadBudget::Priority priority)
+{
+  _budgetJob.setPriority(priority);
+  if (isRunning()) {
+    const bool low = (priority == ThreadBudget::Priority::Background) || (priority == ThreadBudget::Priority::Superseded);
+    setPriority(low ? QThread::LowestPriority : QThread::NormalPriority);
+  }
+}
+
+void FilterThread::setRandomSeed(unsigned int seed)
+{
+  _hasRandomSeed = true;
+  _randomSeed = seed;
+}
+
 void FilterThread::abortGmic()
 {
   _gmicAbort = true;
+  // Until the interpreter notices, leave the cores to the runs replacing this one
+  setBudgetPriority(ThreadBudget::Priority::Superseded);
 }
 
 void FilterThread::run()
 {
+  TRACE_SPAN_NAMED(span, "Interpreter run", "gmic");
+  PerformanceStats::filterThreadStarted();
+  _budgetJob.start();
+  ResourceMeter meter;
+  meter.start(*_images);
   _startTime.start();
   _errorMessage.clear();
   _failed = false;
   QString fullCommandLine;
+  gmic_profiler profiler;
+  const bool profiling = profilingRequested(_environment);
   try {
     fullCommandLine = commandFromOutputMessageMode(Settings::outputMessageMode());
     appendWithSpace(fullCommandLine, _command);
@@ -209,19 +323,28 @@ void FilterThread::run()
     _gmicAbort = false;
     _gmicProgress = -1;
     Logger::log(fullCommandLine, _logSuffix, true);
+    span.setDetail(fullCommandLine);
     gmic gmicInstance(_environment.isEmpty() ? nullptr : QString("%1").arg(_environment).toLocal8Bit().constData(), GmicStdLib::Array.constData(), true, &_gmicProgress, &_gmicAbort, 0.0f);
-    if (PersistentMemory::image()) {
-      if (*PersistentMemory::image() == gmic_store) {
-        gmicInstance.set_variable("_persistent", PersistentMemory::image());
-      } else {
-        gmicInstance.set_variable("_persistent", '=', PersistentMemory::image());
-      }
+    // Kept alive until the end of the run, as the interpreter reads it without a copy. It is the buffer
+    // current when the thread was created, which identifies the input of a speculative preview.
+    const PersistentMemory::Buffer persistentMemoryInput = _persistentMemoryInput;
+    if (persistentMemoryInput) {
+      gmicInstance.share_variable("_persistent", *persistentMemoryInput);
+    }
+    if (_hasRandomSeed) {
+      gmic_library::cimg::srand(_randomSeed);
     }
     gmicInstance.set_variable("_host", '=', GmicQtHost::ApplicationShortname);
     gmicInstance.set_variable("_tk", '=', "qt");
+    gmicInstance.thread_budget = _budgetJob.budget();
+    if (profiling) {
+      gmicInstance.profiler = &profiler;
+    }
     gmicInstance.run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames);
     _gmicStatus = QString::fromLocal8Bit(gmicInstance.status);
-    gmicInstance.get_variable("_persistent").move_to(*_persistentMemoryOutput);
+    gmic_library::gmic_image<char> persistentMemory;
+    gmicInstance.take_variable("_persistent", persistentMemory);
+    _persistentMemoryOutput = PersistentMemory::adopt(persistentMemory, persistentMemoryInput);
   } catch (gmic_exception & e) {
     _images->assign();
     _imageNames->assign();
@@ -230,6 +353,22 @@ void FilterThread::run()
     Logger::error(QString("When running command '%1', this error occurred:\n%2").arg(fullCommandLine).arg(message), true);
     _failed = true;
   }
+  _resources = meter.stop(*_images);
+  _resources.command = fullCommand().toStdString();
+  _resources.failed = _failed;
+  _resources.aborted = _gmicAbort;
+  _resources.concurrent = !_budgetJob.ranAlone();
+  ResourceMeter::record(_resources, _logSuffix);
+  if (profiling) {
+    reportProfile(profiler, fullCommandLine, _logSuffix);
+  }
+  PerformanceStats::addImageBytes(_resources.inputBytes, _resources.outputBytes);
+  if (_previewFinalization && !_failed && !_gmicAbort) {
+    finalizePreview(*_images, _previewExpectedSize, _previewAreaSize, _previewResult, _previewUpscaledSize);
+    ImageBufferPool::release(*_images);
+  }
+  _budgetJob.finish();
+  PerformanceStats::filterThreadFinished();
 }
 
 } // namespace GmicQt
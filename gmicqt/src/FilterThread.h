@@ -26,11 +26,16 @@
 #define GMIC_QT__FILTERTHREAD_H
 
 #include <QElapsedTimer>
+#include <QSize>
 #include <QString>
 #include <QThread>
 #include "Common.h"
 #include "GmicQt.h"
 #include "Host/GmicQtHost.h"
+#include "ImageTools.h"
+#include "PersistentMemory.h"
+#include "ResourceUsage.h"
+#include "ThreadBudget.h"
 
 namespace gmic_library
 {
@@ -50,9 +55,17 @@ public:
   void setInputImages(const gmic_library::gmic_list<float> & list);
   void setImageNames(const gmic_library::gmic_list<char> & imageNames);
   void swapImages(gmic_library::gmic_list<float> & images);
+  /**
+   * Take ownership of the input images, leaving the argument empty (no copy).
+   */
+  void giveImages(gmic_library::gmic_list<float> & images);
+  /**
+   * Release ownership of the output images to the caller (no copy).
+   */
+  void takeImages(gmic_library::gmic_list<float> & images);
   const gmic_library::gmic_list<float> & images() const;
   const gmic_library::gmic_list<char> & imageNames() const;
-  gmic_library::gmic_image<char> & persistentMemoryOutput();
+  const PersistentMemory::Buffer & persistentMemoryOutput() const;
   QStringList gmicStatus() const;
   QList<int> parametersVisibilityStates() const;
   QString errorMessage() const;
@@ -62,6 +75,26 @@ public:
   float progress() const;
   QString fullCommand() const;
   void setLogSuffix(const QString & text);
+  const RunResources & resources() const;
+
+  /**
+   * Priority of the run in the share of the CPU cores (see ThreadBudget),
+   * Interactive by default. It may be changed while the thread is running.
+   */
+  void setBudgetPriority(ThreadBudget::Priority priority);
+
+  /**
+   * Seed the random number generator when the run starts, rather than when
+   * the thread is created.
+   */
+  void setRandomSeed(unsigned int seed);
+
+  /**
+   * Finalize the preview on this thread once the filter has completed (see
+   * finalizePreview()). Output images are then released.
+   */
+  void setPreviewFinalization(const QSize & expectedSize, const QSize & areaSize, const QSize & upscaledSize = QSize());
+  const PreviewResult & previewResult() const;
 
   static QStringList status2StringList(QString);
   static QList<int> status2Visibilities(const QString &);
@@ -81,7 +114,10 @@ private:
   QString _environment;
   gmic_library::gmic_list<float> * _images;
   gmic_library::gmic_list<char> * _imageNames;
-  gmic_library::gmic_image<char> * _persistentMemoryOutput;
+  PersistentMemory::Buffer _persistentMemoryInput; // Taken when the thread is created
+  bool _hasRandomSeed;
+  unsigned int _randomSeed;
+  PersistentMemory::Buffer _persistentMemoryOutput;
   bool _gmicAbort;
   bool _failed;
   QString _gmicStatus;
@@ -89,7 +125,14 @@ private:
   QString _errorMessage;
   QString _name;
   QString _logSuffix;
+  RunResources _resources;
   QElapsedTimer _startTime;
+  bool _previewFinalization;
+  QSize _previewExpectedSize;
+  QSize _previewAreaSize;
+  QSize _previewUpscaledSize;
+  PreviewResult _previewResult;
+  ThreadBudget::Job _budgetJob;
 };
 
 } // namespace GmicQt
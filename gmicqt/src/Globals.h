@@ -40,6 +40,8 @@ const char WarningPrefix = '!';
 #define SLIDER_MIN_WIDTH 60
 #define PARAMETERS_CACHE_FILENAME "gmic_qt_params.dat"
 #define FILTER_GUI_DYNAMISM_CACHE_FILENAME "gmic_qt_dynamism.dat"
+#define FILTER_MEMORY_CACHE_FILENAME "gmic_qt_memory.dat"
+#define COMMAND_PROFILE_FILENAME "gmic_qt_profile.json"
 #define FILTERS_VISIBILITY_FILENAME "gmic_qt_visibility.dat"
 #define FILTERS_TAGS_FILENAME "gmic_qt_tags.dat"
 #define FILTERS_CACHE_FILENAME "gmic_qt_filters.dat"
@@ -51,6 +53,7 @@ const char WarningPrefix = '!';
 #define REFRESH_USING_INTERNET_KEY "Config/RefreshInternetUpdate"
 #define INTERNET_UPDATE_PERIODICITY_KEY "Config/UpdatesPeriodicityValue"
 #define OFFICIAL_FILTER_SOURCE_KEY "Config/OfficialFilterSource"
+#define FILTER_SOURCES_VALIDATORS_KEY "Updates/Validators"
 #define ENABLE_FILTER_TRANSLATION "Config/FilterTranslation"
 #define LANGUAGE_CODE_KEY "Config/LanguageCode"
 #define HIGHDPI_KEY "Config/HighDPIEnabled"
@@ -69,4 +72,10 @@ const char WarningPrefix = '!';
 #define KEYPOINTS_INTERACTIVE_MIDDLE_DELAY_MS ((KEYPOINTS_INTERACTIVE_LOWER_DELAY_MS + KEYPOINTS_INTERACTIVE_UPPER_DELAY_MS) / 2)
 #define KEYPOINTS_INTERACTIVE_AVERAGING_COUNT 6
 
+#define PREVIEW_LATENCY_TARGET_KEY "Config/PreviewLatencyTarget"
+#define PREVIEW_DEFAULT_LATENCY_TARGET_MS 150
+#define PREVIEW_REFINEMENT_DELAY_MS 400
+#define SPECULATIVE_PREVIEW_DELAY_MS 250
+#define SPECULATIVE_PREVIEW_MAX_DURATION_MS 3000
+
 #endif // GMIC_QT_GLOBALS_H
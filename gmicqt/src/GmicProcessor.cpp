@@ -30,6 +30,7 @@
 #include <QRegularExpression>
 #include <QSize>
 #include <QString>
+#include <cmath>
 #include <cstring>
 #include "CroppedActiveLayerProxy.h"
 #include "CroppedImageListProxy.h"
@@ -38,25 +39,68 @@
 #include "FilterThread.h"
 #include "Globals.h"
 #include "Host/GmicQtHost.h"
+#include "ImageBufferPool.h"
 #include "ImageTools.h"
 #include "LayersExtentProxy.h"
 #include "Logger.h"
+#include "MemoryEstimator.h"
 #include "Misc.h"
 #include "OverrideCursor.h"
+#include "PerformanceStats.h"
 #include "PersistentMemory.h"
 #include "Settings.h"
+#include "Tracer.h"
 #include "gmic.h"
 
 namespace GmicQt
 {
 
+namespace
+{
+// Everything a preview depends on, except images and persistent memory
+QString speculationKey(const GmicProcessor::FilterContext & context)
+{
+  const GmicProcessor::FilterContext::VisibleRect & rect = context.visibleRect;
+  return QString("%1|%2|%3|%4|%5|%6,%7,%8,%9|%10|%11x%12|%13|%14|%15|%16,%17|%18")
+      .arg(context.filterHash)
+      .arg(context.filterCommand)
+      .arg(context.filterArguments)
+      .arg(static_cast<int>(context.inputOutputState.inputMode))
+      .arg(static_cast<int>(context.inputOutputState.outputMode))
+      .arg(rect.x)
+      .arg(rect.y)
+      .arg(rect.w)
+      .arg(rect.h)
+      .arg(context.zoomFactor)
+      .arg(context.previewWindowWidth)
+      .arg(context.previewWindowHeight)
+      .arg(context.previewTimeout)
+      .arg(int(context.previewCheckBox))
+      .arg(int(context.randomized))
+      .arg(context.positionStringCorrection.xFactor)
+      .arg(context.positionStringCorrection.yFactor)
+      .arg(PersistentMemory::generation()); // The '_persistent' input of the run
+}
+} // namespace
+
 GmicProcessor::GmicProcessor(QObject * parent) : QObject(parent)
 {
   _filterThread = nullptr;
+  _speculativeThread = nullptr;
+  _adoptedSpeculativeThread = nullptr;
+  _speculativeThreadFinished = false;
+  _executionQueued = false;
   _gmicImages = new gmic_library::gmic_list<gmic_pixel_type>;
-  _previewImage = new gmic_library::gmic_image<float>;
   _waitingCursorTimer.setSingleShot(true);
   connect(&_waitingCursorTimer, &QTimer::timeout, this, &GmicProcessor::showWaitingCursor);
+  _previewRefinementTimer.setSingleShot(true);
+  _previewRefinementTimer.setInterval(PREVIEW_REFINEMENT_DELAY_MS);
+  connect(&_previewRefinementTimer, &QTimer::timeout, this, &GmicProcessor::onPreviewRefinementTimeout);
+  _speculativeBudgetTimer.setSingleShot(true);
+  _speculativeBudgetTimer.setInterval(SPECULATIVE_PREVIEW_MAX_DURATION_MS);
+  connect(&_speculativeBudgetTimer, &QTimer::timeout, this, &GmicProcessor::onSpeculativeBudgetTimeout);
+  _previewScale = 1.0;
+  _memoryPreviewScale = 1.0;
   gmic_library::cimg::srand();
   _previewRandomSeed = gmic_library::cimg::_rand();
   _lastAppliedCommandInOutState = InputOutputState::Unspecified;
@@ -72,8 +116,9 @@ void GmicProcessor::init()
 
 GmicProcessor::~GmicProcessor()
 {
+  discardSpeculativePreview();
   delete _gmicImages;
-  delete _previewImage;
+  ImageBufferPool::clear();
   if (!_unfinishedAbortedThreads.isEmpty()) {
     Logger::error(QString("~GmicProcessor(): There are %1 unfinished filter threads.").arg(_unfinishedAbortedThreads.size()));
     detachAllUnfinishedAbortedThreads();
@@ -87,74 +132,48 @@ void GmicProcessor::setContext(const GmicProcessor::FilterContext & context)
 
 void GmicProcessor::execute()
 {
-  gmic_list<char> imageNames;
-  FilterContext::VisibleRect & rect = _filterContext.visibleRect;
-  _gmicImages->assign();
-  if ((_filterContext.requestType == FilterContext::RequestType::Preview) ||            //
-      (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview) || //
-      (_filterContext.requestType == FilterContext::RequestType::GUIDynamismRun)) {
-    if (_filterContext.previewFromFullImage) {
-      CroppedImageListProxy::get(*_gmicImages, imageNames, 0.0, 0.0, 1.0, 1.0, _filterContext.inputOutputState.inputMode, 1.0);
-      updateImageNames(imageNames);
-    } else {
-      CroppedImageListProxy::get(*_gmicImages, imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode, _filterContext.zoomFactor);
-      updateImageNames(imageNames);
-    }
-  } else {
-    CroppedImageListProxy::get(*_gmicImages, imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode, 1.0);
+  if (adoptSpeculativePreview()) {
+    return;
   }
-  _waitingCursorTimer.start(WAITING_CURSOR_DELAY);
-  const InputOutputState & io = _filterContext.inputOutputState;
-  QString env = QString("_input_layers=%1").arg(static_cast<int>(io.inputMode));
-  env += QString(" _output_mode=%1").arg(static_cast<int>(io.outputMode));
-  env += QString(" _output_messages=%1").arg(static_cast<int>(Settings::outputMessageMode()));
-  if ((_filterContext.requestType == FilterContext::RequestType::Preview) || //
-      (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview)) {
-    env += QString(" _preview_area_width=%1").arg(_filterContext.previewWindowWidth);
-    env += QString(" _preview_area_height=%1").arg(_filterContext.previewWindowHeight);
-    env += QString(" _preview_timeout=%1").arg(_filterContext.previewTimeout);
-    env += QString(" _preview_enabled=%1").arg(int(_filterContext.previewCheckBox));
-    env += QString(" _randomized=%1").arg(int(_filterContext.randomized));
+  discardSpeculativePreview();
+  if (!admitExecution()) {
+    return;
   }
-  int maxWidth;
-  int maxHeight;
-  int preview_x0;
-  int preview_y0;
-  int preview_x1;
-  int preview_y1;
-  QSize previewSize;
-  LayersExtentProxy::getExtent(_filterContext.inputOutputState.inputMode, maxWidth, maxHeight);
-  if (_filterContext.previewFromFullImage) {
-    preview_x0 = static_cast<int>(rect.x * maxWidth);
-    preview_y0 = static_cast<int>(rect.y * maxHeight);
-    preview_x1 = preview_x0 + std::min(maxWidth, static_cast<int>(1 + std::ceil(maxWidth * rect.w))) - 1;
-    preview_y1 = preview_y0 + std::min(maxHeight, static_cast<int>(1 + std::ceil(maxHeight * rect.h))) - 1;
-    previewSize = QSize(1 + preview_x1 - preview_x0, 1 + preview_y1 - preview_y0);
-    if (_filterContext.zoomFactor < 1.0) {
-      previewSize = QSize(static_cast<int>(std::round(previewSize.width() * _filterContext.zoomFactor)), //
-                          static_cast<int>(std::round(previewSize.height() * _filterContext.zoomFactor)));
-    }
-  } else {
-    if (_filterContext.zoomFactor < 1.0) {
-      maxWidth = static_cast<int>(std::round(maxWidth * _filterContext.zoomFactor));
-      maxHeight = static_cast<int>(std::round(maxHeight * _filterContext.zoomFactor));
+  if (PerformanceStats::isEnabled()) {
+    const bool fullImage = (_filterContext.requestType == FilterContext::RequestType::FullImage);
+    PerformanceStats::beginRun(QString("%1 (%2)").arg(_filterContext.filterName).arg(fullImage ? tr("apply") : tr("preview")));
+  }
+  TRACE_SPAN("Prepare filter run", "processor");
+  gmic_list<char> imageNames;
+  _previewRefinementTimer.stop();
+  _previewScale = 1.0;
+  if (((_filterContext.requestType == FilterContext::RequestType::Preview) ||            //
+       (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview)) && //
+      !_filterContext.previewFromFullImage) {
+    if (!_filterContext.fullResolutionPreview) {
+      _previewScale = _previewScaleController.scale(_filterContext.previewLatencyTarget);
     }
-    preview_x0 = 0;
-    preview_y0 = 0;
-    preview_x1 = std::min(maxWidth, static_cast<int>(1 + std::ceil(maxWidth * rect.w))) - 1;
-    preview_y1 = std::min(maxHeight, static_cast<int>(1 + std::ceil(maxHeight * rect.h))) - 1;
-    previewSize = QSize(1 + preview_x1 - preview_x0, 1 + preview_y1 - preview_y0);
+    _previewScale = std::min(_previewScale, _memoryPreviewScale);
   }
-  env += QString(" _preview_x0=%1").arg(preview_x0);
-  env += QString(" _preview_y0=%1").arg(preview_y0);
-  env += QString(" _preview_x1=%1").arg(preview_x1);
-  env += QString(" _preview_y1=%1").arg(preview_y1);
-  env += QString(" _preview_width=%1").arg(previewSize.width());
-  env += QString(" _preview_height=%1").arg(previewSize.height());
+  ImageBufferPool::release(*_gmicImages);
+  fetchInputImages(_filterContext, _previewScale, *_gmicImages, imageNames);
+  _inputLayerCounts[static_cast<int>(_filterContext.inputOutputState.inputMode)] = static_cast<int>(_gmicImages->size());
+  // Input images are now known exactly, check again what remains to be allocated
+  const quint64 budget = MemoryEstimator::budget();
+  const quint64 inputBytes = PerformanceStats::imageListByteCount(*_gmicImages);
+  const quint64 growth = static_cast<quint64>(inputBytes * MemoryEstimator::multiplier(_filterContext.filterHash));
+  if (budget && (growth > budget)) {
+    _gmicImages->assign();
+    PerformanceStats::endRun();
+    refuseExecution(tr("Not enough memory to run this filter\n(about %1 needed, %2 available).").arg(readableSize(growth)).arg(readableSize(budget)));
+    return;
+  }
+  _waitingCursorTimer.start(WAITING_CURSOR_DELAY);
+  const QString env = filterEnvironment(_filterContext, _previewScale, _expectedPreviewSize, _fullResolutionPreviewSize);
   _completedExecutionTime.restart();
   if (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview) {
     FilterSyncRunner runner(this, _filterContext.filterCommand, _filterContext.filterArguments, env);
-    runner.swapImages(*_gmicImages);
+    runner.giveImages(*_gmicImages);
     runner.setImageNames(imageNames);
     runner.setLogSuffix("preview");
     gmic_library::cimg::srand();
@@ -166,10 +185,11 @@ void GmicProcessor::execute()
   } else if ((_filterContext.requestType == FilterContext::RequestType::Preview) || //
              (_filterContext.requestType == FilterContext::RequestType::GUIDynamismRun)) {
     _filterThread = new FilterThread(this, _filterContext.filterCommand, _filterContext.filterArguments, env);
-    _filterThread->swapImages(*_gmicImages);
+    _filterThread->giveImages(*_gmicImages);
     _filterThread->setImageNames(imageNames);
     _filterThread->setLogSuffix("preview");
     if (_filterContext.requestType == FilterContext::RequestType::Preview) {
+      _filterThread->setPreviewFinalization(_expectedPreviewSize, QSize(_filterContext.previewWindowWidth, _filterContext.previewWindowHeight), _fullResolutionPreviewSize);
       connect(_filterThread, &FilterThread::finished, this, &GmicProcessor::onPreviewThreadFinished, Qt::QueuedConnection);
     } else {
       connect(_filterThread, &FilterThread::finished, this, &GmicProcessor::onGUIDynamismThreadFinished, Qt::QueuedConnection);
@@ -185,9 +205,10 @@ void GmicProcessor::execute()
     _lastAppliedCommandArguments = _filterContext.filterArguments;
     _lastAppliedCommandInOutState = _filterContext.inputOutputState;
     _filterThread = new FilterThread(this, _filterContext.filterCommand, _filterContext.filterArguments, env);
-    _filterThread->swapImages(*_gmicImages);
+    _filterThread->giveImages(*_gmicImages);
     _filterThread->setImageNames(imageNames);
     _filterThread->setLogSuffix("apply");
+    _filterThread->setBudgetPriority(ThreadBudget::Priority::Batch);
     connect(_filterThread, &FilterThread::finished, this, &GmicProcessor::onApplyThreadFinished, Qt::QueuedConnection);
     gmic_library::cimg::srand(_previewRandomSeed);
     _filterThread->start();
@@ -196,17 +217,17 @@ void GmicProcessor::execute()
 
 bool GmicProcessor::isProcessingFullImage() const
 {
-  return _filterThread && (_filterContext.requestType == FilterContext::RequestType::FullImage);
+  return (_filterThread || _executionQueued) && (_filterContext.requestType == FilterContext::RequestType::FullImage);
 }
 
 bool GmicProcessor::isProcessing() const
 {
-  return _filterThread;
+  return _filterThread || _executionQueued;
 }
 
 bool GmicProcessor::isIdle() const
 {
-  return !_filterThread;
+  return !_filterThread && !_executionQueued;
 }
 
 int GmicProcessor::duration() const
@@ -236,10 +257,16 @@ int GmicProcessor::lastPreviewFilterExecutionDurationMS() const
 void GmicProcessor::resetLastPreviewFilterExecutionDurations()
 {
   _lastFilterPreviewExecutionDurations.clear();
+  _previewScaleController.reset();
 }
 
 void GmicProcessor::recordPreviewFilterExecutionDurationMS(int duration)
 {
+  _previewScaleController.record(_previewScale, duration);
+  if (_previewScale < _memoryPreviewScale) {
+    // Compute the preview at full resolution (or as close as memory permits) once the user stops interacting
+    _previewRefinementTimer.start();
+  }
   _lastFilterPreviewExecutionDurations.push_back(duration);
   while (_lastFilterPreviewExecutionDurations.size() >= KEYPOINTS_INTERACTIVE_AVERAGING_COUNT) {
     _lastFilterPreviewExecutionDurations.pop_front();
@@ -282,10 +309,12 @@ void GmicProcessor::detachAllUnfinishedAbortedThreads()
     thread->setParent(nullptr);
   }
   _unfinishedAbortedThreads.clear();
+  PerformanceStats::setAbortedFilterThreadCount(0);
 }
 
 void GmicProcessor::terminateAllThreads()
 {
+  discardSpeculativePreview();
   if (_filterThread) {
     _filterThread->disconnect(this);
     _filterThread->terminate();
@@ -299,6 +328,7 @@ void GmicProcessor::terminateAllThreads()
     delete _unfinishedAbortedThreads.front();
     _unfinishedAbortedThreads.pop_front();
   }
+  PerformanceStats::setAbortedFilterThreadCount(0);
   _waitingCursorTimer.stop();
   OverrideCursor::setNormal();
 }
@@ -308,9 +338,14 @@ bool GmicProcessor::hasUnfinishedAbortedThreads() const
   return !_unfinishedAbortedThreads.isEmpty();
 }
 
-const gmic_library::gmic_image<float> & GmicProcessor::previewImage() const
+const QImage & GmicProcessor::previewImage() const
+{
+  return _previewImage;
+}
+
+QSize GmicProcessor::previewImageSize() const
 {
-  return *_previewImage;
+  return _previewImageSize;
 }
 
 const QStringList & GmicProcessor::gmicStatus() const
@@ -360,6 +395,7 @@ void GmicProcessor::onGUIDynamismThreadFinished()
     _filterThread->deleteLater();
     _filterThread = nullptr;
     hideWaitingCursor();
+    PerformanceStats::endRun();
     Logger::warning(QString("Failed to execute filter: %1").arg(message));
     return;
   }
@@ -367,10 +403,11 @@ void GmicProcessor::onGUIDynamismThreadFinished()
   _parametersVisibilityStates = _filterThread->parametersVisibilityStates();
   _gmicImages->assign();
   FilterGuiDynamismCache::setValue(_filterContext.filterHash, _gmicStatus.isEmpty() ? FilterGuiDynamism::Static : FilterGuiDynamism::Dynamic);
-  PersistentMemory::move_from(_filterThread->persistentMemoryOutput());
+  PersistentMemory::replace(_filterThread->persistentMemoryOutput());
   _filterThread->deleteLater();
   _filterThread = nullptr;
   hideWaitingCursor();
+  PerformanceStats::endRun();
   emit guiDynamismRunDone();
 }
 
@@ -389,32 +426,29 @@ void GmicProcessor::onPreviewThreadFinished()
     _filterThread->deleteLater();
     _filterThread = nullptr;
     hideWaitingCursor();
+    PerformanceStats::endRun();
     emit previewCommandFailed(message);
     return;
   }
   _gmicStatus = _filterThread->gmicStatus();
   _parametersVisibilityStates = _filterThread->parametersVisibilityStates();
-  _gmicImages->assign();
   FilterGuiDynamismCache::setValue(_filterContext.filterHash, _gmicStatus.isEmpty() ? FilterGuiDynamism::Static : FilterGuiDynamism::Dynamic);
-  _filterThread->swapImages(*_gmicImages);
-  PersistentMemory::move_from(_filterThread->persistentMemoryOutput());
-  unsigned int badSpectrumIndex = 0;
-  bool correctSpectrums = checkImageSpectrumAtMost4(*_gmicImages, badSpectrumIndex);
-  if (correctSpectrums) {
-    for (unsigned int i = 0; i < _gmicImages->size(); ++i) {
-      GmicQtHost::applyColorProfile((*_gmicImages)[i]);
-    }
-    buildPreviewImage(*_gmicImages, *_previewImage);
-  }
+  MemoryEstimator::learn(_filterContext.filterHash, _filterThread->resources());
+  PersistentMemory::replace(_filterThread->persistentMemoryOutput());
+  // Preview image was finalized by the filter thread
+  const PreviewResult result = _filterThread->previewResult();
   _filterThread->deleteLater();
   _filterThread = nullptr;
   hideWaitingCursor();
-  if (correctSpectrums) {
+  PerformanceStats::endRun();
+  if (result.valid) {
+    _previewImage = result.displayImage;
+    _previewImageSize = result.imageSize;
     emit previewImageAvailable();
     recordPreviewFilterExecutionDurationMS((int)_ongoingFilterExecutionTime.elapsed());
   } else {
     QString message(tr("Image #%1 returned by filter has %2 channels (should be at most 4)"));
-    emit previewCommandFailed(message.arg(badSpectrumIndex).arg((*_gmicImages)[badSpectrumIndex].spectrum()));
+    emit previewCommandFailed(message.arg(result.badSpectrumIndex).arg(result.badSpectrum));
   }
 }
 
@@ -437,10 +471,12 @@ void GmicProcessor::onApplyThreadFinished()
     QString message = _filterThread->errorMessage();
     _filterThread->deleteLater();
     _filterThread = nullptr;
+    PerformanceStats::endRun();
     emit fullImageProcessingFailed(message);
   } else {
-    _filterThread->swapImages(*_gmicImages);
-    PersistentMemory::move_from(_filterThread->persistentMemoryOutput());
+    MemoryEstimator::learn(_filterContext.filterHash, _filterThread->resources());
+    _filterThread->takeImages(*_gmicImages);
+    PersistentMemory::replace(_filterThread->persistentMemoryOutput());
     unsigned int badSpectrumIndex = 0;
     bool correctSpectrums = checkImageSpectrumAtMost4(*_gmicImages, badSpectrumIndex);
     if (!correctSpectrums) {
@@ -449,13 +485,17 @@ void GmicProcessor::onApplyThreadFinished()
       _lastAppliedCommandArguments.clear();
       _filterThread->deleteLater();
       _filterThread = nullptr;
+      PerformanceStats::endRun();
       QString message(tr("Image #%1 returned by filter has %2 channels\n(should be at most 4)"));
       emit fullImageProcessingFailed(message.arg(badSpectrumIndex).arg((*_gmicImages)[badSpectrumIndex].spectrum()));
     } else {
       if (GmicQtHost::ApplicationName.isEmpty()) {
         emit aboutToSendImagesToHost();
       }
-      GmicQtHost::outputImages(*_gmicImages, _filterThread->imageNames(), _filterContext.inputOutputState.outputMode);
+      {
+        TRACE_SPAN("Host output", "output");
+        GmicQtHost::outputImages(*_gmicImages, _filterThread->imageNames(), _filterContext.inputOutputState.outputMode);
+      }
       _completeFullImageProcessingCount += 1;
       LayersExtentProxy::clear();
       CroppedActiveLayerProxy::clear();
@@ -463,6 +503,7 @@ void GmicProcessor::onApplyThreadFinished()
       _filterThread->deleteLater();
       _filterThread = nullptr;
       _lastAppliedCommandGmicStatus = _gmicStatus; // TODO : save visibility states?
+      PerformanceStats::endRun();
       emit fullImageProcessingDone();
     }
   }
@@ -474,8 +515,13 @@ void GmicProcessor::onAbortedThreadFinished()
   if (_unfinishedAbortedThreads.contains(thread)) {
     _unfinishedAbortedThreads.removeOne(thread);
     thread->deleteLater();
+    PerformanceStats::setAbortedFilterThreadCount(_unfinishedAbortedThreads.size());
   }
   if (_unfinishedAbortedThreads.isEmpty()) {
+    if (_executionQueued) {
+      Logger::log("Resuming queued filter execution", _filterContext.requestType == FilterContext::RequestType::FullImage ? "apply" : "preview");
+      execute();
+    }
     emit noMoreUnfinishedJobs();
   }
 }
@@ -493,13 +539,237 @@ void GmicProcessor::hideWaitingCursor()
   OverrideCursor::setNormal();
 }
 
-void GmicProcessor::updateImageNames(gmic_list<char> & imageNames)
+void GmicProcessor::onPreviewRefinementTimeout()
+{
+  if (isIdle()) {
+    emit previewRefinementRequested();
+  }
+}
+
+void GmicProcessor::speculate(const FilterContext & context)
+{
+  discardSpeculativePreview();
+  if ((context.requestType != FilterContext::RequestType::Preview) || context.previewFromFullImage || !isIdle() || hasUnfinishedAbortedThreads()) {
+    return;
+  }
+  // Only when the input is at hand: a host fetch would block the GUI thread, and replace
+  // the input cached for the current filter if the input mode differs
+  const FilterContext::VisibleRect & rect = context.visibleRect;
+  if (!CroppedImageListProxy::isCached(rect.x, rect.y, rect.w, rect.h, context.inputOutputState.inputMode, context.zoomFactor)) {
+    return;
+  }
+  const quint64 budget = MemoryEstimator::budget();
+  gmic_list<float> images;
+  gmic_list<char> imageNames;
+  fetchInputImages(context, 1.0, images, imageNames);
+  if (budget) {
+    // A speculation never competes with a requested run for memory, keep it well within the budget
+    const quint64 inputBytes = PerformanceStats::imageListByteCount(images);
+    const quint64 growth = static_cast<quint64>(inputBytes * MemoryEstimator::multiplier(context.filterHash));
+    if (growth > budget / 2) {
+      ImageBufferPool::clear();
+      return;
+    }
+  }
+  _speculativeKey = speculationKey(context);
+  QSize fullResolutionPreviewSize;
+  const QString env = filterEnvironment(context, 1.0, _speculativeExpectedPreviewSize, fullResolutionPreviewSize);
+  _speculativeThread = new FilterThread(this, context.filterCommand, context.filterArguments, env);
+  _speculativeThread->giveImages(images);
+  _speculativeThread->setImageNames(imageNames);
+  _speculativeThread->setLogSuffix("preview");
+  _speculativeThread->setBudgetPriority(ThreadBudget::Priority::Background);
+  _speculativeThread->setPreviewFinalization(_speculativeExpectedPreviewSize, QSize(context.previewWindowWidth, context.previewWindowHeight), QSize());
+  connect(_speculativeThread, &FilterThread::finished, this, &GmicProcessor::onSpeculativeThreadFinished, Qt::QueuedConnection);
+  _speculativeThreadFinished = false;
+  // Seeded by the thread itself, the random state of the ongoing runs is left untouched
+  cimg_uint64 rng = 0;
+  gmic_library::cimg::srand(&rng);
+  _speculativeRandomSeed = gmic_library::cimg::_rand(&rng);
+  _speculativeThread->setRandomSeed(_speculativeRandomSeed);
+  _speculativeExecutionTime.restart();
+  _speculativeThread->start(QThread::LowestPriority);
+  _speculativeBudgetTimer.start();
+}
+
+bool GmicProcessor::adoptSpeculativePreview()
+{
+  if (!_speculativeThread || (_filterContext.requestType != FilterContext::RequestType::Preview) || (speculationKey(_filterContext) != _speculativeKey)) {
+    return false;
+  }
+  // A reduced resolution preview is expected, the speculative one would be slower
+  if ((_filterContext.previewLatencyTarget > 0) && !_filterContext.fullResolutionPreview && (_previewScaleController.scale(_filterContext.previewLatencyTarget) < 1.0)) {
+    return false;
+  }
+  Logger::log("Using speculative preview", "preview");
+  PerformanceStats::recordCacheAccess(PerformanceStats::Cache::SpeculativePreviews, true);
+  _speculativeBudgetTimer.stop();
+  _executionQueued = false;
+  if (PerformanceStats::isEnabled()) {
+    PerformanceStats::beginRun(QString("%1 (%2)").arg(_filterContext.filterName).arg(tr("preview")));
+  }
+  _previewRefinementTimer.stop();
+  _previewScale = 1.0;
+  _memoryPreviewScale = 1.0;
+  _fullResolutionPreviewSize = QSize();
+  _expectedPreviewSize = _speculativeExpectedPreviewSize;
+  _previewRandomSeed = _speculativeRandomSeed;
+  _ongoingFilterExecutionTime = _speculativeExecutionTime;
+  _completedExecutionTime = _speculativeExecutionTime;
+  _filterThread = _speculativeThread;
+  _speculativeThread = nullptr;
+  _filterThread->setBudgetPriority(ThreadBudget::Priority::Interactive);
+  if (_speculativeThreadFinished) {
+    _adoptedSpeculativeThread = _filterThread;
+    QMetaObject::invokeMethod(this, "onAdoptedSpeculativeThreadFinished", Qt::QueuedConnection);
+  } else {
+    _waitingCursorTimer.start(WAITING_CURSOR_DELAY);
+  }
+  return true;
+}
+
+void GmicProcessor::onAdoptedSpeculativeThreadFinished()
+{
+  // The adopted thread may have been aborted (and another one started) before this queued call
+  FilterThread * const adopted = _adoptedSpeculativeThread;
+  _adoptedSpeculativeThread = nullptr;
+  if (_filterThread && (_filterThread == adopted)) {
+    onPreviewThreadFinished();
+  }
+}
+
+void GmicProcessor::discardSpeculativePreview()
+{
+  _speculativeBudgetTimer.stop();
+  if (!_speculativeThread) {
+    return;
+  }
+  PerformanceStats::recordCacheAccess(PerformanceStats::Cache::SpeculativePreviews, false);
+  _speculativeThread->disconnect(this);
+  if (_speculativeThread->isFinished()) {
+    _speculativeThread->deleteLater();
+  } else {
+    connect(_speculativeThread, &FilterThread::finished, this, &GmicProcessor::onAbortedThreadFinished);
+    _unfinishedAbortedThreads.push_back(_speculativeThread);
+    PerformanceStats::setAbortedFilterThreadCount(_unfinishedAbortedThreads.size());
+    _speculativeThread->abortGmic();
+  }
+  _speculativeThread = nullptr;
+}
+
+void GmicProcessor::onSpeculativeThreadFinished()
 {
-  const double & xFactor = _filterContext.positionStringCorrection.xFactor;
-  const double & yFactor = _filterContext.positionStringCorrection.yFactor;
+  if (_filterThread && (sender() == _filterThread)) {
+    // Speculative preview was adopted while running
+    onPreviewThreadFinished();
+    return;
+  }
+  if (_speculativeThread && (sender() == _speculativeThread)) {
+    _speculativeThreadFinished = true;
+    _speculativeBudgetTimer.stop();
+    if (_speculativeThread->failed()) {
+      discardSpeculativePreview();
+    }
+  }
+}
+
+void GmicProcessor::onSpeculativeBudgetTimeout()
+{
+  if (_speculativeThread && !_speculativeThreadFinished) {
+    Logger::log("Speculative preview exceeded its time budget", "preview");
+    discardSpeculativePreview();
+  }
+}
+
+void GmicProcessor::fetchInputImages(const FilterContext & context, double previewScale, gmic_list<float> & images, gmic_list<char> & imageNames)
+{
+  const FilterContext::VisibleRect & rect = context.visibleRect;
+  const InputMode mode = context.inputOutputState.inputMode;
+  if ((context.requestType == FilterContext::RequestType::Preview) ||            //
+      (context.requestType == FilterContext::RequestType::SynchronousPreview) || //
+      (context.requestType == FilterContext::RequestType::GUIDynamismRun)) {
+    if (context.previewFromFullImage) {
+      CroppedImageListProxy::get(images, imageNames, 0.0, 0.0, 1.0, 1.0, mode, 1.0);
+      updateImageNames(context, 1.0, imageNames);
+    } else {
+      // Input images of a reduced resolution preview are downscaled further
+      const double zoomFactor = (previewScale < 1.0) ? std::min(1.0, context.zoomFactor) * previewScale : context.zoomFactor;
+      CroppedImageListProxy::get(images, imageNames, rect.x, rect.y, rect.w, rect.h, mode, zoomFactor);
+      updateImageNames(context, previewScale, imageNames);
+    }
+  } else {
+    CroppedImageListProxy::get(images, imageNames, rect.x, rect.y, rect.w, rect.h, mode, 1.0);
+  }
+}
+
+QString GmicProcessor::filterEnvironment(const FilterContext & context, double previewScale, QSize & previewSize, QSize & fullResolutionPreviewSize)
+{
+  const FilterContext::VisibleRect & rect = context.visibleRect;
+  const InputOutputState & io = context.inputOutputState;
+  QString env = QString("_input_layers=%1").arg(static_cast<int>(io.inputMode));
+  env += QString(" _output_mode=%1").arg(static_cast<int>(io.outputMode));
+  env += QString(" _output_messages=%1").arg(static_cast<int>(Settings::outputMessageMode()));
+  if ((context.requestType == FilterContext::RequestType::Preview) || //
+      (context.requestType == FilterContext::RequestType::SynchronousPreview)) {
+    env += QString(" _preview_area_width=%1").arg(context.previewWindowWidth);
+    env += QString(" _preview_area_height=%1").arg(context.previewWindowHeight);
+    env += QString(" _preview_timeout=%1").arg(context.previewTimeout);
+    env += QString(" _preview_enabled=%1").arg(int(context.previewCheckBox));
+    env += QString(" _randomized=%1").arg(int(context.randomized));
+  }
+  const double zoomFactor = (previewScale < 1.0) ? std::min(1.0, context.zoomFactor) * previewScale : context.zoomFactor;
   int maxWidth;
   int maxHeight;
-  LayersExtentProxy::getExtent(_filterContext.inputOutputState.inputMode, maxWidth, maxHeight);
+  int preview_x0;
+  int preview_y0;
+  int preview_x1;
+  int preview_y1;
+  fullResolutionPreviewSize = QSize();
+  LayersExtentProxy::getExtent(io.inputMode, maxWidth, maxHeight);
+  if (context.previewFromFullImage) {
+    preview_x0 = static_cast<int>(rect.x * maxWidth);
+    preview_y0 = static_cast<int>(rect.y * maxHeight);
+    preview_x1 = preview_x0 + std::min(maxWidth, static_cast<int>(1 + std::ceil(maxWidth * rect.w))) - 1;
+    preview_y1 = preview_y0 + std::min(maxHeight, static_cast<int>(1 + std::ceil(maxHeight * rect.h))) - 1;
+    previewSize = QSize(1 + preview_x1 - preview_x0, 1 + preview_y1 - preview_y0);
+    if (context.zoomFactor < 1.0) {
+      previewSize = QSize(static_cast<int>(std::round(previewSize.width() * context.zoomFactor)), //
+                          static_cast<int>(std::round(previewSize.height() * context.zoomFactor)));
+    }
+  } else {
+    if (previewScale < 1.0) {
+      const double fullZoomFactor = std::min(1.0, context.zoomFactor);
+      const int fullWidth = static_cast<int>(std::round(maxWidth * fullZoomFactor));
+      const int fullHeight = static_cast<int>(std::round(maxHeight * fullZoomFactor));
+      fullResolutionPreviewSize = QSize(std::min(fullWidth, static_cast<int>(1 + std::ceil(fullWidth * rect.w))), //
+                                        std::min(fullHeight, static_cast<int>(1 + std::ceil(fullHeight * rect.h))));
+    }
+    if (zoomFactor < 1.0) {
+      maxWidth = static_cast<int>(std::round(maxWidth * zoomFactor));
+      maxHeight = static_cast<int>(std::round(maxHeight * zoomFactor));
+    }
+    preview_x0 = 0;
+    preview_y0 = 0;
+    preview_x1 = std::min(maxWidth, static_cast<int>(1 + std::ceil(maxWidth * rect.w))) - 1;
+    preview_y1 = std::min(maxHeight, static_cast<int>(1 + std::ceil(maxHeight * rect.h))) - 1;
+    previewSize = QSize(1 + preview_x1 - preview_x0, 1 + preview_y1 - preview_y0);
+  }
+  env += QString(" _preview_x0=%1").arg(preview_x0);
+  env += QString(" _preview_y0=%1").arg(preview_y0);
+  env += QString(" _preview_x1=%1").arg(preview_x1);
+  env += QString(" _preview_y1=%1").arg(preview_y1);
+  env += QString(" _preview_width=%1").arg(previewSize.width());
+  env += QString(" _preview_height=%1").arg(previewSize.height());
+  return env;
+}
+
+void GmicProcessor::updateImageNames(const FilterContext & context, double previewScale, gmic_list<char> & imageNames)
+{
+  const double xFactor = context.positionStringCorrection.xFactor * previewScale;
+  const double yFactor = context.positionStringCorrection.yFactor * previewScale;
+  int maxWidth;
+  int maxHeight;
+  LayersExtentProxy::getExtent(context.inputOutputState.inputMode, maxWidth, maxHeight);
   for (size_t i = 0; i < imageNames.size(); ++i) {
     gmic_image<char> & name = imageNames[i];
     QString str((const char *)name);
@@ -519,18 +789,92 @@ void GmicProcessor::updateImageNames(gmic_list<char> & imageNames)
 
 void GmicProcessor::abortCurrentFilterThread()
 {
+  _executionQueued = false;
   if (!_filterThread) {
     return;
   }
   _filterThread->disconnect(this);
   connect(_filterThread, &FilterThread::finished, this, &GmicProcessor::onAbortedThreadFinished);
   _unfinishedAbortedThreads.push_back(_filterThread);
+  PerformanceStats::setAbortedFilterThreadCount(_unfinishedAbortedThreads.size());
   _filterThread->abortGmic();
   _filterThread = nullptr;
   _waitingCursorTimer.stop();
   OverrideCursor::setNormal();
 }
 
+bool GmicProcessor::admitExecution()
+{
+  _executionQueued = false;
+  _memoryPreviewScale = 1.0;
+  const quint64 budget = MemoryEstimator::budget();
+  if (!budget) {
+    return true;
+  }
+  const FilterContext::RequestType type = _filterContext.requestType;
+  const bool preview = (type == FilterContext::RequestType::Preview) || (type == FilterContext::RequestType::SynchronousPreview);
+  const bool wholeImage = (type != FilterContext::RequestType::FullImage) && _filterContext.previewFromFullImage;
+  const InputMode mode = _filterContext.inputOutputState.inputMode;
+  const FilterContext::VisibleRect & rect = _filterContext.visibleRect;
+  int width;
+  int height;
+  LayersExtentProxy::getExtent(mode, width, height);
+  double cropWidth = width;
+  double cropHeight = height;
+  if (!wholeImage && (rect.w > 0.0) && (rect.h > 0.0)) {
+    cropWidth *= rect.w;
+    cropHeight *= rect.h;
+  }
+  double zoom = 1.0;
+  if ((type != FilterContext::RequestType::FullImage) && !wholeImage && (_filterContext.zoomFactor < 1.0)) {
+    zoom = _filterContext.zoomFactor;
+  }
+  const int layers = _inputLayerCounts.value(static_cast<int>(mode), 1);
+  const quint64 fetchBytes = MemoryEstimator::inputBytes(static_cast<int>(std::ceil(cropWidth)), static_cast<int>(std::ceil(cropHeight)), layers);
+  const quint64 inputBytes = MemoryEstimator::inputBytes(static_cast<int>(std::ceil(cropWidth * zoom)), static_cast<int>(std::ceil(cropHeight * zoom)), layers);
+  const quint64 estimate = MemoryEstimator::estimate(_filterContext.filterHash, fetchBytes, inputBytes);
+  if (estimate <= budget) {
+    return true;
+  }
+  const QString logSuffix = (type == FilterContext::RequestType::FullImage) ? "apply" : "preview";
+
+  // Aborted threads still hold their images, wait for them to release memory
+  if (!_unfinishedAbortedThreads.isEmpty()) {
+    Logger::log(QString("Queuing filter execution (estimated memory %1, budget %2)").arg(readableSize(estimate)).arg(readableSize(budget)), logSuffix);
+    _executionQueued = true;
+    return false;
+  }
+
+  // A preview may be computed at a lower resolution
+  if (preview && !wholeImage && (budget > fetchBytes)) {
+    const double ratio = static_cast<double>(budget - fetchBytes) / static_cast<double>(estimate - fetchBytes);
+    const double newZoom = zoom * std::sqrt(ratio);
+    if ((cropWidth * newZoom >= 1.0) && (cropHeight * newZoom >= 1.0)) {
+      Logger::log(QString("Downscaling preview (estimated memory %1, budget %2, zoom %3)").arg(readableSize(estimate)).arg(readableSize(budget)).arg(newZoom), logSuffix);
+      // Computed at a reduced resolution and upscaled, as for a latency target (see PreviewScaleController)
+      _memoryPreviewScale = newZoom / zoom;
+      return true;
+    }
+  }
+
+  refuseExecution(tr("Not enough memory to run this filter\n(about %1 needed, %2 available).").arg(readableSize(estimate)).arg(readableSize(budget)));
+  return false;
+}
+
+void GmicProcessor::refuseExecution(const QString & message)
+{
+  Logger::warning(message);
+  ImageBufferPool::clear(); // Pooled buffers are part of the missing memory
+  if (_filterContext.requestType == FilterContext::RequestType::FullImage) {
+    _lastAppliedFilterPath.clear();
+    _lastAppliedCommand.clear();
+    _lastAppliedCommandArguments.clear();
+    emit fullImageProcessingFailed(message);
+  } else if (_filterContext.requestType != FilterContext::RequestType::GUIDynamismRun) {
+    emit previewCommandFailed(message);
+  }
+}
+
 void GmicProcessor::manageSynchonousRunner(FilterSyncRunner & runner)
 {
   _lastCompletedExecutionTime = _completedExecutionTime.elapsed();
@@ -539,20 +883,28 @@ void GmicProcessor::manageSynchonousRunner(FilterSyncRunner & runner)
     _gmicImages->assign();
     QString message = runner.errorMessage();
     hideWaitingCursor();
+    PerformanceStats::endRun();
     emit previewCommandFailed(message);
     return;
   }
   _gmicStatus = runner.gmicStatus();
   _parametersVisibilityStates = runner.parametersVisibilityStates();
-  _gmicImages->assign();
-  runner.swapImages(*_gmicImages);
-  PersistentMemory::move_from(runner.persistentMemoryOutput());
-  for (unsigned int i = 0; i < _gmicImages->size(); ++i) {
-    GmicQtHost::applyColorProfile((*_gmicImages)[i]);
-  }
-  buildPreviewImage(*_gmicImages, *_previewImage);
+  MemoryEstimator::learn(_filterContext.filterHash, runner.resources());
+  runner.takeImages(*_gmicImages);
+  PersistentMemory::replace(runner.persistentMemoryOutput());
+  PreviewResult result;
+  finalizePreview(*_gmicImages, _expectedPreviewSize, QSize(_filterContext.previewWindowWidth, _filterContext.previewWindowHeight), result, _fullResolutionPreviewSize);
+  ImageBufferPool::release(*_gmicImages);
   hideWaitingCursor();
-  emit previewImageAvailable();
+  PerformanceStats::endRun();
+  if (result.valid) {
+    _previewImage = result.displayImage;
+    _previewImageSize = result.imageSize;
+    emit previewImageAvailable();
+  } else {
+    QString message(tr("Image #%1 returned by filter has %2 channels (should be at most 4)"));
+    emit previewCommandFailed(message.arg(result.badSpectrumIndex).arg(result.badSpectrum));
+  }
 }
 
 const QList<int> & GmicProcessor::parametersVisibilityStates() const
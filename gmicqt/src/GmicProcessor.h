@@ -27,9 +27,12 @@
 
 #include <QElapsedTimer>
 #include <QList>
+#include <QHash>
+#include <QImage>
 #include <QObject>
 #include <QSettings>
 #include <QSignalMapper>
+#include <QSize>
 #include <QString>
 #include <QStringList>
 #include <QTimer>
@@ -37,6 +40,7 @@
 #include <deque>
 #include "GmicQt.h"
 #include "InputOutputState.h"
+#include "PreviewScaleController.h"
 
 namespace gmic_library
 {
@@ -75,6 +79,8 @@ public:
     int previewWindowWidth;
     int previewWindowHeight;
     int previewTimeout;
+    int previewLatencyTarget = 0;       // Milliseconds, 0 for previews always at full resolution
+    bool fullResolutionPreview = false; // Ignore the latency target for this preview
     bool previewFromFullImage = false;
     bool previewCheckBox;
     bool randomized;
@@ -90,13 +96,20 @@ public:
   void init();
   void setContext(const FilterContext & context);
   void execute();
+  /**
+   * Start computing a preview that may be requested soon, at a low priority.
+   * A later execute() of the very same preview adopts it, any other request
+   * discards it.
+   */
+  void speculate(const FilterContext & context);
 
   bool isProcessingFullImage() const;
   bool isProcessing() const;
   bool isIdle() const;
   bool hasUnfinishedAbortedThreads() const;
 
-  const gmic_library::gmic_image<float> & previewImage() const;
+  const QImage & previewImage() const; // Display-sized
+  QSize previewImageSize() const;       // Size of the filter output
   const QStringList & gmicStatus() const;
   const QList<int> & parametersVisibilityStates() const;
   void setGmicStatusQuotedParameters(const QVector<bool> & quotedParameters);
@@ -125,6 +138,7 @@ signals:
   void fullImageProcessingDone();
   void noMoreUnfinishedJobs();
   void aboutToSendImagesToHost();
+  void previewRefinementRequested();
 
 private slots:
   void onPreviewThreadFinished();
@@ -133,17 +147,32 @@ private slots:
   void onAbortedThreadFinished();
   void showWaitingCursor();
   void hideWaitingCursor();
+  void onPreviewRefinementTimeout();
+  void onSpeculativeThreadFinished();
+  void onAdoptedSpeculativeThreadFinished();
+  void onSpeculativeBudgetTimeout();
 
 private:
-  void updateImageNames(gmic_library::gmic_list<char> & imageNames);
+  void fetchInputImages(const FilterContext & context, double previewScale, gmic_library::gmic_list<float> & images, gmic_library::gmic_list<char> & imageNames);
+  QString filterEnvironment(const FilterContext & context, double previewScale, QSize & previewSize, QSize & fullResolutionPreviewSize);
+  void updateImageNames(const FilterContext & context, double previewScale, gmic_library::gmic_list<char> & imageNames);
+  bool adoptSpeculativePreview();
+  void discardSpeculativePreview();
+  bool admitExecution();
+  void refuseExecution(const QString & message);
   void abortCurrentFilterThread();
   void manageSynchonousRunner(FilterSyncRunner & runner);
 
   FilterThread * _filterThread;
   FilterContext _filterContext;
   gmic_library::gmic_list<float> * _gmicImages;
-  gmic_library::gmic_image<float> * _previewImage;
+  QImage _previewImage;
+  QSize _previewImageSize;
+  QSize _expectedPreviewSize;
+  QSize _fullResolutionPreviewSize; // Invalid unless the preview is computed at a reduced resolution
   QList<FilterThread *> _unfinishedAbortedThreads;
+  bool _executionQueued;
+  QHash<int, int> _inputLayerCounts; // Number of layers last fetched, per input mode
 
   unsigned int _previewRandomSeed;
   QStringList _gmicStatus;
@@ -161,7 +190,19 @@ private:
   QElapsedTimer _completedExecutionTime;
   qint64 _lastCompletedExecutionTime;
   std::deque<int> _lastFilterPreviewExecutionDurations;
+  PreviewScaleController _previewScaleController;
+  double _previewScale; // Resolution of the ongoing preview, relative to the displayed one
+  double _memoryPreviewScale; // Largest preview resolution admitted by the memory budget (see admitExecution())
+  QTimer _previewRefinementTimer;
   int _completeFullImageProcessingCount;
+  FilterThread * _speculativeThread;
+  FilterThread * _adoptedSpeculativeThread; // Finished when adopted, waiting for its queued completion
+  bool _speculativeThreadFinished;
+  QString _speculativeKey;
+  QSize _speculativeExpectedPreviewSize;
+  unsigned int _speculativeRandomSeed;
+  QElapsedTimer _speculativeExecutionTime;
+  QTimer _speculativeBudgetTimer;
   QVector<bool> _gmicStatusQuotedParameters;
 };
 
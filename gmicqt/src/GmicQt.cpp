@@ -41,6 +41,7 @@
 #include "Logger.h"
 #include "MainWindow.h"
 #include "Misc.h"
+#include "ResourceUsage.h"
 #include "Settings.h"
 #include "Widgets/InOutPanel.h"
 #include "Widgets/ProgressInfoWindow.h"
@@ -105,6 +106,16 @@ RunParameters lastAppliedFilterRunParameters(ReturnedRunParametersFlag flag)
   return parameters;
 }
 
+RunResources lastRunResources()
+{
+  return ResourceMeter::last();
+}
+
+std::list<RunResources> recentRunResources()
+{
+  return ResourceMeter::recent();
+}
+
 int run(UserInterfaceMode interfaceMode,                   //
         RunParameters parameters,                          //
         const std::list<InputMode> & disabledInputModes,   //
@@ -352,6 +363,7 @@ template void calibrateImage(gmic_library::gmic_image<unsigned char> & img, cons
 
 void convertGmicImageToQImage(const gmic_library::gmic_image<float> & in, QImage & out)
 {
+  TRACE_SPAN("Convert to QImage", "conversion");
   out = QImage(in.width(), in.height(), QImage::Format_RGB888);
 
   if (in.spectrum() >= 4 && out.format() != QImage::Format_ARGB32) {
@@ -479,6 +491,7 @@ void convertGmicImageToQImage(const gmic_library::gmic_image<float> & in, QImage
 
 void convertQImageToGmicImage(const QImage & in, gmic_library::gmic_image<float> & out)
 {
+  TRACE_SPAN("Convert from QImage", "conversion");
   Q_ASSERT_X(in.format() == QImage::Format_ARGB32 || in.format() == QImage::Format_RGB888, "convert", "bad input format");
 
   if (in.format() == QImage::Format_ARGB32) {
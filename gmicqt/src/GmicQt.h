@@ -121,6 +121,35 @@ enum class ReturnedRunParametersFlag
 
 RunParameters lastAppliedFilterRunParameters(ReturnedRunParametersFlag flag);
 
+/**
+ * Resources used by a filter execution.
+ *
+ * CPU time and memory are process-wide figures measured during the run, hence
+ * they include any concurrent activity. The peak memory delta is the growth of
+ * the resident set size (at its peak, when the process peak was reached during
+ * the run). The thread count is the number of threads available to the
+ * interpreter.
+ */
+struct RunResources {
+  std::string command;
+  bool failed = false;
+  bool aborted = false;
+  long long wallTimeMS = 0;
+  long long cpuTimeMS = 0;
+  unsigned long long inputBytes = 0;
+  unsigned long long outputBytes = 0;
+  long long peakMemoryDelta = 0;
+  int threadCount = 0;
+  bool concurrent = false; // Other runs were ongoing, process-wide figures (CPU time, memory) include them
+};
+
+/**
+ * Resources used by the last completed filter execution (of any kind:
+ * preview, full image, or headless), and by the most recent ones (oldest first).
+ */
+RunResources lastRunResources();
+std::list<RunResources> recentRunResources();
+
 /**
  * Function that should be called to launch the plugin from the host adaptation code.
  * @return The exit status of Qt's main event loop (QApplication::exec()).
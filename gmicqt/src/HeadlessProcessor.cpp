@@ -37,17 +37,12 @@
 #include "Logger.h"
 #include "Misc.h"
 #include "ParametersCache.h"
+#include "PerformanceStats.h"
 #include "Settings.h"
 #include "Updater.h"
 #include "Widgets/ProgressInfoWindow.h"
 #include "gmic.h"
 
-#ifdef _IS_WINDOWS_
-#include <windows.h>
-#include <process.h>
-#include <psapi.h>
-#endif
-
 namespace GmicQt
 {
 
@@ -149,9 +144,13 @@ void HeadlessProcessor::startProcessing()
   ParametersCache::load(true);
 
   _singleShotTimer.start();
+  PerformanceStats::beginRun(_filterName);
   _gmicImages->assign();
   gmic_list<char> imageNames;
-  GmicQtHost::getCroppedImages(*_gmicImages, imageNames, -1, -1, -1, -1, _inputMode);
+  {
+    TRACE_SPAN("Host fetch", "fetch");
+    GmicQtHost::getCroppedImages(*_gmicImages, imageNames, -1, -1, -1, -1, _inputMode);
+  }
   if (!_progressWindow) {
     GmicQtHost::showMessage(QString("G'MIC: %1 %2").arg(_command).arg(_arguments).toUtf8().constData());
   }
@@ -159,8 +158,9 @@ void HeadlessProcessor::startProcessing()
   env += QString(" _output_mode=%1").arg((int)_outputMode);
   env += QString(" _output_messages=%1").arg((int)Settings::outputMessageMode());
   _filterThread = new FilterThread(this, _command, _arguments, env);
-  _filterThread->swapImages(*_gmicImages);
+  _filterThread->giveImages(*_gmicImages);
   _filterThread->setImageNames(imageNames);
+  _filterThread->setBudgetPriority(ThreadBudget::Priority::Batch);
   _processingCompletedProperly = false;
   connect(_filterThread, &FilterThread::finished, this, &HeadlessProcessor::onProcessingFinished);
   _timer.setInterval(250);
@@ -196,25 +196,7 @@ void HeadlessProcessor::sendProgressInformation()
   }
   float progress = _filterThread->progress();
   int ms = _filterThread->duration();
-  unsigned long memory = 0;
-#if defined(_IS_UNIX_)
-  QFile status("/proc/self/status");
-  if (status.open(QFile::ReadOnly)) {
-    QByteArray text = status.readAll();
-    const char * str = strstr(text.constData(), "VmRSS:");
-    unsigned int kiB = 0;
-    if (str && sscanf(str + 7, "%u", &kiB)) {
-      memory = 1024 * (unsigned long)kiB;
-    }
-  }
-#elif defined(_IS_WINDOWS_)
-  PROCESS_MEMORY_COUNTERS counters;
-  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
-    memory = static_cast<unsigned long>(counters.WorkingSetSize);
-  }
-#else
-// TODO: MACOS
-#endif
+  const unsigned long memory = static_cast<unsigned long>(PerformanceStats::residentSetSize());
   emit progression(progress, ms, memory);
 }
 
@@ -229,8 +211,10 @@ void HeadlessProcessor::onProcessingFinished()
       errorMessage = tr("Filter execution failed, but with no error message.");
     }
   } else {
-    gmic_list<gmic_pixel_type> images = _filterThread->images();
+    gmic_list<gmic_pixel_type> images;
+    _filterThread->takeImages(images);
     if (!_filterThread->aborted()) {
+      TRACE_SPAN("Host output", "output");
       GmicQtHost::outputImages(images, _filterThread->imageNames(), _outputMode);
       _processingCompletedProperly = true;
     }
@@ -250,6 +234,7 @@ void HeadlessProcessor::onProcessingFinished()
   }
   _filterThread->deleteLater();
   _filterThread = nullptr;
+  PerformanceStats::endRun();
   endApplication(errorMessage);
 }
 
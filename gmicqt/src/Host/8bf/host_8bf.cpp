@@ -45,6 +45,8 @@
 #include "gmic.h"
 #include <lcms2.h>
 #include <QMainWindow>
+#include <QThread>
+#include <mutex>
 
 struct Gmic8bfLayer
 {
@@ -69,6 +71,9 @@ namespace host_8bf
     cmsContext lcmsContext;
     cmsHPROFILE imageProfile;
     cmsHPROFILE displayProfile;
+    // Previews are color corrected by the filter threads: displayProfile, fetchedDisplayProfileFromQtWidget,
+    // transform and transformFormat are protected by colorManagementMutex once the dialog is running.
+    std::mutex colorManagementMutex;
     bool fetchedDisplayProfileFromQtWidget;
     cmsHTRANSFORM transform;
     cmsUInt32Number transformFormat;
@@ -2299,6 +2304,103 @@ namespace
         }
 #endif
     }
+
+    // Spectrum of a preview image once converted by applyColorProfile().
+    int ColorCorrectedSpectrum(int spectrum)
+    {
+        if (host_8bf::grayScale)
+        {
+            return (spectrum == 3 || spectrum == 4) ? spectrum - 2 : spectrum;
+        }
+        return (spectrum == 1 || spectrum == 2) ? spectrum + 2 : spectrum;
+    }
+
+    // Must be called with colorManagementMutex locked.
+    cmsHTRANSFORM ColorTransformForSpectrum(int spectrum)
+    {
+#ifndef TYPE_GRAYA_FLT
+#define TYPE_GRAYA_FLT FLOAT_SH(1)|COLORSPACE_SH(PT_GRAY)|EXTRA_SH(1)|CHANNELS_SH(1)|BYTES_SH(4)
+#endif
+
+        cmsUInt32Number format = 0;
+        cmsUInt32Number transformFlags = cmsFLAGS_BLACKPOINTCOMPENSATION;
+
+        switch (spectrum)
+        {
+        case 1:
+            format = TYPE_GRAY_FLT;
+            break;
+        case 2:
+            format = TYPE_GRAYA_FLT;
+            transformFlags |= cmsFLAGS_COPY_ALPHA;
+            break;
+        case 3:
+            format = TYPE_RGB_FLT;
+            break;
+        case 4:
+            format = TYPE_RGBA_FLT;
+            transformFlags |= cmsFLAGS_COPY_ALPHA;
+            break;
+        }
+
+        if (format == 0)
+        {
+            return nullptr;
+        }
+
+        if (format != host_8bf::transformFormat)
+        {
+            host_8bf::transformFormat = format;
+
+            if (host_8bf::transform != nullptr)
+            {
+                cmsDeleteTransform(host_8bf::transform);
+            }
+
+            host_8bf::transform = cmsCreateTransformTHR(
+                host_8bf::lcmsContext,
+                host_8bf::imageProfile,
+                format,
+                host_8bf::displayProfile,
+                format,
+                INTENT_RELATIVE_COLORIMETRIC,
+                transformFlags);
+        }
+
+        return host_8bf::transform;
+    }
+
+    // Fetches the display profile of the monitor showing the dialog (QWidget::winId() must be called
+    // from the GUI thread) and builds the transform for the given spectrum, before a preview needs it.
+    void PrepareColorManagement(int spectrum)
+    {
+        if (host_8bf::lcmsContext == nullptr || host_8bf::imageProfile == nullptr || QThread::currentThread() != qApp->thread())
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(host_8bf::colorManagementMutex);
+
+        if (!host_8bf::fetchedDisplayProfileFromQtWidget && visibleMainWindow() != nullptr)
+        {
+            host_8bf::fetchedDisplayProfileFromQtWidget = true;
+
+            const cmsHPROFILE previousProfile = host_8bf::displayProfile;
+            FetchDisplayProfileFromQtWidget();
+
+            if (host_8bf::displayProfile != previousProfile && host_8bf::transform != nullptr)
+            {
+                cmsDeleteTransform(host_8bf::transform);
+                host_8bf::transform = nullptr;
+                host_8bf::transformFormat = 0;
+            }
+        }
+
+        if (host_8bf::displayProfile != nullptr)
+        {
+            ColorTransformForSpectrum(ColorCorrectedSpectrum(spectrum));
+        }
+    }
 }
 
 namespace GmicQtHost {
@@ -2391,6 +2493,12 @@ void getCroppedImages(gmic_list<float> & images, gmic_list<char> & imageNames, d
             images[i].assign(filteredLayers.at(i).imageData.get_crop(ix, iy, ix + iw, iy + ih));
         }
     }
+
+    if (layerCount > 0)
+    {
+        // Input images are fetched from the GUI thread, before the filter thread starts.
+        PrepareColorManagement(images[0].spectrum());
+    }
 }
 
 void outputImages(gmic_list<float> & images, const gmic_list<char> & imageNames, GmicQt::OutputMode /* mode */)
@@ -2482,6 +2590,8 @@ void applyColorProfile(gmic_library::gmic_image<gmic_pixel_type> & image)
         return;
     }
 
+    std::lock_guard<std::mutex> lock(host_8bf::colorManagementMutex);
+
     const bool performColorCorrection = host_8bf::lcmsContext != nullptr && host_8bf::imageProfile != nullptr && host_8bf::displayProfile != nullptr;
 
     if (host_8bf::grayScale)
@@ -2507,82 +2617,34 @@ void applyColorProfile(gmic_library::gmic_image<gmic_pixel_type> & image)
         return;
     }
 
-    if (!host_8bf::fetchedDisplayProfileFromQtWidget)
-    {
-        host_8bf::fetchedDisplayProfileFromQtWidget = true;
+    // The display profile of the dialog's monitor is fetched by PrepareColorManagement(), on the GUI thread.
+    const cmsHTRANSFORM transform = ColorTransformForSpectrum(image.spectrum());
 
-        FetchDisplayProfileFromQtWidget();
+    if (transform == nullptr)
+    {
+        image.cut(0, 255);
+        return;
     }
 
     gmic_library::gmic_image<gmic_pixel_type> corrected;
     image.get_permute_axes("cxyz").move_to(corrected) /= 255;
 
-#ifndef TYPE_GRAYA_FLT
-#define TYPE_GRAYA_FLT FLOAT_SH(1)|COLORSPACE_SH(PT_GRAY)|EXTRA_SH(1)|CHANNELS_SH(1)|BYTES_SH(4)
-#endif
-
-    cmsUInt32Number format = 0;
-    cmsUInt32Number transformFlags = cmsFLAGS_BLACKPOINTCOMPENSATION;
+    const cmsUInt64Number bytesPerLine64 = static_cast<cmsUInt64Number>(image.width()) * image.spectrum() * sizeof(gmic_pixel_type);
 
-    switch (image.spectrum())
+    if (bytesPerLine64 <= std::numeric_limits<cmsUInt32Number>::max())
     {
-    case 1:
-        format = TYPE_GRAY_FLT;
-        break;
-    case 2:
-        format = TYPE_GRAYA_FLT;
-        transformFlags |= cmsFLAGS_COPY_ALPHA;
-        break;
-    case 3:
-        format = TYPE_RGB_FLT;
-        break;
-    case 4:
-        format = TYPE_RGBA_FLT;
-        transformFlags |= cmsFLAGS_COPY_ALPHA;
-        break;
-    }
+        const cmsUInt64Number bytesPerLine = static_cast<cmsUInt32Number>(bytesPerLine64);
 
-    if (format != 0)
-    {
-        if (format != host_8bf::transformFormat)
-        {
-            host_8bf::transformFormat = format;
-
-            if (host_8bf::transform != nullptr)
-            {
-                cmsDeleteTransform(host_8bf::transform);
-            }
-
-            host_8bf::transform = cmsCreateTransformTHR(
-                host_8bf::lcmsContext,
-                host_8bf::imageProfile,
-                format,
-                host_8bf::displayProfile,
-                format,
-                INTENT_RELATIVE_COLORIMETRIC,
-                transformFlags);
-        }
-
-        if (host_8bf::transform != nullptr)
-        {
-            const cmsUInt64Number bytesPerLine64 = static_cast<cmsUInt64Number>(image.width()) * image.spectrum() * sizeof(gmic_pixel_type);
-
-            if (bytesPerLine64 <= std::numeric_limits<cmsUInt32Number>::max())
-            {
-                const cmsUInt64Number bytesPerLine = static_cast<cmsUInt32Number>(bytesPerLine64);
-
-                cmsDoTransformLineStride(
-                    host_8bf::transform,
-                    corrected.data(),
-                    corrected.data(),
-                    image.width(),
-                    image.height(),
-                    bytesPerLine,
-                    bytesPerLine,
-                    0,
-                    0);
-            }
-        }
+        cmsDoTransformLineStride(
+            transform,
+            corrected.data(),
+            corrected.data(),
+            image.width(),
+            image.height(),
+            bytesPerLine,
+            bytesPerLine,
+            0,
+            0);
     }
 
     (corrected.permute_axes("yzcx") *= 255).cut(0, 255).move_to(image);
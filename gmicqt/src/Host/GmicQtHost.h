@@ -84,6 +84,10 @@ void outputImages(gmic_library::gmic_list<gmic_pixel_type> & images, const gmic_
 /**
  * @brief Apply a color profile to a given image
  *
+ * Called from the preview filter threads, not from the GUI thread: several
+ * calls may run concurrently, and QWidgets must not be used (e.g. to find the
+ * monitor of the dialog, which should be done while fetching input images).
+ *
  * @param [in,out] images An image
  */
 void applyColorProfile(gmic_library::gmic_image<gmic_pixel_type> & images);
@@ -25,6 +25,8 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QFont>
@@ -35,8 +37,12 @@
 #include <QRegularExpression>
 #include <QVector>
 #include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include "GmicQt.h"
 #include "Host/GmicQtHost.h"
 #include "Host/None/ImageDialog.h"
@@ -50,10 +56,18 @@ namespace gmic_qt_standalone
 {
 
 QVector<QImage> input_images;
+QVector<gmic_library::gmic_image<float>> native_input_images; // Used instead of input_images[n] when not empty
 QVector<QString> current_image_filenames;
 QVector<QString> input_image_filenames;
 QString output_image_filename;
 int jpeg_quality = ImageDialog::UNSPECIFIED_JPEG_QUALITY;
+bool native_io = false;
+int input_bit_depth = 8;
+int output_bit_depth = 0; // 0 means same as input
+unsigned int raw_width = 0;
+unsigned int raw_height = 0;
+unsigned int raw_spectrum = 0;
+unsigned int encode_jobs = std::max(1u, std::thread::hardware_concurrency());
 
 QWidget * visibleMainWindow()
 {
@@ -75,6 +89,8 @@ void askForInputImageFilename()
   const QFileDialog::Options options = GmicQt::Settings::nativeFileDialogs() ? QFileDialog::Options() : QFileDialog::DontUseNativeDialog;
   QString filename = QFileDialog::getOpenFileName(mainWidget, QObject::tr("Select an image to open..."), ".", filters.join(";;"), nullptr, options);
   input_images.resize(1);
+  native_input_images.resize(1);
+  native_input_images.first().assign();
   current_image_filenames.resize(1);
   if (!filename.isEmpty() && QFileInfo(filename).isReadable() && input_images.first().load(filename)) {
     input_images.first() = input_images.first().convertToFormat(QImage::Format_ARGB32);
@@ -146,6 +162,124 @@ const QImage & inputImage(int n)
   }
 }
 
+bool isNativeInputImage(int n)
+{
+  return (n < native_input_images.size()) && !native_input_images[n].is_empty();
+}
+
+void inputImageSize(int n, int * width, int * height)
+{
+  if (isNativeInputImage(n)) {
+    *width = native_input_images[n].width();
+    *height = native_input_images[n].height();
+  } else {
+    *width = inputImage(n).width();
+    *height = inputImage(n).height();
+  }
+}
+
+/*
+ * Files handled by the CImg codecs, without any QImage conversion: the CImg
+ * formats and raw float dumps always, PNG files (up to 16 bits per channel)
+ * only with --native-io.
+ */
+bool usesNativeCodec(const QString & filename)
+{
+  const QString suffix = QFileInfo(filename).suffix().toLower();
+  return (suffix == "cimg") || (suffix == "cimgz") || (suffix == "raw") || (native_io && (suffix == "png"));
+}
+
+bool loadNativeImage(const QString & filename, gmic_library::gmic_image<float> & image)
+{
+  const QString suffix = QFileInfo(filename).suffix().toLower();
+  const QByteArray path = QFile::encodeName(filename);
+  try {
+    if (suffix == "raw") {
+      if (!raw_width || !raw_height || !raw_spectrum) {
+        std::cerr << "Option --raw-size is required to read " << filename.toStdString() << std::endl;
+        return false;
+      }
+      image.load_raw(path.constData(), raw_width, raw_height, 1, raw_spectrum);
+      return (image.size() == (size_t)raw_width * raw_height * raw_spectrum);
+    }
+    if (suffix == "png") {
+      unsigned int bits = 8;
+      image.load_png(path.constData(), &bits);
+      if (bits > 8) {
+        // Same 0..255 range as the 8-bit inputs, the precision is kept by floats
+        image /= 257.0f;
+        input_bit_depth = 16;
+      }
+      return !image.is_empty();
+    }
+    image.load_cimg(path.constData());
+  } catch (...) {
+    image.assign();
+  }
+  return !image.is_empty();
+}
+
+bool saveNativeImage(const gmic_library::gmic_image<float> & image, const QString & filename)
+{
+  const QString suffix = QFileInfo(filename).suffix().toLower();
+  const QByteArray path = QFile::encodeName(filename);
+  try {
+    if (suffix == "raw") {
+      image.save_raw(path.constData());
+    } else if (suffix == "png") {
+      const int depth = output_bit_depth ? output_bit_depth : input_bit_depth;
+      if (depth > 8) {
+        (image.get_cut(0.0f, 255.0f) *= 257.0f).save_png(path.constData(), 2);
+      } else {
+        image.get_cut(0.0f, 255.0f).save_png(path.constData(), 1);
+      }
+    } else {
+      image.save_cimg(path.constData(), suffix == "cimgz");
+    }
+  } catch (...) {
+    return false;
+  }
+  return true;
+}
+
+struct EncodeJob {
+  QString filename;
+  bool native = false;
+  bool ok = false;
+  QImage image;
+  qint64 bytes = 0;
+};
+
+/*
+ * Convert and encode the output layers, up to encode_jobs at once. Each job
+ * only writes its own entry, so results do not depend on the scheduling.
+ */
+void encodeLayers(const gmic_library::gmic_list<float> & images, std::vector<EncodeJob> & jobs)
+{
+  std::atomic<unsigned int> next(0);
+  auto worker = [&images, &jobs, &next]() {
+    for (unsigned int layer = next++; layer < jobs.size(); layer = next++) {
+      EncodeJob & job = jobs[layer];
+      if (job.native) {
+        job.ok = saveNativeImage(images[layer], job.filename);
+      } else {
+        GmicQt::convertGmicImageToQImage(images[layer], job.image);
+        job.ok = job.image.save(job.filename, nullptr, jpeg_quality);
+      }
+      job.bytes = job.ok ? QFileInfo(job.filename).size() : 0;
+    }
+  };
+  const unsigned int workers = std::min(encode_jobs, static_cast<unsigned int>(jobs.size()));
+  std::vector<std::thread> threads;
+  for (unsigned int n = 1; n < workers; ++n) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+}
+
 } // namespace gmic_qt_standalone
 
 namespace GmicQtHost
@@ -166,8 +300,7 @@ void getLayersExtent(int * width, int * height, GmicQt::InputMode)
       *height = 480;
     }
   } else {
-    *width = gmic_qt_standalone::input_images.first().width();
-    *height = gmic_qt_standalone::input_images.first().height();
+    gmic_qt_standalone::inputImageSize(0, width, height);
   }
 }
 
@@ -197,12 +330,23 @@ void getCroppedImages(gmic_library::gmic_list<float> & images, gmic_library::gmi
     QByteArray ba = name.toUtf8();
     gmic_library::gmic_image<char>::string(ba.constData()).move_to(imageNames[i]);
 
-    const QImage & input_image = gmic_qt_standalone::inputImage(i);
-    const int ix = static_cast<int>(entireImage ? 0 : std::floor(x * input_image.width()));
-    const int iy = static_cast<int>(entireImage ? 0 : std::floor(y * input_image.height()));
-    const int iw = entireImage ? input_image.width() : std::min(input_image.width() - ix, static_cast<int>(1 + std::ceil(width * input_image.width())));
-    const int ih = entireImage ? input_image.height() : std::min(input_image.height() - iy, static_cast<int>(1 + std::ceil(height * input_image.height())));
-    GmicQt::convertQImageToGmicImage(input_image.copy(ix, iy, iw, ih), images[i]);
+    int inputWidth = 0;
+    int inputHeight = 0;
+    gmic_qt_standalone::inputImageSize(i, &inputWidth, &inputHeight);
+    const int ix = static_cast<int>(entireImage ? 0 : std::floor(x * inputWidth));
+    const int iy = static_cast<int>(entireImage ? 0 : std::floor(y * inputHeight));
+    const int iw = entireImage ? inputWidth : std::min(inputWidth - ix, static_cast<int>(1 + std::ceil(width * inputWidth)));
+    const int ih = entireImage ? inputHeight : std::min(inputHeight - iy, static_cast<int>(1 + std::ceil(height * inputHeight)));
+    if (gmic_qt_standalone::isNativeInputImage(i)) {
+      const gmic_library::gmic_image<float> & input_image = gmic_qt_standalone::native_input_images[i];
+      if (entireImage) {
+        images[i].assign(input_image);
+      } else {
+        input_image.get_crop(ix, iy, ix + iw - 1, iy + ih - 1).move_to(images[i]);
+      }
+    } else {
+      GmicQt::convertQImageToGmicImage(gmic_qt_standalone::inputImage(i).copy(ix, iy, iw, ih), images[i]);
+    }
   }
 }
 
@@ -221,16 +365,19 @@ void outputImages(gmic_library::gmic_list<float> & images, const gmic_library::g
         dialog->exec();
         gmic_qt_standalone::input_images.resize(1);
         gmic_qt_standalone::input_images.first() = dialog->currentImage();
+        gmic_qt_standalone::native_input_images.resize(1);
+        gmic_qt_standalone::native_input_images.first().assign();
         gmic_qt_standalone::current_image_filenames.resize(1);
         gmic_qt_standalone::current_image_filenames.first() = gmic_qt_standalone::imageName((const char *)imageNames[dialog->currentImageIndex()]);
         delete dialog;
       }
     } else {
       gmic_qt_standalone::input_images.resize(images.size());
+      gmic_qt_standalone::native_input_images.resize(images.size());
       gmic_qt_standalone::current_image_filenames.resize(images.size());
       const unsigned int layerLimit = gmic_qt_standalone::output_image_filename.contains("%l") ? images.size() : 1;
+      std::vector<gmic_qt_standalone::EncodeJob> jobs(layerLimit);
       for (unsigned int layer = 0; layer < layerLimit; ++layer) {
-        GmicQt::convertGmicImageToQImage(images[layer], gmic_qt_standalone::input_images[layer]);
         QString outputFilename = gmic_qt_standalone::output_image_filename;
         if (outputFilename.contains("%b")) {
           const QString basename = QFileInfo(gmic_qt_standalone::input_image_filenames.first()).completeBaseName();
@@ -242,9 +389,35 @@ void outputImages(gmic_library::gmic_list<float> & images, const gmic_library::g
         }
         outputFilename.replace("%l", QString::number(layer));
         std::cout << "[gmic_qt] Writing output file for layer " << layer << ": " << outputFilename.toStdString() << std::endl;
-        gmic_qt_standalone::input_images[layer].save(outputFilename, nullptr, gmic_qt_standalone::jpeg_quality);
+        jobs[layer].filename = outputFilename;
+        jobs[layer].native = gmic_qt_standalone::usesNativeCodec(outputFilename);
+      }
+      QElapsedTimer timer;
+      timer.start();
+      gmic_qt_standalone::encodeLayers(images, jobs);
+      const qint64 elapsed = std::max<qint64>(1, timer.elapsed());
+      double megaPixels = 0.0;
+      qint64 bytes = 0;
+      for (unsigned int layer = 0; layer < layerLimit; ++layer) {
+        gmic_qt_standalone::EncodeJob & job = jobs[layer];
+        if (!job.ok) {
+          std::cerr << "[gmic_qt] Could not write " << job.filename.toStdString() << std::endl;
+        } else if (QFileInfo(job.filename).suffix().toLower() == "raw") {
+          std::cout << "[gmic_qt] Raw float data: " << images[layer].width() << "x" << images[layer].height() << "x" << images[layer].spectrum() << std::endl;
+        }
+        if (job.native) {
+          gmic_qt_standalone::native_input_images[layer].assign(images[layer]);
+          gmic_qt_standalone::input_images[layer] = QImage();
+        } else {
+          gmic_qt_standalone::native_input_images[layer].assign();
+          gmic_qt_standalone::input_images[layer] = job.image;
+        }
         gmic_qt_standalone::current_image_filenames[layer] = gmic_qt_standalone::imageName((const char *)imageNames[layer]);
+        megaPixels += images[layer].width() * (double)images[layer].height() / 1.0e6;
+        bytes += job.bytes;
       }
+      std::cout << "[gmic_qt] Encoded " << layerLimit << " layer(s), " << megaPixels << " MP, " << bytes / 1024 << " KiB in " << elapsed << " ms ("
+                << (1000.0 * megaPixels / elapsed) << " MP/s, " << std::min(gmic_qt_standalone::encode_jobs, layerLimit) << " thread(s))" << std::endl;
     }
   }
   unused(mode);
@@ -271,6 +444,13 @@ void usage(const std::string & argv0)
                "                                            %f will be replaced by the input filename (without path)\n"
                "                                            %l will be replaced by the layer number (0 is top layer)\n"
                "                        -q --quality NNN : JPEG quality of output file(s) in 0..100\n"
+               "                          -n --native-io : Read and write PNG files with the G'MIC codecs, keeping up to\n"
+               "                                           16 bits per channel (.cimg, .cimgz and .raw files always are)\n"
+               "                            -d --depth N : Bits per channel of PNG output files with --native-io, 8 or 16\n"
+               "                                           (default: 16 if an input file has 16 bits per channel)\n"
+               "                        --raw-size WxHxC : Size of .raw input files (planar 32-bit floats)\n"
+               "                           -j --jobs NNN : Number of output layers encoded concurrently\n"
+               "                                           (default: number of CPU cores)\n"
                "                             -r --repeat : Use last applied filter and parameters\n"
                "     -p --path FILTER_PATH | FILTER_NAME : Select filter\n"
                "                                           e.g. \"/Black & White/Charcoal\"\n"
@@ -292,6 +472,20 @@ inline bool loadImage(QImage & image, const QString & filename, int argc, char *
   QGuiApplication app(argc, argv);
   return image.load(filename);
 }
+
+bool loadInputImage(int n, const QString & filename, int argc, char * argv[])
+{
+  if (gmic_qt_standalone::usesNativeCodec(filename)) {
+    gmic_qt_standalone::input_images[n] = QImage();
+    return gmic_qt_standalone::loadNativeImage(filename, gmic_qt_standalone::native_input_images[n]);
+  }
+  gmic_qt_standalone::native_input_images[n].assign();
+  if (!loadImage(gmic_qt_standalone::input_images[n], filename, argc, argv)) {
+    return false;
+  }
+  gmic_qt_standalone::input_images[n] = gmic_qt_standalone::input_images[n].convertToFormat(QImage::Format_ARGB32);
+  return true;
+}
 } // namespace
 
 int main(int argc, char * argv[])
@@ -334,6 +528,36 @@ int main(int argc, char * argv[])
         std::cerr << "Missing argument for option " << arg.toStdString() << std::endl;
         return EXIT_FAILURE;
       }
+    } else if ((arg == "--native-io") || (arg == "-n")) {
+      gmic_qt_standalone::native_io = true;
+    } else if ((arg == "--depth") || (arg == "-d")) {
+      if (narg < argc - 1) {
+        ++narg;
+        gmic_qt_standalone::output_bit_depth = atoi(argv[narg]);
+        if ((gmic_qt_standalone::output_bit_depth != 8) && (gmic_qt_standalone::output_bit_depth != 16)) {
+          std::cerr << "Bit depth should be 8 or 16" << std::endl;
+          return EXIT_FAILURE;
+        }
+      } else {
+        std::cerr << "Missing argument for option " << arg.toStdString() << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--raw-size") {
+      if ((narg < argc - 1) &&
+          (std::sscanf(argv[narg + 1], "%ux%ux%u", &gmic_qt_standalone::raw_width, &gmic_qt_standalone::raw_height, &gmic_qt_standalone::raw_spectrum) == 3)) {
+        ++narg;
+      } else {
+        std::cerr << "Missing or invalid WxHxC size for option " << arg.toStdString() << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if ((arg == "--jobs") || (arg == "-j")) {
+      if (narg < argc - 1) {
+        ++narg;
+        gmic_qt_standalone::encode_jobs = static_cast<unsigned int>(std::max(1, atoi(argv[narg])));
+      } else {
+        std::cerr << "Missing argument for option " << arg.toStdString() << std::endl;
+        return EXIT_FAILURE;
+      }
     } else if ((arg == "--repeat") || (arg == "-r")) {
       repeat = true;
     } else if ((arg == "--command") || (arg == "-c")) {
@@ -426,12 +650,12 @@ int main(int argc, char * argv[])
   bool firstLaunch = true;
   if (layers) {
     gmic_qt_standalone::input_images.resize(filenames.size());
+    gmic_qt_standalone::native_input_images.resize(filenames.size());
     gmic_qt_standalone::current_image_filenames.resize(filenames.size());
     gmic_qt_standalone::input_image_filenames.resize(filenames.size());
     int n = 0;
     for (const QString & filename : filenames) {
-      if (loadImage(gmic_qt_standalone::input_images[n], filename, argc, argv)) {
-        gmic_qt_standalone::input_images[n] = gmic_qt_standalone::input_images[n].convertToFormat(QImage::Format_ARGB32);
+      if (loadInputImage(n, filename, argc, argv)) {
         gmic_qt_standalone::current_image_filenames[n] = QFileInfo(filename).fileName();
         gmic_qt_standalone::input_image_filenames[n] = gmic_qt_standalone::current_image_filenames[n];
       } else {
@@ -448,10 +672,10 @@ int main(int argc, char * argv[])
   } else {
     for (const QString & filename : filenames) {
       gmic_qt_standalone::input_images.resize(1);
+      gmic_qt_standalone::native_input_images.resize(1);
       gmic_qt_standalone::current_image_filenames.resize(1);
       gmic_qt_standalone::input_image_filenames.resize(1);
-      if (loadImage(gmic_qt_standalone::input_images.first(), filename, argc, argv)) {
-        gmic_qt_standalone::input_images.first() = gmic_qt_standalone::input_images.first().convertToFormat(QImage::Format_ARGB32);
+      if (loadInputImage(0, filename, argc, argv)) {
         gmic_qt_standalone::current_image_filenames.first() = QFileInfo(filename).fileName();
         gmic_qt_standalone::input_image_filenames.first() = gmic_qt_standalone::current_image_filenames.first();
         GmicQt::UserInterfaceMode uiMode;
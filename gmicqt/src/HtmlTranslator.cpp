@@ -26,14 +26,13 @@
 #include "HtmlTranslator.h"
 #include <QDebug>
 #include <QRegularExpression>
+#include <QTextDocument>
 #include "Common.h"
 #include "gmic.h"
 
 namespace GmicQt
 {
 
-QTextDocument HtmlTranslator::_document;
-
 QString HtmlTranslator::removeTags(QString str)
 {
   return str.remove(QRegularExpression("<[^>]*>"));
@@ -43,8 +42,10 @@ QString HtmlTranslator::removeTags(QString str)
 QString HtmlTranslator::html2txt(const QString & str, bool force)
 {
   if (force || hasHtmlEntities(str)) {
-    _document.setHtml(str);
-    return fromUtf8Escapes(_document.toPlainText());
+    // Filters and faves may be read by concurrent startup tasks
+    static thread_local QTextDocument document;
+    document.setHtml(str);
+    return fromUtf8Escapes(document.toPlainText());
   }
   return fromUtf8Escapes(str);
 }
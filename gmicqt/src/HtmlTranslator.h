@@ -26,7 +26,6 @@
 #define GMIC_QT_HTMLTRANSLATOR_H
 
 #include <QString>
-#include <QTextDocument>
 
 namespace GmicQt
 {
@@ -37,9 +36,6 @@ public:
   static QString html2txt(const QString & str, bool force = false);
   static bool hasHtmlEntities(const QString & str);
   static QString fromUtf8Escapes(const QString & str);
-
-private:
-  static QTextDocument _document;
 };
 
 } // namespace GmicQt
@@ -0,0 +1,184 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ImageBufferPool.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ImageBufferPool.h"
+#include <list>
+#include <map>
+#include <mutex>
+#include "gmic.h"
+
+namespace
+{
+
+struct SizeClass {
+  std::list<gmic_library::gmic_image<float>> buffers;
+  quint64 lastUse = 0; // Tick of the last time a buffer was taken or released
+};
+
+struct Pool {
+  std::mutex mutex;
+  std::map<size_t, SizeClass> classes; // Indexed by number of values
+  quint64 tick = 0;
+  quint64 capacity = GmicQt::ImageBufferPool::DefaultCapacity;
+  GmicQt::ImageBufferPool::Counters counters;
+};
+
+Pool & pool()
+{
+  static Pool instance;
+  return instance;
+}
+
+} // namespace
+
+namespace GmicQt
+{
+
+const quint64 ImageBufferPool::DefaultCapacity;
+
+void ImageBufferPool::assign(gmic_library::gmic_image<float> & image, int width, int height, int depth, int spectrum)
+{
+  const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) * static_cast<size_t>(spectrum);
+  if (!size) {
+    release(image);
+    return;
+  }
+  Pool & p = pool();
+  if (image.size() == size && !image.is_shared()) {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    ++p.counters.requests;
+    ++p.counters.hits;
+  } else {
+    release(image);
+    std::lock_guard<std::mutex> lock(p.mutex);
+    ++p.counters.requests;
+    auto it = p.classes.find(size);
+    if (it != p.classes.end()) {
+      image.swap(it->second.buffers.back());
+      it->second.buffers.pop_back();
+      if (it->second.buffers.empty()) {
+        p.classes.erase(it);
+      } else {
+        it->second.lastUse = ++p.tick;
+      }
+      p.counters.pooledBytes -= size * sizeof(float);
+      ++p.counters.hits;
+    }
+  }
+  image.assign(width, height, depth, spectrum); // No allocation if sizes match
+}
+
+void ImageBufferPool::release(gmic_library::gmic_image<float> & image)
+{
+  if (image.is_empty() || image.is_shared()) {
+    image.assign();
+    return;
+  }
+  const size_t size = image.size();
+  const quint64 bytes = size * sizeof(float);
+  std::list<gmic_library::gmic_image<float>> discarded;
+  {
+    Pool & p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    ++p.counters.releases;
+    // Make room by evicting the least recently used size classes. The incoming buffer is
+    // the most recently used one, so it is only discarded when no other class is left.
+    while ((p.counters.pooledBytes + bytes > p.capacity) && (bytes <= p.capacity)) {
+      auto lru = p.classes.end();
+      for (auto it = p.classes.begin(); it != p.classes.end(); ++it) {
+        if ((it->first != size) && ((lru == p.classes.end()) || (it->second.lastUse < lru->second.lastUse))) {
+          lru = it;
+        }
+      }
+      if (lru == p.classes.end()) {
+        break;
+      }
+      p.counters.pooledBytes -= lru->first * sizeof(float) * lru->second.buffers.size();
+      p.counters.discards += lru->second.buffers.size();
+      discarded.splice(discarded.end(), lru->second.buffers);
+      p.classes.erase(lru);
+    }
+    if (p.counters.pooledBytes + bytes > p.capacity) {
+      ++p.counters.discards;
+      discarded.push_back(gmic_library::gmic_image<float>());
+      discarded.back().swap(image);
+    } else {
+      SizeClass & sizeClass = p.classes[size];
+      sizeClass.buffers.push_back(gmic_library::gmic_image<float>());
+      sizeClass.buffers.back().swap(image);
+      sizeClass.lastUse = ++p.tick;
+      p.counters.pooledBytes += bytes;
+      if (p.counters.pooledBytes > p.counters.peakPooledBytes) {
+        p.counters.peakPooledBytes = p.counters.pooledBytes;
+      }
+    }
+  } // Discarded buffers (if any) are freed outside of the lock
+}
+
+void ImageBufferPool::release(gmic_library::gmic_list<float> & images)
+{
+  for (unsigned int i = 0; i < images.size(); ++i) {
+    release(images[i]);
+  }
+  images.assign();
+}
+
+void ImageBufferPool::setCapacity(quint64 bytes)
+{
+  std::map<size_t, SizeClass> discarded;
+  {
+    Pool & p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    p.capacity = bytes;
+    if (p.counters.pooledBytes > bytes) {
+      discarded.swap(p.classes);
+      p.counters.pooledBytes = 0;
+    }
+  }
+}
+
+quint64 ImageBufferPool::capacity()
+{
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  return p.capacity;
+}
+
+void ImageBufferPool::clear()
+{
+  std::map<size_t, SizeClass> discarded;
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  discarded.swap(p.classes);
+  p.counters.pooledBytes = 0;
+}
+
+ImageBufferPool::Counters ImageBufferPool::counters()
+{
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  return p.counters;
+}
+
+} // namespace GmicQt
@@ -0,0 +1,80 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ImageBufferPool.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_IMAGEBUFFERPOOL_H
+#define GMIC_QT_IMAGEBUFFERPOOL_H
+
+#include <QtGlobal>
+
+namespace gmic_library
+{
+template <typename T> struct gmic_image;
+template <typename T> struct gmic_list;
+} // namespace gmic_library
+
+namespace GmicQt
+{
+
+/**
+ * Pool of float pixel buffers recycled by the preview path.
+ *
+ * Buffers are classified by their exact number of values (a gmic_image only
+ * reuses its buffer when assigned with the same size), so that repeated
+ * previews of the same area do not allocate new buffers. When a released
+ * buffer would exceed the capacity, the least recently used size classes
+ * are freed to make room for it. All methods are thread-safe.
+ */
+class ImageBufferPool {
+public:
+  ImageBufferPool() = delete;
+
+  struct Counters {
+    quint64 requests = 0;
+    quint64 hits = 0;
+    quint64 releases = 0;
+    quint64 discards = 0;
+    quint64 pooledBytes = 0;
+    quint64 peakPooledBytes = 0;
+  };
+
+  /**
+   * Same as image.assign(width, height, depth, spectrum), except that the
+   * buffer is taken from the pool when possible. Current buffer of the image
+   * is released to the pool beforehand. Pixel values are not initialized.
+   */
+  static void assign(gmic_library::gmic_image<float> & image, int width, int height, int depth, int spectrum);
+  static void release(gmic_library::gmic_image<float> & image);
+  static void release(gmic_library::gmic_list<float> & images);
+
+  static void setCapacity(quint64 bytes);
+  static quint64 capacity();
+  static void clear();
+  static Counters counters();
+
+  static const quint64 DefaultCapacity = 256 * 1024 * 1024;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_IMAGEBUFFERPOOL_H
@@ -26,7 +26,10 @@
 #include <QDebug>
 #include <QImage>
 #include <QPainter>
+#include <vector>
 #include "GmicStdlib.h"
+#include "Host/GmicQtHost.h"
+#include "Tracer.h"
 #include "gmic.h"
 
 /*
@@ -34,24 +37,61 @@
  * of the GTK version of the gmic plug-in for GIMP by David Tschumperl\'e.
  */
 
-namespace GmicQt
+namespace
 {
 
-void buildPreviewImage(const gmic_library::gmic_list<float> & images, gmic_library::gmic_image<float> & result)
+inline int toByte(float value)
 {
-  gmic_library::gmic_list<gmic_pixel_type> preview_input_images;
-  if (images.size() > 0) {
-    preview_input_images.push_back(images[0]);
-    int spectrum = 0;
-    cimglist_for(preview_input_images, l) { spectrum = std::max(spectrum, preview_input_images[l].spectrum()); }
-    spectrum += (spectrum == 1 || spectrum == 3);
-    cimglist_for(preview_input_images, l) { calibrateImage(preview_input_images[l], spectrum, true); }
-    result.swap(preview_input_images.front());
-  } else {
-    result.assign();
+  return (value <= 0.0f) ? 0 : ((value >= 255.0f) ? 255 : static_cast<int>(value));
+}
+
+void convertToDisplayImage(const gmic_library::gmic_image<float> & image, const QSize & size, QImage & out)
+{
+  const int spectrum = image.spectrum();
+  const bool alpha = (spectrum == 2) || (spectrum == 4);
+  const int width = size.width();
+  const int height = size.height();
+  out = QImage(width, height, alpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+  std::vector<int> xOffsets(width);
+  for (int x = 0; x < width; ++x) {
+    xOffsets[x] = static_cast<int>((static_cast<long long>(x) * image.width()) / width);
+  }
+  const float * c0 = image.data(0, 0, 0, 0);
+  const float * c1 = (spectrum > 1) ? image.data(0, 0, 0, 1) : c0;
+  const float * c2 = (spectrum > 2) ? image.data(0, 0, 0, 2) : c0;
+  const float * c3 = (spectrum > 3) ? image.data(0, 0, 0, 3) : c0;
+  uchar * bits = out.bits();
+  const size_t bytesPerLine = static_cast<size_t>(out.bytesPerLine());
+  cimg_pragma_openmp(parallel for cimg_openmp_if_size(width * height, 128 * 128))
+  for (int y = 0; y < height; ++y) {
+    const size_t rowOffset = static_cast<size_t>((static_cast<long long>(y) * image.height()) / height) * image.width();
+    QRgb * line = reinterpret_cast<QRgb *>(bits + y * bytesPerLine);
+    for (int x = 0; x < width; ++x) {
+      const size_t offset = rowOffset + xOffsets[x];
+      switch (spectrum) {
+      case 1: {
+        const int v = toByte(c0[offset]);
+        line[x] = qRgb(v, v, v);
+      } break;
+      case 2: {
+        const int v = toByte(c0[offset]);
+        line[x] = qPremultiply(qRgba(v, v, v, toByte(c1[offset])));
+      } break;
+      case 3:
+        line[x] = qRgb(toByte(c0[offset]), toByte(c1[offset]), toByte(c2[offset]));
+        break;
+      default:
+        line[x] = qPremultiply(qRgba(toByte(c0[offset]), toByte(c1[offset]), toByte(c2[offset]), toByte(c3[offset])));
+      }
+    }
   }
 }
 
+} // namespace
+
+namespace GmicQt
+{
+
 bool checkImageSpectrumAtMost4(const gmic_library::gmic_list<float> & images, unsigned int & index)
 {
   for (unsigned int i = 0; i < images.size(); ++i) {
@@ -63,6 +103,38 @@ bool checkImageSpectrumAtMost4(const gmic_library::gmic_list<float> & images, un
   return true;
 }
 
+void finalizePreview(gmic_library::gmic_list<float> & images, const QSize & expectedSize, const QSize & areaSize, PreviewResult & result, const QSize & upscaledSize)
+{
+  result = PreviewResult();
+  if (!checkImageSpectrumAtMost4(images, result.badSpectrumIndex)) {
+    result.badSpectrum = images[result.badSpectrumIndex].spectrum();
+    return;
+  }
+  result.valid = true;
+  if (!images.size() || images[0].is_empty()) {
+    return;
+  }
+  gmic_library::gmic_image<float> & image = images[0];
+  {
+    TRACE_SPAN("Colour profile", "calibration");
+    GmicQtHost::applyColorProfile(image);
+  }
+  result.imageSize = QSize(image.width(), image.height());
+  if (upscaledSize.isValid() && (result.imageSize == expectedSize) && (upscaledSize != expectedSize)) {
+    TRACE_SPAN("Build display image", "calibration");
+    convertToDisplayImage(image, result.imageSize, result.displayImage);
+    result.displayImage = result.displayImage.scaled(upscaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    result.imageSize = upscaledSize;
+    return;
+  }
+  QSize displaySize = result.imageSize;
+  if ((displaySize != expectedSize) && !areaSize.isEmpty()) {
+    displaySize = displaySize.scaled(areaSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+  }
+  TRACE_SPAN("Build display image", "calibration");
+  convertToDisplayImage(image, displaySize, result.displayImage);
+}
+
 template <typename T> bool hasAlphaChannel(const gmic_library::gmic_image<T> & image)
 {
   return image.spectrum() == 2 || image.spectrum() == 4;
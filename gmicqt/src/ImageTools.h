@@ -25,6 +25,8 @@
 #ifndef GMIC_QT_IMAGETOOLS_H
 #define GMIC_QT_IMAGETOOLS_H
 
+#include <QImage>
+#include <QSize>
 #include "Common.h"
 #include "GmicQt.h"
 
@@ -37,8 +39,29 @@ template <typename T> struct gmic_list;
 namespace GmicQt
 {
 
+struct PreviewResult {
+  bool valid = false;
+  QImage displayImage; // Display-sized, premultiplied if it has an alpha channel
+  QSize imageSize;     // Size of the filter output image
+  unsigned int badSpectrumIndex = 0;
+  int badSpectrum = 0;
+};
+
 bool checkImageSpectrumAtMost4(const gmic_library::gmic_list<float> & images, unsigned int & index);
-void buildPreviewImage(const gmic_library::gmic_list<float> & images, gmic_library::gmic_image<float> & result);
+
+/**
+ * Turn the output of a preview run into the image displayed by the preview
+ * widget, in a single (row-parallel) pass: colour profile, then sampling of
+ * the first image at display size and conversion to a QImage.
+ *
+ * The display size is the size of the output if it matches the expected
+ * preview size, otherwise the output size scaled to fit the preview area.
+ * If the preview was computed at a reduced resolution, \a upscaledSize is the
+ * expected size at full resolution: an output of the expected size is then
+ * upsampled to it, and reported as having this size.
+ * May be called from a worker thread.
+ */
+void finalizePreview(gmic_library::gmic_list<float> & images, const QSize & expectedSize, const QSize & areaSize, PreviewResult & result, const QSize & upscaledSize = QSize());
 
 template <typename T> bool hasAlphaChannel(const gmic_library::gmic_image<T> & image);
 
@@ -26,6 +26,7 @@
 #include <QDebug>
 #include "Common.h"
 #include "Host/GmicQtHost.h"
+#include "PerformanceStats.h"
 
 namespace GmicQt
 {
@@ -43,7 +44,9 @@ QSize LayersExtentProxy::getExtent(InputMode mode)
 
 void LayersExtentProxy::getExtent(InputMode mode, int & width, int & height)
 {
-  if (mode != _inputMode || _width == -1 || _height == -1) {
+  const bool hit = (mode == _inputMode) && (_width != -1) && (_height != -1);
+  PerformanceStats::recordCacheAccess(PerformanceStats::Cache::LayersExtent, hit);
+  if (!hit) {
     GmicQtHost::getLayersExtent(&_width, &_height, mode);
     width = _width;
     height = _height;
@@ -50,8 +50,10 @@
 #include "GmicStdlib.h"
 #include "HtmlTranslator.h"
 #include "IconLoader.h"
+#include "ImageBufferPool.h"
 #include "LayersExtentProxy.h"
 #include "Logger.h"
+#include "MemoryEstimator.h"
 #include "Misc.h"
 #include "ParametersCache.h"
 #include "PersistentMemory.h"
@@ -80,17 +82,36 @@ namespace GmicQt
 
 bool MainWindow::_isAccepted = false;
 
+namespace
+{
+InputOutputState savedInputOutputState(const FiltersPresenter::Filter & filter)
+{
+  InputOutputState inOutState = ParametersCache::getInputOutputState(filter.hash);
+  if (inOutState.inputMode == InputMode::Unspecified) {
+    if ((filter.defaultInputMode != InputMode::Unspecified)) {
+      inOutState.inputMode = filter.defaultInputMode;
+    } else {
+      inOutState.inputMode = DefaultInputMode;
+    }
+  }
+  return inOutState;
+}
+} // namespace
+
 //
 // TODO : Handle window maximization properly (Windows as well as some Linux desktops)
 //
 
 MainWindow::MainWindow(QWidget * parent) : QMainWindow(parent), ui(new Ui::MainWindow)
 {
+  _startupTime.start();
   TIMING;
   ui->setupUi(this);
   TIMING;
   _messageTimerID = 0;
   _gtkFavesShouldBeImported = false;
+  _speculativePreviewTimer.setSingleShot(true);
+  _speculativePreviewTimer.setInterval(SPECULATIVE_PREVIEW_DELAY_MS);
 
   _lastExecutionOK = true; // Overwritten by loadSettings()
   _expandCollapseIcon = nullptr;
@@ -216,8 +237,11 @@ MainWindow::MainWindow(QWidget * parent) : QMainWindow(parent), ui(new Ui::MainW
   ui->progressInfoWidget->setGmicProcessor(&_processor);
 
   loadSettings();
-  ParametersCache::load(!_newSession);
-  FilterGuiDynamismCache::load();
+  // Caches are loaded while the window is built, they are waited for on first show
+  const bool loadFiltersParameters = !_newSession;
+  _startupTasks.start("Load parameters cache", [loadFiltersParameters]() { ParametersCache::load(loadFiltersParameters); });
+  _startupTasks.start("Load GUI dynamism cache", []() { FilterGuiDynamismCache::load(); });
+  _startupTasks.start("Load memory estimates", []() { MemoryEstimator::load(); });
   setIcons();
   QAction * escAction = new QAction(this);
   escAction->setShortcut(QKeySequence(Qt::Key_Escape));
@@ -266,9 +290,11 @@ MainWindow::MainWindow(QWidget * parent) : QMainWindow(parent), ui(new Ui::MainW
 
 MainWindow::~MainWindow()
 {
+  _startupTasks.waitAll();
   saveCurrentParameters();
   ParametersCache::save();
   FilterGuiDynamismCache::save();
+  MemoryEstimator::save();
   saveSettings();
   Logger::setMode(Logger::Mode::StandardOutput); // Close log file, if necessary
   delete ui;
@@ -399,11 +425,13 @@ void MainWindow::onUpdateDownloadsFinished(int status)
 void MainWindow::buildFiltersTree()
 {
   saveCurrentParameters();
-  GmicStdLib::Array = Updater::getInstance()->buildFullStdlib();
   const bool withVisibility = filtersSelectionMode();
   _filtersPresenter->clear();
-  _filtersPresenter->readFilters();
-  _filtersPresenter->readFaves();
+  // Faves are read while the stdlib is built, filters need the stdlib
+  _startupTasks.start("Build stdlib", []() { GmicStdLib::Array = Updater::getInstance()->buildFullStdlib(); });
+  _startupTasks.start("Read faves", [this]() { _filtersPresenter->readFaves(); });
+  _startupTasks.start("Read filters", [this]() { _filtersPresenter->readFilters(); }, {"Build stdlib"});
+  _startupTasks.waitAll();
   _filtersPresenter->restoreFaveHashLinksAfterCaseChange(); // TODO : Remove, some day!
   if (_gtkFavesShouldBeImported) {
     _filtersPresenter->importGmicGTKFaves();
@@ -525,6 +553,7 @@ void MainWindow::onStartupFiltersUpdateFinished(int status)
 
   buildFiltersTree();
   ui->searchField->setFocus();
+  Logger::log(QString("Filters tree ready after %1 ms").arg(_startupTime.elapsed()), "startup");
 
   // Let the standalone version load an image, if necessary (not pretty)
   if (GmicQtHost::ApplicationName.isEmpty()) {
@@ -550,6 +579,7 @@ void MainWindow::onStartupFiltersUpdateFinished(int status)
     _filtersPresenter->adjustViewSize();
     ui->previewWidget->setPreviewFactor(PreviewFactorFullImage, true);
     setNoFilter();
+    _startupTime.invalidate(); // No preview to wait for
   } else {
     _filtersPresenter->adjustViewSize();
     activateFilter(true, pluginParametersCommandArguments);
@@ -590,6 +620,60 @@ void MainWindow::onFilterSelectionChanged()
   ui->previewWidget->sendUpdateRequest();
 }
 
+void MainWindow::onFilterHighlighted(const QString & hash)
+{
+  _highlightedFilterHash = hash;
+  _speculativePreviewTimer.start();
+}
+
+void MainWindow::startSpeculativePreview()
+{
+  const QString hash = _highlightedFilterHash;
+  _highlightedFilterHash.clear();
+  if (hash.isEmpty() || (hash == _filtersPresenter->currentFilter().hash) || !ui->cbPreview->isChecked() || !_processor.isIdle()) {
+    return;
+  }
+  FiltersPresenter::Filter filter;
+  if (!_filtersPresenter->filterFromHash(hash, filter) || filter.isNoPreviewFilter() || filter.previewFromFullImage || //
+      (filter.previewFactor != ui->previewWidget->previewFactor())) {
+    return;
+  }
+  QString error;
+  QVector<bool> quoted;
+  QList<QString> values = FilterParametersWidget::defaultParameterList(filter.parameters, &error, &quoted, nullptr);
+  if (!error.isEmpty()) {
+    return;
+  }
+  QList<QString> savedValues = ParametersCache::getValues(filter.hash);
+  if (savedValues.isEmpty() && filter.isAFave) {
+    savedValues = filter.defaultParameterValues;
+  }
+  if (!savedValues.isEmpty()) {
+    if (savedValues.size() != values.size()) {
+      return;
+    }
+    values = savedValues;
+  }
+  GmicProcessor::FilterContext context;
+  context.requestType = GmicProcessor::FilterContext::RequestType::Preview;
+  GmicProcessor::FilterContext::VisibleRect & rect = context.visibleRect;
+  ui->previewWidget->normalizedVisibleRect(rect.x, rect.y, rect.w, rect.h);
+  context.inputOutputState = savedInputOutputState(filter);
+  ui->previewWidget->getPositionStringCorrection(context.positionStringCorrection.xFactor, context.positionStringCorrection.yFactor);
+  context.zoomFactor = ui->previewWidget->currentZoomFactor();
+  context.previewWindowWidth = ui->previewWidget->width();
+  context.previewWindowHeight = ui->previewWidget->height();
+  context.previewTimeout = Settings::previewTimeout();
+  context.previewLatencyTarget = Settings::previewLatencyTarget();
+  context.filterHash = filter.hash;
+  context.filterCommand = filter.previewCommand;
+  context.filterArguments = flattenGmicParameterList(values, quoted);
+  context.previewFromFullImage = filter.previewFromFullImage;
+  context.previewCheckBox = true;
+  context.randomized = false;
+  _processor.speculate(context);
+}
+
 void MainWindow::onEscapeKeyPressed()
 {
   ui->searchField->clear();
@@ -666,6 +750,8 @@ void MainWindow::makeConnections()
   connect(ui->previewWidget, &PreviewWidget::zoomChanged, this, &MainWindow::updateZoomLabel);
   connect(ui->previewWidget, &PreviewWidget::previewVisibleRectIsChanging, &_processor, &GmicProcessor::cancel);
   connect(_filtersPresenter, &FiltersPresenter::filterSelectionChanged, this, &MainWindow::onFilterSelectionChanged);
+  connect(_filtersPresenter, &FiltersPresenter::filterHighlighted, this, &MainWindow::onFilterHighlighted);
+  connect(&_speculativePreviewTimer, &QTimer::timeout, this, &MainWindow::startSpeculativePreview);
   connect(ui->pbOk, &QPushButton::clicked, this, &MainWindow::onOkClicked);
   connect(ui->pbClose, &QPushButton::clicked, this, &MainWindow::close);
   connect(ui->pbApply, &QPushButton::clicked, this, &MainWindow::onApplyClicked);
@@ -693,6 +779,7 @@ void MainWindow::makeConnections()
   connect(ui->progressInfoWidget, &ProgressInfoWidget::canceled, this, &MainWindow::onProgressionWidgetCancelClicked);
   connect(ui->tbSelectionMode, &QToolButton::toggled, this, &MainWindow::onFiltersSelectionModeToggled);
   connect(&_processor, &GmicProcessor::previewImageAvailable, this, &MainWindow::onPreviewImageAvailable);
+  connect(&_processor, &GmicProcessor::previewRefinementRequested, this, &MainWindow::onPreviewRefinementRequested);
   connect(&_processor, &GmicProcessor::guiDynamismRunDone, this, &MainWindow::onGUIDynamismRunDone);
   connect(&_processor, &GmicProcessor::previewCommandFailed, this, &MainWindow::onPreviewError);
   connect(&_processor, &GmicProcessor::fullImageProcessingFailed, this, &MainWindow::onFullImageProcessingError);
@@ -708,7 +795,12 @@ void MainWindow::onPreviewUpdateRequested()
   onPreviewUpdateRequested(false);
 }
 
-void MainWindow::onPreviewUpdateRequested(bool synchronous, bool randomized)
+void MainWindow::onPreviewRefinementRequested()
+{
+  onPreviewUpdateRequested(false, false, true);
+}
+
+void MainWindow::onPreviewUpdateRequested(bool synchronous, bool randomized, bool fullResolution)
 {
   const FiltersPresenter::Filter currentFilter = _filtersPresenter->currentFilter();
   if (currentFilter.isNoPreviewFilter()) {
@@ -737,6 +829,8 @@ void MainWindow::onPreviewUpdateRequested(bool synchronous, bool randomized)
   context.previewWindowWidth = ui->previewWidget->width();
   context.previewWindowHeight = ui->previewWidget->height();
   context.previewTimeout = Settings::previewTimeout();
+  context.previewLatencyTarget = Settings::previewLatencyTarget();
+  context.fullResolutionPreview = fullResolution;
   // context.filterName = currentFilter.plainTextName; // Unused in this context
   context.filterHash = currentFilter.hash;
   context.filterCommand = currentFilter.previewCommand;
@@ -786,9 +880,13 @@ void MainWindow::onPreviewImageAvailable()
   if (ui->filterParams->hasKeypoints()) {
     ui->previewWidget->setKeypoints(ui->filterParams->keypoints());
   }
-  ui->previewWidget->setPreviewImage(_processor.previewImage());
+  ui->previewWidget->setPreviewImage(_processor.previewImage(), _processor.previewImageSize());
   ui->previewWidget->enableRightClick();
   ui->tbUpdateFilters->setEnabled(true);
+  if (_startupTime.isValid()) {
+    Logger::log(QString("Time to first preview: %1 ms").arg(_startupTime.elapsed()), "startup");
+    _startupTime.invalidate();
+  }
 }
 
 void MainWindow::onGUIDynamismRunDone()
@@ -880,6 +978,7 @@ void MainWindow::onInputModeChanged(InputMode mode)
 void MainWindow::onVeryFirstShowEvent()
 {
   adjustVerticalSplitter();
+  _startupTasks.waitAll(); // Before the log output may change
   if (_newSession) {
     Logger::clear();
   }
@@ -893,6 +992,7 @@ void MainWindow::onVeryFirstShowEvent()
   }
   const bool useNetwork = (ageLimit != INTERNET_NEVER_UPDATE_PERIODICITY);
   ui->progressInfoWidget->startFiltersUpdateAnimationAndShow();
+  ui->progressInfoWidget->updatePerformancePanelVisibility();
   Updater::getInstance()->startUpdate(ageLimit, 4, useNetwork);
 }
 
@@ -1265,14 +1365,7 @@ void MainWindow::activateFilter(bool resetZoom, const QList<QString> & values)
     ui->inOutSelector->hide();
   }
 
-  InputOutputState inOutState = ParametersCache::getInputOutputState(filter.hash);
-  if (inOutState.inputMode == InputMode::Unspecified) {
-    if ((filter.defaultInputMode != InputMode::Unspecified)) {
-      inOutState.inputMode = filter.defaultInputMode;
-    } else {
-      inOutState.inputMode = DefaultInputMode;
-    }
-  }
+  InputOutputState inOutState = savedInputOutputState(filter);
 
   // Take plugin parameters into account
   if (_pluginParameters.inputMode != InputMode::Unspecified) {
@@ -1407,6 +1500,7 @@ void MainWindow::onSettingsClicked()
 
   DialogSettings dialog(this);
   dialog.exec();
+  ui->progressInfoWidget->updatePerformancePanelVisibility();
   bool previewPositionChanged = (_previewPosition != Settings::previewPosition());
   setPreviewPosition(Settings::previewPosition());
   if (previewPositionChanged) {
@@ -1550,6 +1644,7 @@ void MainWindow::closeEvent(QCloseEvent * e)
     _processor.disconnect(this);
     _processor.cancel();
     _processor.detachAllUnfinishedAbortedThreads();
+    ImageBufferPool::clear();
     e->accept();
     return;
   }
@@ -1561,6 +1656,7 @@ void MainWindow::closeEvent(QCloseEvent * e)
     e->ignore();
     return;
   }
+  ImageBufferPool::clear();
   e->accept();
 }
 
@@ -25,6 +25,7 @@
 #ifndef GMIC_QT_MAINWINDOW_H
 #define GMIC_QT_MAINWINDOW_H
 
+#include <QElapsedTimer>
 #include <QIcon>
 #include <QList>
 #include <QMainWindow>
@@ -33,6 +34,7 @@
 #include <QWidget>
 #include "Common.h"
 #include "GmicProcessor.h"
+#include "StartupTasks.h"
 #include "Widgets/PreviewWidget.h"
 class QResizeEvent;
 
@@ -80,7 +82,8 @@ public slots:
   void onUpdateDownloadsFinished(int status);
   void onApplyClicked();
   void onProgressionWidgetCancelClicked();
-  void onPreviewUpdateRequested(bool synchronous, bool randomized = false);
+  void onPreviewUpdateRequested(bool synchronous, bool randomized = false, bool fullResolution = false);
+  void onPreviewRefinementRequested();
   void onPreviewUpdateRequested();
   void onPreviewKeypointsEvent(unsigned int flags, unsigned long time);
   void onFullImageProcessingDone();
@@ -105,6 +108,7 @@ public slots:
   void onFiltersSelectionModeToggled(bool);
   void onPreviewCheckBoxToggled(bool);
   void onFilterSelectionChanged();
+  void onFilterHighlighted(const QString & hash);
   void onEscapeKeyPressed();
   void onPreviewImageAvailable();
   void onGUIDynamismRunDone();
@@ -152,6 +156,7 @@ private:
   void abortProcessingOnCloseRequest();
   void selectPreviewType(PreviewWidget::PreviewType previewType);
   void switchPreviewType();
+  void startSpeculativePreview();
   enum class ProcessingAction
   {
     NoAction,
@@ -181,6 +186,10 @@ private:
   RunParameters _pluginParameters;
   VisibleTagSelector * _visibleTagSelector;
   QString _forceQuitText;
+  QTimer _speculativePreviewTimer; // Delays the speculative preview of a highlighted filter
+  QString _highlightedFilterHash;
+  StartupTasks _startupTasks;
+  QElapsedTimer _startupTime; // Invalidated once the first preview is displayed
 };
 
 } // namespace GmicQt
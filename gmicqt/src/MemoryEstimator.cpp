@@ -0,0 +1,194 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file MemoryEstimator.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "MemoryEstimator.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstdio>
+#include <cstring>
+#include "Common.h"
+#include "Globals.h"
+#include "Logger.h"
+#include "Utils.h"
+
+#if defined(_IS_MACOS_)
+#include <mach/mach.h>
+#elif defined(_IS_WINDOWS_)
+#include <windows.h>
+#endif
+
+namespace GmicQt
+{
+
+QHash<QString, double> MemoryEstimator::_multipliers;
+
+const double MemoryEstimator::DefaultMultiplier = 3.0;
+const double MemoryEstimator::BudgetRatio = 0.9;
+const long long MemoryEstimator::MinimumObservedDelta = 1024 * 1024;
+
+void MemoryEstimator::load()
+{
+  _multipliers.clear();
+  QString jsonFilename = QString("%1%2").arg(gmicConfigPath(true), FILTER_MEMORY_CACHE_FILENAME);
+  QFile jsonFile(jsonFilename);
+  if (!jsonFile.exists()) {
+    return;
+  }
+  if (!jsonFile.open(QFile::ReadOnly)) {
+    Logger::error("Cannot open " + jsonFilename);
+    return;
+  }
+  QByteArray allFile = jsonFile.readAll();
+  QJsonDocument jsonDoc = allFile.startsWith("{") ? QJsonDocument::fromJson(allFile) : QJsonDocument::fromJson(qUncompress(allFile));
+  if (jsonDoc.isNull() || !jsonDoc.isObject()) {
+    Logger::warning(QString("Cannot parse ") + jsonFilename);
+    return;
+  }
+  QJsonObject documentObject = jsonDoc.object();
+  QJsonObject::const_iterator itFilter = documentObject.constBegin();
+  while (itFilter != documentObject.constEnd()) {
+    const double value = itFilter.value().toDouble(-1.0);
+    if (value >= 0.0) {
+      _multipliers.insert(itFilter.key(), value);
+    }
+    ++itFilter;
+  }
+}
+
+void MemoryEstimator::save()
+{
+  // JSON Document format
+  //
+  // {
+  //  "51d288e6f1c6e531cc61289f17e34d8a": 2.5,
+  //  "ebe35dcbd4d2d6e0b6b2e0a2ee52ba49": 0.75
+  // }
+  QJsonObject documentObject;
+  QHash<QString, double>::const_iterator it = _multipliers.cbegin();
+  while (it != _multipliers.cend()) {
+    documentObject.insert(it.key(), it.value());
+    ++it;
+  }
+  QJsonDocument jsonDoc(documentObject);
+  QString jsonFilename = QString("%1%2").arg(gmicConfigPath(true), FILTER_MEMORY_CACHE_FILENAME);
+#ifdef _GMIC_QT_DEBUG_
+  QByteArray array(jsonDoc.toJson());
+#else
+  QByteArray array(qCompress(jsonDoc.toJson(QJsonDocument::Compact)));
+#endif
+  if (!safelyWrite(array, jsonFilename)) {
+    Logger::error("Cannot write " + jsonFilename);
+  }
+}
+
+void MemoryEstimator::clear()
+{
+  _multipliers.clear();
+}
+
+double MemoryEstimator::multiplier(const QString & hash)
+{
+  return _multipliers.value(hash, DefaultMultiplier);
+}
+
+void MemoryEstimator::learn(const QString & hash, const RunResources & resources)
+{
+  if (hash.isEmpty() || resources.failed || resources.aborted || !resources.inputBytes) {
+    return;
+  }
+  // Memory figures are process-wide, they include the allocations of the other runs
+  if (resources.concurrent) {
+    return;
+  }
+  // A delta this small means the peak was not observed (e.g. it fell between two samples
+  // of the resource meter), learning from it would make the multiplier decay to 0.
+  if (resources.peakMemoryDelta < MinimumObservedDelta) {
+    return;
+  }
+  const double observed = static_cast<double>(resources.peakMemoryDelta) / static_cast<double>(resources.inputBytes);
+  auto it = _multipliers.find(hash);
+  if (it == _multipliers.end()) {
+    _multipliers.insert(hash, observed);
+  } else {
+    // Follow decreasing values slowly, increasing ones immediately
+    const double average = 0.5 * (it.value() + observed);
+    it.value() = (observed > average) ? observed : average;
+  }
+}
+
+quint64 MemoryEstimator::inputBytes(int width, int height, int layers, int spectrum)
+{
+  if ((width <= 0) || (height <= 0) || (layers <= 0)) {
+    return 0;
+  }
+  return static_cast<quint64>(width) * static_cast<quint64>(height) * static_cast<quint64>(layers) * static_cast<quint64>(spectrum) * sizeof(float);
+}
+
+quint64 MemoryEstimator::estimate(const QString & hash, quint64 fetchBytes, quint64 filterInputBytes)
+{
+  return fetchBytes + filterInputBytes + static_cast<quint64>(filterInputBytes * multiplier(hash));
+}
+
+quint64 MemoryEstimator::availableMemory()
+{
+#if defined(_IS_MACOS_)
+  static const mach_port_t host = mach_host_self();
+  vm_size_t pageSize = 0;
+  vm_statistics64_data_t stats;
+  mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+  if ((host_page_size(host, &pageSize) == KERN_SUCCESS) && (host_statistics64(host, HOST_VM_INFO64, reinterpret_cast<host_info64_t>(&stats), &count) == KERN_SUCCESS)) {
+    // Inactive and purgeable pages are reclaimed on demand, as MemAvailable counts them on Linux
+    return static_cast<quint64>(stats.free_count + stats.inactive_count + stats.purgeable_count) * pageSize;
+  }
+  return 0;
+#elif defined(_IS_UNIX_)
+  QFile meminfo("/proc/meminfo");
+  if (meminfo.open(QFile::ReadOnly)) {
+    QByteArray text = meminfo.readAll();
+    const char * str = strstr(text.constData(), "MemAvailable:");
+    unsigned long long kiB = 0;
+    if (str && sscanf(str + 13, "%llu", &kiB)) {
+      return 1024 * static_cast<quint64>(kiB);
+    }
+  }
+  return 0;
+#elif defined(_IS_WINDOWS_)
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status)) {
+    return static_cast<quint64>(status.ullAvailPhys);
+  }
+  return 0;
+#else
+  return 0;
+#endif
+}
+
+quint64 MemoryEstimator::budget()
+{
+  return static_cast<quint64>(availableMemory() * BudgetRatio);
+}
+
+} // namespace GmicQt
@@ -0,0 +1,81 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file MemoryEstimator.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_MEMORYESTIMATOR_H
+#define GMIC_QT_MEMORYESTIMATOR_H
+
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+#include "GmicQt.h"
+
+namespace GmicQt
+{
+
+/**
+ * Predicts the peak memory needed by a filter execution.
+ *
+ * The estimate is the size of the images fetched from the host, plus the
+ * size of the input images handed to the interpreter, plus this latter size
+ * times a per-filter multiplier learned from the resource usage of past runs
+ * (DefaultMultiplier for a filter never run before).
+ */
+class MemoryEstimator {
+public:
+  MemoryEstimator() = delete;
+
+  static void load();
+  static void save();
+  static void clear();
+
+  static double multiplier(const QString & hash);
+  static void learn(const QString & hash, const RunResources & resources);
+
+  /**
+   * Size in bytes of a list of float images fetched from the host.
+   */
+  static quint64 inputBytes(int width, int height, int layers, int spectrum = 4);
+  static quint64 estimate(const QString & hash, quint64 fetchBytes, quint64 filterInputBytes);
+
+  /**
+   * Physical memory currently available to the process, in bytes (0 if unknown).
+   */
+  static quint64 availableMemory();
+
+  /**
+   * Part of the available memory that a run may use, in bytes (0 if unknown).
+   */
+  static quint64 budget();
+
+  static const double DefaultMultiplier;
+  static const double BudgetRatio;
+  static const long long MinimumObservedDelta; // Bytes
+
+private:
+  static QHash<QString, double> _multipliers;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_MEMORYESTIMATOR_H
@@ -0,0 +1,260 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file PerformanceStats.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "PerformanceStats.h"
+#include <QElapsedTimer>
+#include <QObject>
+#include <cstring>
+#include <mutex>
+#include "ResourceUsage.h"
+#include "gmic.h"
+
+namespace
+{
+
+const qint64 ResidentSetSizeRefreshDelay = 200; // ms
+
+struct State {
+  std::mutex mutex;
+  GmicQt::PerformanceStats::Run current;
+  GmicQt::PerformanceStats::Run last;
+  quint64 residentSetSize = 0;
+  QElapsedTimer residentSetSizeAge;
+};
+
+State & state()
+{
+  static State s;
+  return s;
+}
+
+std::atomic<quint64> CacheHits[GmicQt::PerformanceStats::CacheCount];
+std::atomic<quint64> CacheMisses[GmicQt::PerformanceStats::CacheCount];
+std::atomic<quint64> CurrentRunId(0);
+std::atomic<int> RunningFilterThreads(0);
+std::atomic<int> AbortedFilterThreads(0);
+
+} // namespace
+
+namespace GmicQt
+{
+
+std::atomic<bool> PerformanceStats::_enabled(false);
+
+void PerformanceStats::setEnabled(bool on)
+{
+  _enabled.store(on);
+}
+
+void PerformanceStats::beginRun(const QString & name)
+{
+  if (!isEnabled()) {
+    return;
+  }
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (s.current.active) {
+    s.last = s.current; // Aborted or superseded run
+    s.last.active = false;
+  }
+  s.current = Run();
+  s.current.id = ++CurrentRunId;
+  s.current.name = name;
+  s.current.started = true;
+  s.current.active = true;
+  s.current.peakResidentSetSize = s.residentSetSize;
+}
+
+void PerformanceStats::endRun()
+{
+  if (!isEnabled()) {
+    return;
+  }
+  residentSetSize(); // Update peak value
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (!s.current.active) {
+    return;
+  }
+  s.current.active = false;
+  s.current.completed = true;
+  s.last = s.current;
+}
+
+PerformanceStats::Run PerformanceStats::currentRun()
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.current;
+}
+
+PerformanceStats::Run PerformanceStats::lastRun()
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.last;
+}
+
+quint64 PerformanceStats::currentRunId()
+{
+  return CurrentRunId.load();
+}
+
+void PerformanceStats::addStageDuration(Stage stage, qint64 microseconds, quint64 runId)
+{
+  if (!isEnabled()) {
+    return;
+  }
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (s.current.active && (s.current.id == runId)) {
+    s.current.stageDurations[static_cast<int>(stage)] += microseconds;
+  }
+}
+
+void PerformanceStats::addSpanDuration(const char * category, qint64 microseconds, quint64 runId)
+{
+  if (!isEnabled() || !category) {
+    return;
+  }
+  if (!strcmp(category, "fetch")) {
+    addStageDuration(Stage::Fetch, microseconds, runId);
+  } else if (!strcmp(category, "conversion") || !strcmp(category, "calibration")) {
+    addStageDuration(Stage::Conversion, microseconds, runId);
+  } else if (!strcmp(category, "gmic")) {
+    addStageDuration(Stage::Interpretation, microseconds, runId);
+  } else if (!strcmp(category, "output")) {
+    addStageDuration(Stage::Output, microseconds, runId);
+  }
+}
+
+void PerformanceStats::addImageBytes(quint64 inputBytes, quint64 outputBytes)
+{
+  if (!isEnabled()) {
+    return;
+  }
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (s.current.active) {
+    s.current.inputBytes += inputBytes;
+    s.current.outputBytes += outputBytes;
+  }
+}
+
+quint64 PerformanceStats::imageListByteCount(const gmic_library::gmic_list<float> & images)
+{
+  quint64 result = 0;
+  for (unsigned int i = 0; i < images.size(); ++i) {
+    result += static_cast<quint64>(images[i].size()) * sizeof(float);
+  }
+  return result;
+}
+
+void PerformanceStats::recordCacheAccess(Cache cache, bool hit)
+{
+  if (hit) {
+    ++CacheHits[static_cast<int>(cache)];
+  } else {
+    ++CacheMisses[static_cast<int>(cache)];
+  }
+}
+
+PerformanceStats::CacheCounters PerformanceStats::cacheCounters(Cache cache)
+{
+  CacheCounters counters;
+  counters.hits = CacheHits[static_cast<int>(cache)].load();
+  counters.misses = CacheMisses[static_cast<int>(cache)].load();
+  return counters;
+}
+
+void PerformanceStats::filterThreadStarted()
+{
+  ++RunningFilterThreads;
+}
+
+void PerformanceStats::filterThreadFinished()
+{
+  --RunningFilterThreads;
+}
+
+int PerformanceStats::runningFilterThreadCount()
+{
+  return RunningFilterThreads.load();
+}
+
+void PerformanceStats::setAbortedFilterThreadCount(int count)
+{
+  AbortedFilterThreads.store(count);
+}
+
+int PerformanceStats::abortedFilterThreadCount()
+{
+  return AbortedFilterThreads.load();
+}
+
+quint64 PerformanceStats::residentSetSize()
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (!s.residentSetSizeAge.isValid() || (s.residentSetSizeAge.elapsed() >= ResidentSetSizeRefreshDelay)) {
+    s.residentSetSize = ResourceMeter::residentSetSize();
+    s.residentSetSizeAge.start();
+  }
+  if (s.current.active && (s.residentSetSize > s.current.peakResidentSetSize)) {
+    s.current.peakResidentSetSize = s.residentSetSize;
+  }
+  return s.residentSetSize;
+}
+
+QString PerformanceStats::stageName(Stage stage)
+{
+  switch (stage) {
+  case Stage::Fetch:
+    return QObject::tr("Fetch");
+  case Stage::Conversion:
+    return QObject::tr("Conversion");
+  case Stage::Interpretation:
+    return QObject::tr("Interpretation");
+  case Stage::Output:
+    return QObject::tr("Output");
+  }
+  return QString();
+}
+
+QString PerformanceStats::cacheName(Cache cache)
+{
+  switch (cache) {
+  case Cache::CroppedImages:
+    return QObject::tr("Input images");
+  case Cache::ActiveLayer:
+    return QObject::tr("Active layer");
+  case Cache::LayersExtent:
+    return QObject::tr("Layers extent");
+  case Cache::SpeculativePreviews:
+    return QObject::tr("Speculative previews");
+  }
+  return QString();
+}
+
+} // namespace GmicQt
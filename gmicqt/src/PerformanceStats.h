@@ -0,0 +1,133 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file PerformanceStats.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_PERFORMANCESTATS_H
+#define GMIC_QT_PERFORMANCESTATS_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+namespace gmic_library
+{
+template <typename T> struct gmic_list;
+}
+
+namespace GmicQt
+{
+
+/**
+ * Per-run performance figures displayed by the performance panel.
+ *
+ * Stage durations are fed by trace spans (see Tracer.h) according to their
+ * category: "fetch", "conversion" and "calibration", "gmic", "output".
+ * Stages may nest (e.g. a host converting its images while fetching them).
+ *
+ * Collection is enabled along with the panel (Settings::performancePanelEnabled()).
+ * All methods are thread-safe.
+ */
+class PerformanceStats {
+public:
+  PerformanceStats() = delete;
+
+  enum class Stage
+  {
+    Fetch,
+    Conversion,
+    Interpretation,
+    Output
+  };
+  static const int StageCount = 4;
+
+  enum class Cache
+  {
+    CroppedImages,
+    ActiveLayer,
+    LayersExtent,
+    SpeculativePreviews
+  };
+  static const int CacheCount = 4;
+
+  struct Run {
+    quint64 id = 0;
+    QString name;
+    bool started = false;
+    bool active = false;
+    bool completed = false;
+    qint64 stageDurations[StageCount] = {0, 0, 0, 0}; // Microseconds
+    quint64 inputBytes = 0;
+    quint64 outputBytes = 0;
+    quint64 peakResidentSetSize = 0;
+  };
+
+  struct CacheCounters {
+    quint64 hits = 0;
+    quint64 misses = 0;
+  };
+
+  static inline bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+  static void setEnabled(bool on);
+
+  static void beginRun(const QString & name);
+  static void endRun();
+  static Run currentRun();
+  static Run lastRun();
+
+  /**
+   * Identifier of the current run, to be captured when a measure starts.
+   * Durations tagged with another run id (e.g. the end of an aborted run
+   * finishing after the next one has begun) are dropped.
+   */
+  static quint64 currentRunId();
+  static void addStageDuration(Stage stage, qint64 microseconds, quint64 runId);
+  static void addSpanDuration(const char * category, qint64 microseconds, quint64 runId);
+  static void addImageBytes(quint64 inputBytes, quint64 outputBytes);
+  static quint64 imageListByteCount(const gmic_library::gmic_list<float> & images);
+
+  static void recordCacheAccess(Cache cache, bool hit);
+  static CacheCounters cacheCounters(Cache cache);
+
+  static void filterThreadStarted();
+  static void filterThreadFinished();
+  static int runningFilterThreadCount();
+  static void setAbortedFilterThreadCount(int count);
+  static int abortedFilterThreadCount();
+
+  /**
+   * Resident set size of the process, in bytes (0 if unknown).
+   * Readings are shared between callers for a short period, and update the
+   * peak value of the current run.
+   */
+  static quint64 residentSetSize();
+
+  static QString stageName(Stage stage);
+  static QString cacheName(Cache cache);
+
+private:
+  static std::atomic<bool> _enabled;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_PERFORMANCESTATS_H
@@ -23,29 +23,113 @@
  *
  */
 #include "PersistentMemory.h"
+#include <QMutexLocker>
+#include "Logger.h"
+#include "Misc.h"
+#include "Settings.h"
 #include "gmic.h"
 
 namespace GmicQt
 {
 
-std::unique_ptr<gmic_library::gmic_image<char>> PersistentMemory::_image;
+const quint64 PersistentMemory::DefaultLimit = 512 * 1024 * 1024;
 
-gmic_library::gmic_image<char> & PersistentMemory::image()
+PersistentMemory::Buffer PersistentMemory::_buffer;
+quint64 PersistentMemory::_generation = 0;
+quint64 PersistentMemory::_limit = PersistentMemory::DefaultLimit;
+QMutex PersistentMemory::_mutex;
+
+PersistentMemory::Buffer PersistentMemory::buffer()
 {
-  if (!_image) {
-    _image.reset(new gmic_library::gmic_image<char>);
-  }
-  return *_image;
+  QMutexLocker locker(&_mutex);
+  return _buffer;
 }
 
 void PersistentMemory::clear()
 {
-  image().assign();
+  replace(Buffer());
+}
+
+quint64 PersistentMemory::generation()
+{
+  QMutexLocker locker(&_mutex);
+  return _generation;
+}
+
+void PersistentMemory::replace(const Buffer & buffer)
+{
+  Buffer previous;
+  {
+    QMutexLocker locker(&_mutex);
+    if (buffer == _buffer) {
+      return;
+    }
+    const quint64 bytes = buffer ? static_cast<quint64>(buffer->size()) : 0;
+    if (bytes > _limit) {
+      Logger::warning(QString("Persistent memory of %1 exceeds the limit of %2, it is not kept").arg(readableSize(bytes), readableSize(_limit)));
+      previous.swap(_buffer);
+    } else {
+      previous = _buffer;
+      _buffer = (buffer && !buffer->is_empty()) ? buffer : Buffer();
+    }
+    if (_buffer != previous) {
+      ++_generation;
+    }
+  }
+  // The previous buffer, if not shared anymore, is released here outside the lock
+  previous.reset();
+  const OutputMessageMode mode = Settings::outputMessageMode();
+  if ((mode == OutputMessageMode::DebugConsole) || (mode == OutputMessageMode::DebugLogFile)) {
+    Logger::log(footprint(), "persistent", true);
+  }
+}
+
+PersistentMemory::Buffer PersistentMemory::adopt(gmic_library::gmic_image<char> & value, const Buffer & input)
+{
+  if (value.is_empty()) {
+    return Buffer();
+  }
+  if (input && value.is_shared() && (value.data() == input->data())) {
+    return input;
+  }
+  auto image = new gmic_library::gmic_image<char>;
+  if (value.is_shared()) {
+    image->assign(value, false);
+  } else {
+    image->swap(value);
+  }
+  return Buffer(image);
+}
+
+quint64 PersistentMemory::size()
+{
+  QMutexLocker locker(&_mutex);
+  return _buffer ? static_cast<quint64>(_buffer->size()) : 0;
+}
+
+quint64 PersistentMemory::limit()
+{
+  QMutexLocker locker(&_mutex);
+  return _limit;
+}
+
+void PersistentMemory::setLimit(quint64 bytes)
+{
+  QMutexLocker locker(&_mutex);
+  _limit = bytes;
+  if (_buffer && (static_cast<quint64>(_buffer->size()) > _limit)) {
+    _buffer.reset();
+    ++_generation;
+  }
 }
 
-void PersistentMemory::move_from(gmic_library::gmic_image<char> & buffer)
+QString PersistentMemory::footprint()
 {
-  buffer.move_to(image());
+  QMutexLocker locker(&_mutex);
+  const quint64 bytes = _buffer ? static_cast<quint64>(_buffer->size()) : 0;
+  // The buffer member itself holds one reference
+  const long references = _buffer ? _buffer.use_count() - 1 : 0;
+  return QString("Persistent memory: %1 (limit %2), %3 other reference(s)").arg(readableSize(bytes), readableSize(_limit)).arg(references);
 }
 
 } // namespace GmicQt
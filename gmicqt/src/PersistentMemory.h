@@ -24,6 +24,9 @@
  */
 #ifndef GMIC_QT__PERSISTENTMEMORY_H
 #define GMIC_QT__PERSISTENTMEMORY_H
+#include <QMutex>
+#include <QString>
+#include <QtGlobal>
 #include <memory>
 namespace gmic_library
 {
@@ -33,14 +36,53 @@ template <typename T> struct gmic_image;
 namespace GmicQt
 {
 
+/**
+ * Content of the '_persistent' G'MIC variable, kept between filter runs.
+ *
+ * The buffer is reference counted and never modified once stored: a run shares
+ * it with the interpreter without copying, and a new buffer produced by a run
+ * replaces the current one atomically. Buffers larger than limit() bytes are
+ * not kept; the limit is read from the settings at startup (see Settings::load()).
+ */
 class PersistentMemory {
 public:
-  static gmic_library::gmic_image<char> & image();
+  using Buffer = std::shared_ptr<const gmic_library::gmic_image<char>>;
+
+  PersistentMemory() = delete;
+
+  static Buffer buffer();
   static void clear();
-  static void move_from(gmic_library::gmic_image<char> & buffer);
+
+  /**
+   * Number of times the buffer was changed. Unlike the buffer address, it
+   * identifies the content even after the buffer has been released.
+   */
+  static quint64 generation();
+  static void replace(const Buffer & buffer);
+
+  /**
+   * Buffer holding the content of the '_persistent' variable taken from an
+   * interpreter which was given the buffer \a input (see gmic::share_variable()).
+   * \a input itself is returned if the filter did not modify the variable.
+   */
+  static Buffer adopt(gmic_library::gmic_image<char> & value, const Buffer & input);
+
+  static quint64 size();
+  static quint64 limit();
+  static void setLimit(quint64 bytes);
+
+  /**
+   * Human readable size, limit and reference count of the current buffer.
+   */
+  static QString footprint();
+
+  static const quint64 DefaultLimit;
 
 private:
-  static std::unique_ptr<gmic_library::gmic_image<char>> _image;
+  static Buffer _buffer;
+  static quint64 _generation;
+  static quint64 _limit;
+  static QMutex _mutex;
 };
 
 } // namespace GmicQt
@@ -0,0 +1,68 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file PreviewScaleController.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "PreviewScaleController.h"
+#include <algorithm>
+#include <cmath>
+
+namespace GmicQt
+{
+
+const double PreviewScaleController::MinimumScale = 0.25;
+const double PreviewScaleController::ScaleStep = 0.125;
+
+PreviewScaleController::PreviewScaleController() : _fullScaleDurationMS(-1.0) {}
+
+double PreviewScaleController::scale(int targetMS) const
+{
+  if ((targetMS <= 0) || (_fullScaleDurationMS <= targetMS)) {
+    return 1.0;
+  }
+  // Duration is proportional to the pixel count, i.e. to the square of the scale
+  const double scale = std::sqrt(targetMS / _fullScaleDurationMS);
+  // A few distinct values only, so that downscaled input images may be reused
+  return std::max(MinimumScale, std::floor(scale / ScaleStep) * ScaleStep);
+}
+
+void PreviewScaleController::record(double scale, int durationMS)
+{
+  if ((scale <= 0.0) || (durationMS < 0)) {
+    return;
+  }
+  const double estimate = durationMS / (scale * scale);
+  if (_fullScaleDurationMS < 0.0) {
+    _fullScaleDurationMS = estimate;
+  } else {
+    // Follow increasing durations immediately, decreasing ones slowly
+    const double average = 0.5 * (_fullScaleDurationMS + estimate);
+    _fullScaleDurationMS = (estimate > average) ? estimate : average;
+  }
+}
+
+void PreviewScaleController::reset()
+{
+  _fullScaleDurationMS = -1.0;
+}
+
+} // namespace GmicQt
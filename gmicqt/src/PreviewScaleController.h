@@ -0,0 +1,61 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file PreviewScaleController.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_PREVIEWSCALECONTROLLER_H
+#define GMIC_QT_PREVIEWSCALECONTROLLER_H
+
+namespace GmicQt
+{
+
+/**
+ * Chooses the resolution at which interactive previews are computed.
+ *
+ * The duration of a preview run is assumed to grow with its pixel count. From
+ * the duration of recent runs, the controller estimates the duration of a
+ * full resolution preview, and returns the largest scale (a multiple of
+ * ScaleStep, at least MinimumScale) expected to meet a latency target.
+ */
+class PreviewScaleController {
+public:
+  PreviewScaleController();
+
+  /**
+   * Scale of the next preview for a latency target in milliseconds
+   * (1.0 if the target is 0, or if no run was recorded yet).
+   */
+  double scale(int targetMS) const;
+
+  void record(double scale, int durationMS);
+  void reset();
+
+  static const double MinimumScale;
+  static const double ScaleStep;
+
+private:
+  double _fullScaleDurationMS; // Negative if unknown
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_PREVIEWSCALECONTROLLER_H
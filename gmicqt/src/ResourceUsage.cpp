@@ -0,0 +1,288 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ResourceUsage.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ResourceUsage.h"
+#include <QByteArray>
+#include <QFile>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include "Logger.h"
+#include "Misc.h"
+#include "PerformanceStats.h"
+#include "gmic.h"
+
+#if defined(_IS_UNIX_) || defined(_IS_MACOS_)
+#include <sys/resource.h>
+#include <sys/time.h>
+#if defined(_IS_MACOS_)
+#include <mach/mach.h>
+#endif
+#elif defined(_IS_WINDOWS_)
+#include <windows.h>
+#include <process.h>
+#include <psapi.h>
+#endif
+
+namespace
+{
+
+const size_t HistorySize = 64;
+
+std::mutex & historyMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+// Protected by historyMutex()
+std::list<GmicQt::RunResources> & history()
+{
+  static std::list<GmicQt::RunResources> list;
+  return list;
+}
+
+#if defined(_IS_MACOS_)
+bool taskBasicInfo(mach_task_basic_info_data_t & info)
+{
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  return task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS;
+}
+#elif defined(_IS_UNIX_)
+quint64 procStatusValue(const char * key)
+{
+  QFile status("/proc/self/status");
+  if (status.open(QFile::ReadOnly)) {
+    QByteArray text = status.readAll();
+    const char * str = strstr(text.constData(), key);
+    unsigned long long kiB = 0;
+    if (str && sscanf(str + strlen(key), "%llu", &kiB)) {
+      return 1024 * static_cast<quint64>(kiB);
+    }
+  }
+  return 0;
+}
+#endif
+
+} // namespace
+
+namespace GmicQt
+{
+
+const int ResourceMeter::SamplingIntervalMS = 20;
+
+ResourceMeter::ResourceMeter() : _cpuStart(0), _residentSetSizeStart(0), _peakResidentSetSizeStart(0), _inputBytes(0), _sampling(false), _sampledPeak(0) {}
+
+ResourceMeter::~ResourceMeter()
+{
+  stopSampling();
+}
+
+void ResourceMeter::start(const gmic_library::gmic_list<float> & input)
+{
+  stopSampling();
+  _inputBytes = PerformanceStats::imageListByteCount(input);
+  _residentSetSizeStart = residentSetSize();
+  _peakResidentSetSizeStart = peakResidentSetSize();
+  // The process high-water mark only tells about runs which exceed all the previous ones,
+  // so the resident set size is also sampled during the run
+  _sampledPeak = _residentSetSizeStart;
+  _sampling = true;
+  _sampler = std::thread(&ResourceMeter::sample, this);
+  _cpuStart = processCpuTime();
+  _wallTimer.start();
+}
+
+void ResourceMeter::sample()
+{
+  std::unique_lock<std::mutex> lock(_samplerMutex);
+  while (_sampling) {
+    lock.unlock();
+    const quint64 size = residentSetSize();
+    lock.lock();
+    _sampledPeak = std::max(_sampledPeak, size);
+    _samplerWakeUp.wait_for(lock, std::chrono::milliseconds(SamplingIntervalMS), [this]() { return !_sampling; });
+  }
+}
+
+void ResourceMeter::stopSampling()
+{
+  {
+    std::lock_guard<std::mutex> lock(_samplerMutex);
+    _sampling = false;
+  }
+  _samplerWakeUp.notify_all();
+  if (_sampler.joinable()) {
+    _sampler.join();
+  }
+}
+
+RunResources ResourceMeter::stop(const gmic_library::gmic_list<float> & output)
+{
+  RunResources resources;
+  resources.wallTimeMS = _wallTimer.elapsed();
+  resources.cpuTimeMS = processCpuTime() - _cpuStart;
+  resources.inputBytes = _inputBytes;
+  resources.outputBytes = PerformanceStats::imageListByteCount(output);
+  resources.threadCount = interpreterThreadCount();
+  stopSampling();
+  // The high-water mark is exact if it was raised during the run, otherwise the
+  // sampled maximum is a lower bound (a peak may fall between two samples).
+  const quint64 peak = peakResidentSetSize();
+  quint64 reference = std::max(_sampledPeak, residentSetSize());
+  if (peak > _peakResidentSetSizeStart) {
+    reference = std::max(reference, peak);
+  }
+  resources.peakMemoryDelta = static_cast<long long>(reference) - static_cast<long long>(_residentSetSizeStart);
+  if (resources.peakMemoryDelta < 0) {
+    resources.peakMemoryDelta = 0;
+  }
+  return resources;
+}
+
+void ResourceMeter::record(const RunResources & resources, const QString & logSuffix)
+{
+  {
+    std::lock_guard<std::mutex> lock(historyMutex());
+    history().push_back(resources);
+    while (history().size() > HistorySize) {
+      history().pop_front();
+    }
+  }
+  Logger::log(QString("Resources: %1").arg(toString(resources)), logSuffix);
+}
+
+RunResources ResourceMeter::last()
+{
+  std::lock_guard<std::mutex> lock(historyMutex());
+  return history().empty() ? RunResources() : history().back();
+}
+
+std::list<RunResources> ResourceMeter::recent()
+{
+  std::lock_guard<std::mutex> lock(historyMutex());
+  return history();
+}
+
+QString ResourceMeter::toString(const RunResources & resources)
+{
+  QString text = QString("wall %1, cpu %2, in %3, out %4, peak memory +%5, %6 thread(s), effective parallelism %7")
+                     .arg(readableDuration(resources.wallTimeMS))
+                     .arg(readableDuration(resources.cpuTimeMS))
+                     .arg(readableSize(resources.inputBytes))
+                     .arg(readableSize(resources.outputBytes))
+                     .arg(readableSize(static_cast<quint64>(resources.peakMemoryDelta)))
+                     .arg(resources.threadCount)
+                     .arg(effectiveParallelismText(resources));
+  if (resources.aborted) {
+    text += " (aborted)";
+  } else if (resources.failed) {
+    text += " (failed)";
+  }
+  return text;
+}
+
+qint64 ResourceMeter::processCpuTime()
+{
+#if defined(_IS_UNIX_) || defined(_IS_MACOS_)
+  struct rusage usage;
+  if (!getrusage(RUSAGE_SELF, &usage)) {
+    return static_cast<qint64>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+  }
+#elif defined(_IS_WINDOWS_)
+  FILETIME creation, exit, kernel, user;
+  if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return static_cast<qint64>((k.QuadPart + u.QuadPart) / 10000); // 100 ns units
+  }
+#endif
+  return 0;
+}
+
+quint64 ResourceMeter::residentSetSize()
+{
+#if defined(_IS_MACOS_)
+  mach_task_basic_info_data_t info;
+  return taskBasicInfo(info) ? static_cast<quint64>(info.resident_size) : 0;
+#elif defined(_IS_UNIX_)
+  return procStatusValue("VmRSS:");
+#elif defined(_IS_WINDOWS_)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return static_cast<quint64>(counters.WorkingSetSize);
+  }
+  return 0;
+#else
+  return 0;
+#endif
+}
+
+quint64 ResourceMeter::peakResidentSetSize()
+{
+#if defined(_IS_MACOS_)
+  mach_task_basic_info_data_t info;
+  return taskBasicInfo(info) ? static_cast<quint64>(info.resident_size_max) : 0;
+#elif defined(_IS_UNIX_)
+  return procStatusValue("VmHWM:");
+#elif defined(_IS_WINDOWS_)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return static_cast<quint64>(counters.PeakWorkingSetSize);
+  }
+  return 0;
+#else
+  return 0;
+#endif
+}
+
+double ResourceMeter::effectiveParallelism(const RunResources & resources)
+{
+  return (resources.wallTimeMS > 0) ? (static_cast<double>(resources.cpuTimeMS) / resources.wallTimeMS) : 0.0;
+}
+
+QString ResourceMeter::effectiveParallelismText(const RunResources & resources)
+{
+  // The CPU time is process-wide: it only measures the run when no other one was ongoing
+  if ((resources.wallTimeMS <= 0) || resources.concurrent) {
+    return QString("-");
+  }
+  return QString::number(effectiveParallelism(resources), 'f', 1);
+}
+
+int ResourceMeter::interpreterThreadCount()
+{
+#if cimg_use_openmp != 0
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+} // namespace GmicQt
@@ -0,0 +1,90 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ResourceUsage.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_RESOURCEUSAGE_H
+#define GMIC_QT_RESOURCEUSAGE_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QtGlobal>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include "GmicQt.h"
+
+namespace GmicQt
+{
+
+/**
+ * Measures the resources used by a single filter execution (see RunResources).
+ *
+ * CPU time and memory figures are process-wide, hence they also account
+ * for any concurrent activity (e.g. another filter thread). The peak memory
+ * is sampled by a helper thread while the meter runs.
+ */
+class ResourceMeter {
+public:
+  ResourceMeter();
+  ~ResourceMeter();
+  ResourceMeter(const ResourceMeter &) = delete;
+  ResourceMeter & operator=(const ResourceMeter &) = delete;
+  void start(const gmic_library::gmic_list<float> & input);
+  RunResources stop(const gmic_library::gmic_list<float> & output);
+
+  /**
+   * Store a record in the history of recent runs, and write it to the log.
+   */
+  static void record(const RunResources & resources, const QString & logSuffix);
+  static RunResources last();
+  static std::list<RunResources> recent();
+  static QString toString(const RunResources & resources);
+
+  static qint64 processCpuTime();       // Milliseconds
+  static quint64 residentSetSize();     // Bytes (0 if unknown)
+  static quint64 peakResidentSetSize(); // Bytes (0 if unknown)
+  static int interpreterThreadCount();  // Of the calling thread (see ThreadBudget)
+  static double effectiveParallelism(const RunResources & resources); // CPU time over wall time
+  static QString effectiveParallelismText(const RunResources & resources); // "-" if unknown or the run was concurrent
+
+  static const int SamplingIntervalMS;
+
+private:
+  void sample();
+  void stopSampling();
+  QElapsedTimer _wallTimer;
+  qint64 _cpuStart;
+  quint64 _residentSetSizeStart;
+  quint64 _peakResidentSetSizeStart;
+  unsigned long long _inputBytes;
+  std::thread _sampler;
+  std::mutex _samplerMutex;
+  std::condition_variable _samplerWakeUp;
+  bool _sampling;            // Protected by _samplerMutex
+  quint64 _sampledPeak;      // Protected by _samplerMutex
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_RESOURCEUSAGE_H
@@ -27,7 +27,10 @@
 #include "GmicStdlib.h"
 #include "Host/GmicQtHost.h"
 #include "IconLoader.h"
+#include "PerformanceStats.h"
+#include "PersistentMemory.h"
 #include "SourcesWidget.h"
+#include "Tracer.h"
 
 #include <QDir>
 #include <QLocale>
@@ -55,10 +58,12 @@ bool Settings::_nativeColorDialogs;
 bool Settings::_nativeFileDialogs;
 int Settings::_updatePeriodicity;
 int Settings::_previewTimeout = 16;
+int Settings::_previewLatencyTarget = PREVIEW_DEFAULT_LATENCY_TARGET_MS;
 OutputMessageMode Settings::_outputMessageMode;
 bool Settings::_previewZoomAlwaysEnabled = false;
 bool Settings::_notifyFailedStartupUpdate = true;
 bool Settings::_highDPI = false;
+bool Settings::_performancePanel = false;
 QStringList Settings::_filterSources;
 SourcesWidget::OfficialFilters Settings::_officialFilterSource;
 
@@ -77,6 +82,7 @@ QString Settings::NegativeSign('-');
 
 void Settings::load(UserInterfaceMode userInterfaceMode)
 {
+  Tracer::initFromEnvironment();
   QSettings settings;
   _visibleLogos = settings.value("LogosAreVisible", true).toBool();
   _darkThemeEnabled = settings.value(DARK_THEME_KEY, GmicQtHost::DarkThemeIsDefault).toBool();
@@ -94,10 +100,16 @@ void Settings::load(UserInterfaceMode userInterfaceMode)
   FolderParameterDefaultValue = settings.value("FolderParameterDefaultValue", QDir::homePath()).toString();
   FileParameterDefaultPath = settings.value("FileParameterDefaultPath", QDir::homePath()).toString();
   _previewTimeout = settings.value("PreviewTimeout", 16).toInt();
+  _previewLatencyTarget = settings.value(PREVIEW_LATENCY_TARGET_KEY, PREVIEW_DEFAULT_LATENCY_TARGET_MS).toInt();
   _previewZoomAlwaysEnabled = settings.value("AlwaysEnablePreviewZoom", false).toBool();
   _outputMessageMode = filterDeprecatedOutputMessageMode((GmicQt::OutputMessageMode)settings.value("OutputMessageMode", static_cast<int>(GmicQt::DefaultOutputMessageMode)).toInt());
   _notifyFailedStartupUpdate = settings.value("Config/NotifyIfStartupUpdateFails", true).toBool();
   _highDPI = settings.value(HIGHDPI_KEY, false).toBool();
+  _performancePanel = settings.value("Config/PerformancePanel", false).toBool();
+  PerformanceStats::setEnabled(_performancePanel);
+  // No user interface, the key may be edited in the configuration file
+  const quint64 MiB = 1024 * 1024;
+  PersistentMemory::setLimit(MiB * settings.value("Config/PersistentMemoryLimitMiB", PersistentMemory::DefaultLimit / MiB).toULongLong());
   _filterSources = settings.value("Config/FilterSources", SourcesWidget::defaultList()).toStringList();
 
   QString officialFilterSource = settings.value(OFFICIAL_FILTER_SOURCE_KEY, QString("EnabledWithUpdates")).toString();
@@ -217,6 +229,16 @@ void Settings::setPreviewTimeout(int seconds)
   _previewTimeout = seconds;
 }
 
+int Settings::previewLatencyTarget()
+{
+  return _previewLatencyTarget;
+}
+
+void Settings::setPreviewLatencyTarget(int ms)
+{
+  _previewLatencyTarget = ms;
+}
+
 OutputMessageMode Settings::outputMessageMode()
 {
   return _outputMessageMode;
@@ -257,6 +279,17 @@ void Settings::setHighDPIEnabled(bool on)
   _highDPI = on;
 }
 
+bool Settings::performancePanelEnabled()
+{
+  return _performancePanel;
+}
+
+void Settings::setPerformancePanelEnabled(bool on)
+{
+  _performancePanel = on;
+  PerformanceStats::setEnabled(on);
+}
+
 const QStringList & Settings::filterSources()
 {
   return _filterSources;
@@ -291,10 +324,12 @@ void Settings::save(QSettings & settings)
   settings.setValue("FolderParameterDefaultValue", FolderParameterDefaultValue);
   settings.setValue("FileParameterDefaultPath", FileParameterDefaultPath);
   settings.setValue("PreviewTimeout", _previewTimeout);
+  settings.setValue(PREVIEW_LATENCY_TARGET_KEY, _previewLatencyTarget);
   settings.setValue("OutputMessageMode", (int)_outputMessageMode);
   settings.setValue("AlwaysEnablePreviewZoom", _previewZoomAlwaysEnabled);
   settings.setValue("Config/NotifyIfStartupUpdateFails", _notifyFailedStartupUpdate);
   settings.setValue(HIGHDPI_KEY, _highDPI);
+  settings.setValue("Config/PerformancePanel", _performancePanel);
   settings.setValue("Config/FilterSources", _filterSources);
 
   switch (_officialFilterSource) {
@@ -60,6 +60,8 @@ public:
   static void setUpdatePeriodicity(int hours);
   static int previewTimeout();
   static void setPreviewTimeout(int seconds);
+  static int previewLatencyTarget();
+  static void setPreviewLatencyTarget(int ms);
   static OutputMessageMode outputMessageMode();
   static void setOutputMessageMode(OutputMessageMode mode);
   static bool previewZoomAlwaysEnabled();
@@ -68,6 +70,8 @@ public:
   static void setNotifyFailedStartupUpdate(bool);
   static bool highDPIEnabled();
   static void setHighDPIEnabled(bool);
+  static bool performancePanelEnabled();
+  static void setPerformancePanelEnabled(bool);
   static const QStringList & filterSources();
   static void setFilterSources(const QStringList &);
   static SourcesWidget::OfficialFilters officialFilterSource();
@@ -98,10 +102,12 @@ private:
   static bool _nativeFileDialogs;
   static int _updatePeriodicity;
   static int _previewTimeout;
+  static int _previewLatencyTarget;
   static OutputMessageMode _outputMessageMode;
   static bool _previewZoomAlwaysEnabled;
   static bool _notifyFailedStartupUpdate;
   static bool _highDPI;
+  static bool _performancePanel;
   static QStringList _filterSources;
   static SourcesWidget::OfficialFilters _officialFilterSource;
 };
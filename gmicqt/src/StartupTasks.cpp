@@ -0,0 +1,75 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file StartupTasks.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "StartupTasks.h"
+#include <vector>
+#include "Tracer.h"
+
+namespace GmicQt
+{
+
+StartupTasks::~StartupTasks()
+{
+  waitAll();
+}
+
+void StartupTasks::start(const char * name, const std::function<void()> & task, const QList<const char *> & dependencies)
+{
+  wait(name);
+  std::vector<std::shared_future<void>> prerequisites;
+  for (const char * dependency : dependencies) {
+    auto it = _tasks.find(QString::fromLatin1(dependency));
+    if (it != _tasks.end()) {
+      prerequisites.push_back(it.value());
+    }
+  }
+  _tasks.insert(QString::fromLatin1(name), std::async(std::launch::async, [name, task, prerequisites]() {
+                                             for (const std::shared_future<void> & prerequisite : prerequisites) {
+                                               prerequisite.wait();
+                                             }
+                                             TRACE_SPAN(name, "startup");
+                                             task();
+                                           }).share());
+}
+
+void StartupTasks::wait(const char * name)
+{
+  auto it = _tasks.find(QString::fromLatin1(name));
+  if (it != _tasks.end()) {
+    std::shared_future<void> future = it.value();
+    _tasks.erase(it);
+    future.get();
+  }
+}
+
+void StartupTasks::waitAll()
+{
+  while (!_tasks.isEmpty()) {
+    std::shared_future<void> future = _tasks.first();
+    _tasks.erase(_tasks.begin());
+    future.get();
+  }
+}
+
+} // namespace GmicQt
@@ -0,0 +1,65 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file StartupTasks.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_STARTUPTASKS_H
+#define GMIC_QT_STARTUPTASKS_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <functional>
+#include <future>
+
+namespace GmicQt
+{
+
+/**
+ * Initialization steps run concurrently, each one on its own thread.
+ *
+ * A task starts once the tasks it depends on are done. Tasks are started and
+ * waited for by the GUI thread only. They must not touch any widget, and what
+ * they initialize must not be used before the task has been waited for.
+ */
+class StartupTasks {
+public:
+  StartupTasks() = default;
+  ~StartupTasks();
+  StartupTasks(const StartupTasks &) = delete;
+  StartupTasks & operator=(const StartupTasks &) = delete;
+
+  /**
+   * Start a task once the given ones (started earlier) are done.
+   * A task with the same name still running is waited for first.
+   */
+  void start(const char * name, const std::function<void()> & task, const QList<const char *> & dependencies = QList<const char *>());
+  void wait(const char * name);
+  void waitAll();
+
+private:
+  QMap<QString, std::shared_future<void>> _tasks;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_STARTUPTASKS_H
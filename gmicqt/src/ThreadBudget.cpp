@@ -0,0 +1,227 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ThreadBudget.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ThreadBudget.h"
+#include <QElapsedTimer>
+#include <QObject>
+#include <QThread>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+// Share of the cores left to the batch jobs while interactive ones are running
+const int BatchShareDivisor = 4;
+
+// Largest share of the cores kept for the background jobs
+const int BackgroundShareDivisor = 4;
+
+struct State {
+  std::mutex mutex;
+  std::vector<GmicQt::ThreadBudget::Job *> jobs; // Running jobs, in start order
+  GmicQt::ThreadBudget::Metrics metrics[GmicQt::ThreadBudget::PriorityCount];
+  QElapsedTimer clock;
+  qint64 lastUpdate = 0; // Microseconds
+};
+
+State & state()
+{
+  static State s;
+  return s;
+}
+
+// Split threads between the jobs, earlier jobs getting the remainder, and at least one each
+void share(const std::vector<GmicQt::ThreadBudget::Job *> & jobs, int threads, std::vector<int> & budgets)
+{
+  const int count = static_cast<int>(jobs.size());
+  for (int i = 0; i < count; ++i) {
+    budgets.push_back(std::max(1, threads / count + ((i < threads % count) ? 1 : 0)));
+  }
+}
+
+} // namespace
+
+namespace GmicQt
+{
+
+void ThreadBudget::rebalance()
+{
+  State & s = state();
+  if (!s.clock.isValid()) {
+    s.clock.start();
+  }
+  const qint64 now = s.clock.nsecsElapsed() / 1000;
+  const double seconds = (now - s.lastUpdate) / 1.0e6;
+  s.lastUpdate = now;
+  std::vector<Job *> groups[PriorityCount];
+  for (Job * job : s.jobs) {
+    job->_alone = job->_alone && (s.jobs.size() == 1);
+    Metrics & metrics = s.metrics[static_cast<int>(job->_priority)];
+    metrics.jobSeconds += seconds;
+    metrics.threadSeconds += seconds * job->_budget;
+    groups[static_cast<int>(job->_priority)].push_back(job);
+  }
+  const std::vector<Job *> & interactive = groups[static_cast<int>(Priority::Interactive)];
+  const std::vector<Job *> & batch = groups[static_cast<int>(Priority::Batch)];
+  // Superseded jobs are being aborted: they get a thread but reserve no core, so that they do not slow down the next preview
+  const int backgroundJobs = static_cast<int>(groups[static_cast<int>(Priority::Background)].size());
+  const int reserved = std::min(backgroundJobs, coreCount() / BackgroundShareDivisor);
+  const int available = std::max(1, coreCount() - reserved);
+  int batchThreads = available;
+  if (!interactive.empty()) {
+    batchThreads = batch.empty() ? 0 : std::max(static_cast<int>(batch.size()), available / BatchShareDivisor);
+  }
+  std::vector<int> budgets;
+  share(interactive, available - batchThreads, budgets);
+  share(batch, batchThreads, budgets);
+  for (size_t i = 0; i < interactive.size(); ++i) {
+    interactive[i]->_budget = budgets[i];
+  }
+  for (size_t i = 0; i < batch.size(); ++i) {
+    batch[i]->_budget = budgets[interactive.size() + i];
+  }
+  for (Job * job : s.jobs) {
+    if ((job->_priority == Priority::Background) || (job->_priority == Priority::Superseded)) {
+      job->_budget = 1;
+    }
+  }
+}
+
+ThreadBudget::Job::Job(Priority priority) : _priority(priority), _budget(coreCount()), _running(false), _alone(true) {}
+
+ThreadBudget::Job::~Job()
+{
+  finish();
+}
+
+void ThreadBudget::Job::start()
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (_running) {
+    return;
+  }
+  _running = true;
+  _alone = true;
+  ++s.metrics[static_cast<int>(_priority)].jobs;
+  s.jobs.push_back(this);
+  rebalance();
+}
+
+void ThreadBudget::Job::finish()
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (!_running) {
+    return;
+  }
+  rebalance();
+  _running = false;
+  s.jobs.erase(std::find(s.jobs.begin(), s.jobs.end(), this));
+  rebalance();
+}
+
+void ThreadBudget::Job::setPriority(Priority priority)
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (priority == _priority) {
+    return;
+  }
+  if (_running) {
+    rebalance();
+  }
+  _priority = priority;
+  if (_running) {
+    rebalance();
+  }
+}
+
+ThreadBudget::Priority ThreadBudget::Job::priority() const
+{
+  return _priority;
+}
+
+const std::atomic<int> * ThreadBudget::Job::budget() const
+{
+  return &_budget;
+}
+
+bool ThreadBudget::Job::ranAlone() const
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return _alone;
+}
+
+int ThreadBudget::coreCount()
+{
+  static const int count = std::max(1, QThread::idealThreadCount());
+  return count;
+}
+
+int ThreadBudget::assignedThreadCount()
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  int count = 0;
+  for (const Job * job : s.jobs) {
+    count += job->_budget;
+  }
+  return count;
+}
+
+int ThreadBudget::runningJobCount()
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return static_cast<int>(s.jobs.size());
+}
+
+ThreadBudget::Metrics ThreadBudget::metrics(Priority priority)
+{
+  State & s = state();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  rebalance(); // Bring the figures of running jobs up to date
+  return s.metrics[static_cast<int>(priority)];
+}
+
+QString ThreadBudget::priorityName(Priority priority)
+{
+  switch (priority) {
+  case Priority::Interactive:
+    return QObject::tr("Interactive");
+  case Priority::Batch:
+    return QObject::tr("Batch");
+  case Priority::Background:
+    return QObject::tr("Background");
+  case Priority::Superseded:
+    return QObject::tr("Superseded");
+  }
+  return QString();
+}
+
+} // namespace GmicQt
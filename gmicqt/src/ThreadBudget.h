@@ -0,0 +1,100 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ThreadBudget.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_THREADBUDGET_H
+#define GMIC_QT_THREADBUDGET_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+namespace GmicQt
+{
+
+/**
+ * Process-wide share of the CPU cores between the running interpreter jobs.
+ *
+ * Each job gets a number of threads for the multi-threaded operators, given
+ * its priority and the other running jobs: interactive jobs get most of the
+ * cores, batch jobs share the rest fairly, and background or superseded jobs
+ * get a single thread. Each background job keeps a core for itself, up to a
+ * quarter of the cores; superseded jobs (aborted runs) do not reserve any.
+ * Budgets are updated whenever a job starts, finishes or changes priority,
+ * and read by the interpreter before each command (see gmic::thread_budget).
+ *
+ * All methods are thread-safe.
+ */
+class ThreadBudget {
+public:
+  ThreadBudget() = delete;
+
+  enum class Priority
+  {
+    Interactive,
+    Batch,
+    Background,
+    Superseded
+  };
+  static const int PriorityCount = 4;
+
+  class Job {
+  public:
+    explicit Job(Priority priority = Priority::Interactive);
+    ~Job();
+    Job(const Job &) = delete;
+    Job & operator=(const Job &) = delete;
+    void start();
+    void finish();
+    void setPriority(Priority priority);
+    Priority priority() const;
+    const std::atomic<int> * budget() const; // Read by the interpreter thread while it is updated
+    bool ranAlone() const;                   // No other job was running since start()
+
+  private:
+    friend class ThreadBudget;
+    Priority _priority;
+    std::atomic<int> _budget;
+    bool _running;
+    bool _alone;
+  };
+
+  struct Metrics {
+    quint64 jobs = 0;
+    double jobSeconds = 0.0;    // Running time of the jobs
+    double threadSeconds = 0.0; // Same, weighted by their budget
+  };
+
+  static int coreCount();
+  static int assignedThreadCount();
+  static int runningJobCount();
+  static Metrics metrics(Priority priority);
+  static QString priorityName(Priority priority);
+
+private:
+  static void rebalance(); // Called with the state mutex held
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_THREADBUDGET_H
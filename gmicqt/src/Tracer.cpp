@@ -0,0 +1,283 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file Tracer.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "Tracer.h"
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QFile>
+#include <QMap>
+#include <QThread>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "Logger.h"
+#include "Utils.h"
+
+namespace
+{
+
+struct TraceEvent {
+  const char * name;
+  const char * category;
+  char phase; // 'X' (complete) or 'i' (instant)
+  qint64 timestamp;
+  qint64 duration;
+  int threadId;
+  QString detail;
+};
+
+const size_t MaxEventCount = 1u << 20;
+
+std::mutex & eventsMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+// Protected by eventsMutex()
+std::vector<TraceEvent> & events()
+{
+  static std::vector<TraceEvent> list;
+  return list;
+}
+
+// Protected by eventsMutex()
+QMap<int, QString> & threadNames()
+{
+  static QMap<int, QString> names;
+  return names;
+}
+
+// Protected by eventsMutex()
+QString & outputFilenameStorage()
+{
+  static QString filename;
+  return filename;
+}
+
+const std::chrono::steady_clock::time_point & origin()
+{
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return start;
+}
+
+std::atomic<int> ThreadCounter(0);
+thread_local int CurrentThreadId = -1;
+
+QString currentThreadName()
+{
+  QThread * thread = QThread::currentThread();
+  if (QCoreApplication::instance() && (thread == QCoreApplication::instance()->thread())) {
+    return QString("GUI");
+  }
+  if (thread && !thread->objectName().isEmpty()) {
+    return thread->objectName();
+  }
+  if (thread && thread->metaObject()) {
+    return QString::fromLatin1(thread->metaObject()->className());
+  }
+  return QString("Thread");
+}
+
+// Must be called with eventsMutex() locked
+int currentThreadId()
+{
+  if (CurrentThreadId == -1) {
+    CurrentThreadId = ++ThreadCounter;
+    threadNames()[CurrentThreadId] = QString("%1 #%2").arg(currentThreadName()).arg(CurrentThreadId);
+  }
+  return CurrentThreadId;
+}
+
+void appendEscaped(QByteArray & out, const QByteArray & text)
+{
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        out += ' ';
+      } else {
+        out += c;
+      }
+    }
+  }
+}
+
+void record(TraceEvent && event)
+{
+  std::lock_guard<std::mutex> lock(eventsMutex());
+  if (events().size() >= MaxEventCount) {
+    return;
+  }
+  event.threadId = currentThreadId();
+  events().push_back(std::move(event));
+}
+
+// Flush recorded events when the plugin is unloaded
+struct ExitFlusher {
+  ExitFlusher()
+  {
+    // Make sure storage outlives this object
+    eventsMutex();
+    events();
+    threadNames();
+    outputFilenameStorage();
+    origin();
+  }
+  ~ExitFlusher()
+  {
+    if (GmicQt::Tracer::isEnabled() && GmicQt::Tracer::eventCount()) {
+      GmicQt::Tracer::save();
+    }
+  }
+} exitFlusher;
+
+} // namespace
+
+namespace GmicQt
+{
+
+#ifdef _TIMING_ENABLED_
+std::atomic<bool> Tracer::_enabled(true);
+#else
+std::atomic<bool> Tracer::_enabled(false);
+#endif
+
+void Tracer::setEnabled(bool on)
+{
+  if (on && outputFilename().isEmpty()) {
+    setOutputFilename(gmicConfigPath(true) + "gmic_qt_trace.json");
+  }
+  _enabled.store(on);
+}
+
+void Tracer::initFromEnvironment()
+{
+  const QByteArray value = qgetenv("GMIC_QT_TRACE");
+  const bool requested = !value.isEmpty() && (value != "0");
+  if (requested && (value != "1")) {
+    setOutputFilename(QString::fromLocal8Bit(value));
+  }
+  if (requested || isEnabled()) {
+    setEnabled(true);
+    Logger::note(QString("Tracing enabled, output file is %1").arg(outputFilename()));
+  }
+}
+
+qint64 Tracer::now()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin()).count();
+}
+
+void Tracer::complete(const char * name, const char * category, qint64 start, qint64 duration, const QString & detail)
+{
+  record(TraceEvent{name, category, 'X', start, duration, 0, detail});
+}
+
+void Tracer::instant(const char * name, const char * category, const QString & detail)
+{
+  record(TraceEvent{name, category, 'i', now(), 0, 0, detail});
+}
+
+int Tracer::eventCount()
+{
+  std::lock_guard<std::mutex> lock(eventsMutex());
+  return static_cast<int>(events().size());
+}
+
+QString Tracer::outputFilename()
+{
+  std::lock_guard<std::mutex> lock(eventsMutex());
+  return outputFilenameStorage();
+}
+
+void Tracer::setOutputFilename(const QString & filename)
+{
+  std::lock_guard<std::mutex> lock(eventsMutex());
+  outputFilenameStorage() = filename;
+}
+
+bool Tracer::save()
+{
+  const QString filename = outputFilename();
+  return !filename.isEmpty() && save(filename);
+}
+
+bool Tracer::save(const QString & filename)
+{
+  const qint64 pid = QCoreApplication::applicationPid();
+  QByteArray json;
+  json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  {
+    std::lock_guard<std::mutex> lock(eventsMutex());
+    json.reserve(json.size() + static_cast<int>(events().size()) * 128);
+    bool first = true;
+    QMap<int, QString>::const_iterator itName = threadNames().cbegin();
+    while (itName != threadNames().cend()) {
+      json += first ? "" : ",\n";
+      json += QString(R"_({"name":"thread_name","ph":"M","pid":%1,"tid":%2,"args":{"name":")_").arg(pid).arg(itName.key()).toUtf8();
+      appendEscaped(json, itName.value().toUtf8());
+      json += "\"}}";
+      first = false;
+      ++itName;
+    }
+    for (const TraceEvent & event : events()) {
+      json += first ? "" : ",\n";
+      first = false;
+      json += "{\"name\":\"";
+      appendEscaped(json, QByteArray(event.name));
+      json += "\",\"cat\":\"";
+      appendEscaped(json, QByteArray(event.category));
+      json += QString(R"_(","ph":"%1","pid":%2,"tid":%3,"ts":%4)_").arg(QChar::fromLatin1(event.phase)).arg(pid).arg(event.threadId).arg(event.timestamp).toUtf8();
+      if (event.phase == 'X') {
+        json += QString(",\"dur\":%1").arg(event.duration).toUtf8();
+      } else if (event.phase == 'i') {
+        json += ",\"s\":\"t\"";
+      }
+      if (!event.detail.isEmpty()) {
+        json += ",\"args\":{\"detail\":\"";
+        appendEscaped(json, event.detail.toUtf8());
+        json += "\"}";
+      }
+      json += "}";
+    }
+  }
+  json += "\n]}\n";
+  QFile file(filename);
+  return file.open(QFile::WriteOnly | QFile::Truncate) && writeAll(json, file);
+}
+
+} // namespace GmicQt
@@ -0,0 +1,124 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file Tracer.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_TRACER_H
+#define GMIC_QT_TRACER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include "PerformanceStats.h"
+
+namespace GmicQt
+{
+
+/**
+ * Span based tracer, usable from any thread.
+ *
+ * Recorded events are exported in the Chrome trace event format (JSON),
+ * which can be loaded in chrome://tracing or https://ui.perfetto.dev
+ *
+ * Tracing is disabled by default. It is enabled at startup when the
+ * GMIC_QT_TRACE environment variable is set (to "1" for the default output
+ * file in the G'MIC config folder, or to an output file path), or when the
+ * _TIMING_ENABLED_ macro is defined. When disabled (as well as performance
+ * statistics), a span costs three relaxed atomic loads.
+ *
+ * Event names and categories must be string literals (only pointers are stored).
+ */
+class Tracer {
+public:
+  Tracer() = delete;
+
+  static inline bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+  static void setEnabled(bool on);
+  static void initFromEnvironment();
+
+  static qint64 now(); // Microseconds since tracer start
+  static void complete(const char * name, const char * category, qint64 start, qint64 duration, const QString & detail = QString());
+  static void instant(const char * name, const char * category, const QString & detail = QString());
+
+  static int eventCount();
+  static QString outputFilename();
+  static void setOutputFilename(const QString & filename);
+  static bool save();
+  static bool save(const QString & filename);
+
+private:
+  static std::atomic<bool> _enabled;
+};
+
+/**
+ * RAII span, recorded as a "complete" event when it goes out of scope.
+ * Its duration is also accounted by PerformanceStats when enabled.
+ */
+class TraceSpan {
+public:
+  inline TraceSpan(const char * name, const char * category)
+      : _name(name), _category(category), _start((Tracer::isEnabled() || PerformanceStats::isEnabled()) ? Tracer::now() : -1), //
+        _runId(PerformanceStats::isEnabled() ? PerformanceStats::currentRunId() : 0)
+  {
+  }
+  inline ~TraceSpan()
+  {
+    if (_start >= 0) {
+      const qint64 duration = Tracer::now() - _start;
+      if (Tracer::isEnabled()) {
+        Tracer::complete(_name, _category, _start, duration, _detail);
+      }
+      PerformanceStats::addSpanDuration(_category, duration, _runId);
+    }
+  }
+  inline bool isRecording() const { return _start >= 0; }
+  inline void setDetail(const QString & detail)
+  {
+    if (_start >= 0) {
+      _detail = detail;
+    }
+  }
+
+private:
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan & operator=(const TraceSpan &) = delete;
+  const char * _name;
+  const char * _category;
+  const qint64 _start;
+  const quint64 _runId;
+  QString _detail;
+};
+
+} // namespace GmicQt
+
+#define GMIC_QT_TRACE_CONCAT_(A, B) A##B
+#define GMIC_QT_TRACE_CONCAT(A, B) GMIC_QT_TRACE_CONCAT_(A, B)
+
+/**
+ * TRACE_SPAN("name", "category") records the enclosing scope.
+ * TRACE_SPAN_NAMED(span, "name", "category") does the same, giving access to
+ * the span (e.g. span.setDetail(...)).
+ */
+#define TRACE_SPAN(NAME, CATEGORY) GmicQt::TraceSpan GMIC_QT_TRACE_CONCAT(_traceSpan_, __LINE__)(NAME, CATEGORY)
+#define TRACE_SPAN_NAMED(VAR, NAME, CATEGORY) GmicQt::TraceSpan VAR(NAME, CATEGORY)
+
+#endif // GMIC_QT_TRACER_H
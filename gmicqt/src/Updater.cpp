@@ -24,14 +24,21 @@
  */
 #include "Updater.h"
 #include <QByteArray>
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QNetworkRequest>
+#include <QSaveFile>
 #include <QTextStream>
 #include <QUrl>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <zlib.h>
 #include "Common.h"
+#include "Globals.h"
 #include "GmicStdlib.h"
 #include "Logger.h"
 #include "Misc.h"
@@ -41,6 +48,303 @@
 
 namespace GmicQt
 {
+
+/**
+ * Writes a downloaded filter source to its local file while it is received.
+ *
+ * Sources serialized as a single CImg<uint8> (possibly compressed) are
+ * decoded on the fly, other ones are written as is. The local file is only
+ * replaced by commit(), once the whole content has been checked.
+ */
+class DownloadWriter {
+public:
+  enum class Error
+  {
+    None,
+    Decompression,
+    Writing
+  };
+  explicit DownloadWriter(const QString & filename);
+  ~DownloadWriter();
+  bool write(const QByteArray & data);
+  bool commit();
+  bool hasData() const;
+  bool failed() const;
+  Error error() const;
+
+private:
+  enum class State
+  {
+    Format,      // Waiting for enough bytes to recognize the format
+    ListHeader,  // Waiting for the end of "1 uint8 little_endian"
+    ImageHeader, // Waiting for the end of "W H D S [#compressed_size]"
+    Raw,         // Uncompressed CImg data
+    Inflate,     // Compressed CImg data
+    Plain,       // Not a CImg file
+    Trailer      // CImg data complete, remaining bytes are ignored
+  };
+  bool consume(const char * data, qint64 size);
+  bool takeLine(const char *& data, qint64 & size, QByteArray & line);
+  bool parseImageHeader(const QByteArray & line);
+  bool output(const char * data, qint64 size);
+  bool fail(Error error);
+
+  QSaveFile _file;
+  State _state;
+  Error _error;
+  QByteArray _pending; // Bytes of an incomplete header
+  quint64 _remainingInput;
+  quint64 _remainingOutput;
+  z_stream _zstream;
+  bool _zstreamInitialized;
+  qint64 _received;
+  QByteArray _tail; // Last bytes written, the marker may span two chunks
+  bool _markerFound;
+};
+
+namespace
+{
+const char GuiMarker[] = "#@gui";
+const int GuiMarkerLength = 5;
+const int InflateBufferSize = 64 * 1024;
+} // namespace
+
+DownloadWriter::DownloadWriter(const QString & filename) : _file(filename)
+{
+  _state = State::Format;
+  _error = Error::None;
+  _remainingInput = 0;
+  _remainingOutput = 0;
+  std::memset(&_zstream, 0, sizeof(_zstream));
+  _zstreamInitialized = false;
+  _received = 0;
+  _markerFound = false;
+}
+
+DownloadWriter::~DownloadWriter()
+{
+  if (_zstreamInitialized) {
+    inflateEnd(&_zstream);
+  }
+  // An uncommitted QSaveFile leaves the target file untouched
+}
+
+bool DownloadWriter::write(const QByteArray & data)
+{
+  if (failed()) {
+    return false;
+  }
+  _received += data.size();
+  return data.isEmpty() || consume(data.constData(), data.size());
+}
+
+bool DownloadWriter::commit()
+{
+  if (failed()) {
+    return false;
+  }
+  if ((_state == State::Format) && !_pending.isEmpty()) {
+    // Too short to be a CImg file
+    _state = State::Plain;
+    const QByteArray pending = _pending;
+    _pending.clear();
+    if (!output(pending.constData(), pending.size())) {
+      return false;
+    }
+  }
+  const bool complete = (_state == State::Plain) || (_state == State::Trailer);
+  if (!complete || !_markerFound) {
+    return fail(Error::Decompression);
+  }
+  if (!_file.commit()) {
+    return fail(Error::Writing);
+  }
+  return true;
+}
+
+bool DownloadWriter::hasData() const
+{
+  return _received > 0;
+}
+
+bool DownloadWriter::failed() const
+{
+  return _error != Error::None;
+}
+
+DownloadWriter::Error DownloadWriter::error() const
+{
+  return _error;
+}
+
+bool DownloadWriter::consume(const char * data, qint64 size)
+{
+  while (size > 0) {
+    switch (_state) {
+    case State::Format: {
+      const qint64 needed = std::min<qint64>(size, 8 - _pending.size());
+      _pending.append(data, static_cast<int>(needed));
+      data += needed;
+      size -= needed;
+      if (_pending.size() == 8) {
+        const bool cimg = _pending.startsWith("1 uint8 ");
+        _state = cimg ? State::ListHeader : State::Plain;
+        if (!cimg) {
+          const QByteArray pending = _pending;
+          _pending.clear();
+          if (!output(pending.constData(), pending.size())) {
+            return false;
+          }
+        }
+      }
+    } break;
+    case State::ListHeader: {
+      QByteArray line;
+      if (takeLine(data, size, line)) {
+        _state = State::ImageHeader;
+      }
+    } break;
+    case State::ImageHeader: {
+      QByteArray line;
+      if (takeLine(data, size, line) && !parseImageHeader(line)) {
+        return fail(Error::Decompression);
+      }
+    } break;
+    case State::Raw: {
+      const qint64 count = static_cast<qint64>(std::min<quint64>(static_cast<quint64>(size), _remainingInput));
+      if (!output(data, count)) {
+        return false;
+      }
+      data += count;
+      size -= count;
+      _remainingInput -= count;
+      _remainingOutput -= count;
+      if (!_remainingInput) {
+        _state = State::Trailer;
+      }
+    } break;
+    case State::Inflate: {
+      const qint64 count = static_cast<qint64>(std::min<quint64>(static_cast<quint64>(size), _remainingInput));
+      QByteArray buffer(InflateBufferSize, Qt::Uninitialized);
+      _zstream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+      _zstream.avail_in = static_cast<uInt>(count);
+      int status = Z_OK;
+      do {
+        _zstream.next_out = reinterpret_cast<Bytef *>(buffer.data());
+        _zstream.avail_out = InflateBufferSize;
+        status = inflate(&_zstream, Z_NO_FLUSH);
+        if ((status != Z_OK) && (status != Z_STREAM_END) && (status != Z_BUF_ERROR)) {
+          return fail(Error::Decompression);
+        }
+        const quint64 produced = InflateBufferSize - _zstream.avail_out;
+        if (produced > _remainingOutput) {
+          return fail(Error::Decompression);
+        }
+        if (!output(buffer.constData(), static_cast<qint64>(produced))) {
+          return false;
+        }
+        _remainingOutput -= produced;
+      } while ((status != Z_STREAM_END) && (_zstream.avail_in || !_zstream.avail_out));
+      data += count;
+      size -= count;
+      _remainingInput -= count;
+      if (status == Z_STREAM_END) {
+        if (_remainingOutput) {
+          return fail(Error::Decompression);
+        }
+        _state = State::Trailer;
+      } else if (!_remainingInput) {
+        return fail(Error::Decompression);
+      }
+    } break;
+    case State::Plain:
+      if (!output(data, size)) {
+        return false;
+      }
+      size = 0;
+      break;
+    case State::Trailer:
+      size = 0;
+      break;
+    }
+  }
+  return true;
+}
+
+bool DownloadWriter::takeLine(const char *& data, qint64 & size, QByteArray & line)
+{
+  const void * end = std::memchr(data, '\n', static_cast<size_t>(size));
+  const qint64 count = end ? (static_cast<const char *>(end) - data) + 1 : size;
+  _pending.append(data, static_cast<int>(count));
+  data += count;
+  size -= count;
+  if (!end) {
+    return false;
+  }
+  line = _pending;
+  line.chop(1);
+  _pending.clear();
+  return true;
+}
+
+bool DownloadWriter::parseImageHeader(const QByteArray & line)
+{
+  unsigned int width = 0;
+  unsigned int height = 0;
+  unsigned int depth = 0;
+  unsigned int spectrum = 0;
+  unsigned long compressedSize = 0;
+  const int count = std::sscanf(line.constData(), "%u %u %u %u #%lu", &width, &height, &depth, &spectrum, &compressedSize);
+  if (count < 4) {
+    return false;
+  }
+  _remainingOutput = static_cast<quint64>(width) * height * depth * spectrum;
+  if (count == 5) {
+    if (inflateInit(&_zstream) != Z_OK) {
+      return false;
+    }
+    _zstreamInitialized = true;
+    _remainingInput = compressedSize;
+    _state = State::Inflate;
+  } else {
+    _remainingInput = _remainingOutput;
+    _state = State::Raw;
+  }
+  if (!_remainingInput) {
+    _state = State::Trailer;
+  }
+  return true;
+}
+
+bool DownloadWriter::output(const char * data, qint64 size)
+{
+  if (!size) {
+    return true;
+  }
+  if (!_file.isOpen() && !_file.open(QIODevice::WriteOnly)) {
+    Logger::error(QString("Cannot write file %1 (%2)").arg(_file.fileName()).arg(_file.errorString()));
+    return fail(Error::Writing);
+  }
+  if (_file.write(data, size) != size) {
+    return fail(Error::Writing);
+  }
+  if (!_markerFound) {
+    const QByteArray chunk = QByteArray::fromRawData(data, static_cast<int>(size));
+    _markerFound = chunk.contains(GuiMarker) || (_tail + chunk.left(GuiMarkerLength - 1)).contains(GuiMarker);
+    _tail = (_tail + chunk.right(GuiMarkerLength - 1)).right(GuiMarkerLength - 1);
+  }
+  return true;
+}
+
+bool DownloadWriter::fail(Error error)
+{
+  _error = error;
+  if (_file.isOpen()) {
+    _file.cancelWriting();
+  }
+  return false;
+}
+
 std::unique_ptr<Updater> Updater::_instance = std::unique_ptr<Updater>(nullptr);
 OutputMessageMode Updater::_outputMessageMode = OutputMessageMode::Quiet;
 
@@ -65,7 +369,10 @@ Updater * Updater::getInstance()
   return _instance.get();
 }
 
-Updater::~Updater() = default;
+Updater::~Updater()
+{
+  qDeleteAll(_writers);
+}
 
 void Updater::startUpdate(int ageLimit, int timeout, bool useNetwork)
 {
@@ -74,6 +381,7 @@ void Updater::startUpdate(int ageLimit, int timeout, bool useNetwork)
   prependOfficialSourceIfRelevant(sources);
   SHOW(sources);
   _errorMessages.clear();
+  _queuedDownloads.clear();
   _networkAccessManager = new QNetworkAccessManager(this);
   connect(_networkAccessManager, &QNetworkAccessManager::finished, this, &Updater::onNetworkReplyFinished);
   _someNetworkUpdatesAchieved = false;
@@ -84,38 +392,74 @@ void Updater::startUpdate(int ageLimit, int timeout, bool useNetwork)
         QString filename = localFilename(str);
         QFileInfo info(filename);
         if (!info.exists() || (info.lastModified() < limit)) {
-          TRACE << "Downloading" << str << "to" << filename;
-          QUrl url(str);
-          QNetworkRequest request(url);
-          request.setHeader(QNetworkRequest::UserAgentHeader, pluginFullName());
-          // PRIVACY NOTICE (to be displayed in one of the "About" filters of the plugin
-          //
-          // PRIVACY NOTICE
-          // This plugin may download up-to-date filter definitions from the gmic.eu server.
-          // It is the case when first launched after a fresh installation, and periodically
-          // with a frequency which can be set in the settings dialog.
-          // The user should be aware that the following information may be retrieved
-          // from the server logs: IP address of the client; date and time of the request;
-          // as well as a short string, supplied through the HTTP protocol "User Agent" header
-          // field, which describes the full plugin version as shown in the window title
-          // (e.g. "G'MIC-Qt for GIMP 2.8 - Linux 64 bits - 2.2.1_pre#180301").
-          //
-          // Note that this information may solely be used for purely anonymous
-          // statistical purposes.
-          _pendingReplies.insert(_networkAccessManager->get(request));
+          _queuedDownloads.push_back(str);
         }
       }
     }
   }
-  if (_pendingReplies.isEmpty()) {
+  if (_queuedDownloads.isEmpty()) {
     QTimer::singleShot(0, this, &Updater::onUpdateNotNecessary); // While GUI is Idle
     _networkAccessManager->deleteLater();
+    _networkAccessManager = nullptr;
   } else {
+    startQueuedDownloads();
     QTimer::singleShot(timeout * 1000, this, &Updater::cancelAllPendingDownloads);
   }
   TIMING;
 }
 
+void Updater::startDownload(const QString & url)
+{
+  const QString filename = localFilename(url);
+  TRACE << "Downloading" << url << "to" << filename;
+  QNetworkRequest request{QUrl(url)};
+  request.setHeader(QNetworkRequest::UserAgentHeader, pluginFullName());
+  // PRIVACY NOTICE (to be displayed in one of the "About" filters of the plugin
+  //
+  // PRIVACY NOTICE
+  // This plugin may download up-to-date filter definitions from the gmic.eu server.
+  // It is the case when first launched after a fresh installation, and periodically
+  // with a frequency which can be set in the settings dialog.
+  // The user should be aware that the following information may be retrieved
+  // from the server logs: IP address of the client; date and time of the request;
+  // as well as a short string, supplied through the HTTP protocol "User Agent" header
+  // field, which describes the full plugin version as shown in the window title
+  // (e.g. "G'MIC-Qt for GIMP 2.8 - Linux 64 bits - 2.2.1_pre#180301").
+  //
+  // Note that this information may solely be used for purely anonymous
+  // statistical purposes.
+  if (QFileInfo(filename).size() > 0) {
+    // Validators are only relevant if the file they describe is still there
+    QSettings settings;
+    const QString key = validatorsKey(url);
+    const QByteArray etag = settings.value(key + "/ETag").toString().toLatin1();
+    const QByteArray lastModified = settings.value(key + "/LastModified").toString().toLatin1();
+    if (!etag.isEmpty()) {
+      request.setRawHeader("If-None-Match", etag);
+    }
+    if (!lastModified.isEmpty()) {
+      request.setRawHeader("If-Modified-Since", lastModified);
+    }
+  }
+  QNetworkReply * reply = _networkAccessManager->get(request);
+  _writers.insert(reply, new DownloadWriter(filename));
+  connect(reply, &QNetworkReply::readyRead, this, &Updater::onReplyDataAvailable);
+  _pendingReplies.insert(reply);
+}
+
+void Updater::startQueuedDownloads()
+{
+  while (!_queuedDownloads.isEmpty() && (_pendingReplies.size() < MaxParallelDownloads)) {
+    startDownload(_queuedDownloads.takeFirst());
+  }
+}
+
+QString Updater::validatorsKey(const QString & url)
+{
+  const QByteArray hash = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Md5).toHex();
+  return QString("%1/%2").arg(FILTER_SOURCES_VALIDATORS_KEY).arg(QString::fromLatin1(hash));
+}
+
 QList<QString> Updater::errorMessages()
 {
   return _errorMessages;
@@ -126,40 +470,76 @@ bool Updater::allDownloadsOk() const
   return _errorMessages.isEmpty();
 }
 
-void Updater::processReply(QNetworkReply * reply)
+void Updater::processReply(QNetworkReply * reply, DownloadWriter & writer)
 {
   QString url = reply->request().url().toString();
-  if (!reply->bytesAvailable()) {
-    return;
-  }
-  QByteArray array = reply->readAll();
-  if (array.isNull()) {
-    _errorMessages << QString(tr("Error downloading %1 (empty file?)")).arg(url);
+  QString filename = localFilename(url);
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status == 304) {
+    TRACE << "Not modified:" << url;
+    // Restart the age of the local file, as a download would have
+    touchFile(filename);
     return;
   }
-  if (isCImgCompressed(array)) {
-    TRACE << QString("Decompressing reply from") << url;
-    QByteArray tmp = cimgzDecompress(array);
-    array = tmp;
+  if (status == 200) {
+    writer.write(reply->readAll());
   }
-  if (array.isNull() || !array.contains("#@gui")) {
-    _errorMessages << QString(tr("Could not read/decompress %1")).arg(url);
+  if (!writer.hasData()) {
     return;
   }
-  QString filename = localFilename(url);
-  if (!safelyWrite(array, filename)) {
-    _errorMessages << QString(tr("Error writing file %1")).arg(filename);
+  if (!writer.commit()) {
+    if (writer.error() == DownloadWriter::Error::Writing) {
+      _errorMessages << QString(tr("Error writing file %1")).arg(filename);
+    } else {
+      _errorMessages << QString(tr("Could not read/decompress %1")).arg(url);
+    }
     return;
   }
+  QSettings settings;
+  const QString key = validatorsKey(url);
+  const QByteArray etag = reply->rawHeader("ETag");
+  const QByteArray lastModified = reply->rawHeader("Last-Modified");
+  if (etag.isEmpty()) {
+    settings.remove(key + "/ETag");
+  } else {
+    settings.setValue(key + "/ETag", QString::fromLatin1(etag));
+  }
+  if (lastModified.isEmpty()) {
+    settings.remove(key + "/LastModified");
+  } else {
+    settings.setValue(key + "/LastModified", QString::fromLatin1(lastModified));
+  }
   _someNetworkUpdatesAchieved = true;
 }
 
+void Updater::onReplyDataAvailable()
+{
+  auto reply = qobject_cast<QNetworkReply *>(sender());
+  DownloadWriter * writer = _writers.value(reply, nullptr);
+  // Content of redirections and "Not modified" replies is not a source
+  if (!writer || (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 200)) {
+    return;
+  }
+  if (!writer->write(reply->readAll())) {
+    reply->abort();
+  }
+}
+
 void Updater::onNetworkReplyFinished(QNetworkReply * reply)
 {
   TIMING;
+  std::unique_ptr<DownloadWriter> writer(_writers.take(reply));
   QNetworkReply::NetworkError error = reply->error();
-  if (error == QNetworkReply::NoError) {
-    processReply(reply);
+  if (writer && writer->failed()) {
+    const QString url = reply->request().url().toString();
+    if (writer->error() == DownloadWriter::Error::Writing) {
+      _errorMessages << QString(tr("Error writing file %1")).arg(localFilename(url));
+    } else {
+      _errorMessages << QString(tr("Could not read/decompress %1")).arg(url);
+    }
+    touchFile(localFilename(url));
+  } else if ((error == QNetworkReply::NoError) && writer) {
+    processReply(reply, *writer);
   } else {
     QString str;
     QDebug d(&str);
@@ -176,6 +556,7 @@ void Updater::onNetworkReplyFinished(QNetworkReply * reply)
     touchFile(localFilename(reply->url().toString()));
   }
   _pendingReplies.remove(reply);
+  startQueuedDownloads();
   if (_pendingReplies.isEmpty()) {
     if (_errorMessages.isEmpty()) {
       emit updateIsDone((int)UpdateStatus::Successful);
@@ -199,6 +580,10 @@ void Updater::cancelAllPendingDownloads()
   TIMING;
   // Make a copy because aborting will call onNetworkReplyFinished, and
   // thus modify the _pendingReplies set.
+  for (const QString & url : _queuedDownloads) {
+    _errorMessages << QString(tr("Download timeout: %1")).arg(url);
+  }
+  _queuedDownloads.clear();
   QSet<QNetworkReply *> replies = _pendingReplies;
   for (QNetworkReply * reply : replies) {
     _errorMessages << QString(tr("Download timeout: %1")).arg(reply->request().url().toString());
@@ -211,20 +596,6 @@ void Updater::onUpdateNotNecessary()
   emit updateIsDone((int)UpdateStatus::NotNecessary);
 }
 
-QByteArray Updater::cimgzDecompress(const QByteArray & array)
-{
-  try {
-    gmic_library::gmic_image<char> buffer(array.constData(), array.size(), 1, 1, 1, true);
-    gmic_library::gmic_list<char> list = gmic_library::gmic_list<char>::get_unserialize(buffer);
-    if (list.size() == 1) {
-      return {list[0].data(), int(list[0].size())};
-    }
-  } catch (...) {
-    Logger::warning("Updater::cimgzDecompress(): Error decompressing data");
-  }
-  return {};
-}
-
 QByteArray Updater::cimgzDecompressFile(const QString & filename)
 {
   gmic_library::gmic_image<unsigned char> buffer;
@@ -38,6 +38,7 @@
 #include <QSet>
 #include <QSettings>
 #include <QString>
+#include <QStringList>
 #include <QTemporaryFile>
 #include <QTimer>
 #include <memory>
@@ -45,6 +46,8 @@
 
 namespace GmicQt
 {
+class DownloadWriter;
+
 class Updater : public QObject {
   Q_OBJECT
 
@@ -64,6 +67,8 @@ public:
    * @brief Launch download of files that are either not present locally, or
    *        older than the given age limit (in hours). To force download
    *        of all the sources, set the age limit to zero.
+   *        Requests are conditional for files already present, so that an
+   *        unchanged source costs a single round-trip without any content.
    *
    * @param ageLimit Delay between 2 network updates in hours
    * @param timeout in seconds before aborting downloads
@@ -77,6 +82,8 @@ public:
 
   bool someNetworkUpdateAchieved() const;
 
+  static const int MaxParallelDownloads = 4;
+
 signals:
   void updateIsDone(int status);
 
@@ -87,16 +94,21 @@ public slots:
   void onUpdateNotNecessary();
 
 protected:
-  void processReply(QNetworkReply * reply);
+  void processReply(QNetworkReply * reply, DownloadWriter & writer);
+
+private slots:
+  void onReplyDataAvailable();
 
 private:
   static QString localFilename(QString url);
+  static QString validatorsKey(const QString & url);
+  void startDownload(const QString & url);
+  void startQueuedDownloads();
   void appendBuiltinGmicStdlib(QByteArray & array) const;
   bool appendLocalGmicFile(QByteArray & array, QString filename) const;
   void prependOfficialSourceIfRelevant(QStringList & list);
   explicit Updater(QObject * parent);
   static bool isCImgCompressed(const QByteArray & data);
-  static QByteArray cimgzDecompress(const QByteArray & array);
   static QByteArray cimgzDecompressFile(const QString & filename);
   static std::unique_ptr<Updater> _instance;
   static OutputMessageMode _outputMessageMode;
@@ -104,6 +116,8 @@ private:
 
   QNetworkAccessManager * _networkAccessManager;
   QSet<QNetworkReply *> _pendingReplies;
+  QMap<QNetworkReply *, DownloadWriter *> _writers;
+  QStringList _queuedDownloads; // Waiting for one of the MaxParallelDownloads slots
   QList<QString> _errorMessages;
   bool _someNetworkUpdatesAchieved;
 };
@@ -0,0 +1,166 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file PerformancePanel.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "Widgets/PerformancePanel.h"
+#include <QLabel>
+#include <QVBoxLayout>
+#include "Common.h"
+#include "ImageBufferPool.h"
+#include "Misc.h"
+#include "ResourceUsage.h"
+#include "ThreadBudget.h"
+
+namespace
+{
+const int StageRows = GmicQt::PerformanceStats::StageCount;
+const int InputBytesRow = StageRows;
+const int OutputBytesRow = StageRows + 1;
+const int PeakMemoryRow = StageRows + 2;
+const int RowCount = StageRows + 3;
+} // namespace
+
+namespace GmicQt
+{
+
+PerformancePanel::PerformancePanel(QWidget * parent) : QWidget(parent)
+{
+  setWindowTitle(tr("G'MIC-Qt performance"));
+  auto layout = new QVBoxLayout(this);
+  _label = new QLabel(this);
+  _label->setTextFormat(Qt::RichText);
+  _label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+  layout->addWidget(_label);
+  _timer.setInterval(250);
+  connect(&_timer, &QTimer::timeout, this, &PerformancePanel::refresh);
+  refresh();
+}
+
+PerformancePanel::~PerformancePanel() = default;
+
+void PerformancePanel::showEvent(QShowEvent * event)
+{
+  refresh();
+  _timer.start();
+  QWidget::showEvent(event);
+}
+
+void PerformancePanel::hideEvent(QHideEvent * event)
+{
+  _timer.stop();
+  QWidget::hideEvent(event);
+}
+
+QString PerformancePanel::runColumn(const PerformanceStats::Run & run, int row)
+{
+  if (!run.started) {
+    return QString("-");
+  }
+  if (row < StageRows) {
+    return readableDuration(run.stageDurations[row] / 1000);
+  }
+  switch (row) {
+  case InputBytesRow:
+    return readableSize(run.inputBytes);
+  case OutputBytesRow:
+    return readableSize(run.outputBytes);
+  case PeakMemoryRow:
+    return run.peakResidentSetSize ? readableSize(run.peakResidentSetSize) : QString("?");
+  }
+  return QString();
+}
+
+void PerformancePanel::refresh()
+{
+  PerformanceStats::residentSetSize(); // Keep peak value of current run up to date
+  const PerformanceStats::Run current = PerformanceStats::currentRun();
+  const PerformanceStats::Run last = PerformanceStats::lastRun();
+
+  QString lastTitle = tr("Last run");
+  if (last.started) {
+    lastTitle = last.completed ? last.name.toHtmlEscaped() : tr("%1 (aborted)").arg(last.name.toHtmlEscaped());
+  }
+  QString text("<table cellspacing=\"4\">");
+  text += QString("<tr><th></th><th>%1</th><th>%2</th></tr>").arg(current.active ? current.name.toHtmlEscaped() : tr("Current run")).arg(lastTitle);
+  for (int row = 0; row < RowCount; ++row) {
+    QString title;
+    if (row < StageRows) {
+      title = PerformanceStats::stageName(static_cast<PerformanceStats::Stage>(row));
+    } else if (row == InputBytesRow) {
+      title = tr("Input images");
+    } else if (row == OutputBytesRow) {
+      title = tr("Output images");
+    } else {
+      title = tr("Peak memory");
+    }
+    text += QString("<tr><td>%1</td><td align=\"right\">%2</td><td align=\"right\">%3</td></tr>") //
+                .arg(title)
+                .arg(current.active ? runColumn(current, row) : QString("-"))
+                .arg(runColumn(last, row));
+  }
+  text += "</table>";
+
+  text += QString("<p>%1</p>").arg(tr("Filter threads: %1 running, %2 aborted").arg(PerformanceStats::runningFilterThreadCount()).arg(PerformanceStats::abortedFilterThreadCount()));
+  QStringList caches;
+  for (int i = 0; i < PerformanceStats::CacheCount; ++i) {
+    const PerformanceStats::Cache cache = static_cast<PerformanceStats::Cache>(i);
+    const PerformanceStats::CacheCounters counters = PerformanceStats::cacheCounters(cache);
+    const quint64 total = counters.hits + counters.misses;
+    if (total) {
+      caches << tr("%1: %2% of %3").arg(PerformanceStats::cacheName(cache)).arg(static_cast<int>(100 * counters.hits / total)).arg(total);
+    } else {
+      caches << tr("%1: -").arg(PerformanceStats::cacheName(cache));
+    }
+  }
+  text += QString("<p>%1<br/>%2</p>").arg(tr("Cache hit rates:")).arg(caches.join("<br/>"));
+
+  QStringList budgets;
+  for (int i = 0; i < ThreadBudget::PriorityCount; ++i) {
+    const ThreadBudget::Priority priority = static_cast<ThreadBudget::Priority>(i);
+    const ThreadBudget::Metrics metrics = ThreadBudget::metrics(priority);
+    if (metrics.jobSeconds > 0.0) {
+      budgets << tr("%1: %2 threads on average, %3 run(s)").arg(ThreadBudget::priorityName(priority)).arg(metrics.threadSeconds / metrics.jobSeconds, 0, 'f', 1).arg(metrics.jobs);
+    } else {
+      budgets << tr("%1: -").arg(ThreadBudget::priorityName(priority));
+    }
+  }
+  const RunResources lastResources = ResourceMeter::last();
+  const QString parallelism = ResourceMeter::effectiveParallelismText(lastResources);
+  text += QString("<p>%1<br/>%2<br/>%3</p>")
+              .arg(tr("CPU budget: %1 thread(s) of %2 cores assigned to %3 run(s)").arg(ThreadBudget::assignedThreadCount()).arg(ThreadBudget::coreCount()).arg(ThreadBudget::runningJobCount()))
+              .arg(budgets.join("<br/>"))
+              .arg(tr("Effective parallelism of the last run: %1 (budget %2)").arg(parallelism).arg(lastResources.threadCount));
+
+  const ImageBufferPool::Counters pool = ImageBufferPool::counters();
+  const QString reuse = pool.requests ? QString("%1%").arg(static_cast<int>(100 * pool.hits / pool.requests)) : QString("-");
+  text += QString("<p>%1</p>")
+              .arg(tr("Buffer pool: %1 reused of %2 requests, %3 discarded, %4 pooled (peak %5)")
+                       .arg(reuse)
+                       .arg(pool.requests)
+                       .arg(pool.discards)
+                       .arg(readableSize(pool.pooledBytes))
+                       .arg(readableSize(pool.peakPooledBytes)));
+  _label->setText(text);
+}
+
+} // namespace GmicQt
@@ -1,6 +1,6 @@
 /** -*- mode: c++ ; c-basic-offset: 2 -*-
  *
- *  @file TimeLogger.h
+ *  @file PerformancePanel.h
  *
  *  Copyright 2017 Sebastien Fourey
  *
@@ -22,29 +22,42 @@
  *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
  *
  */
-#ifndef GMIC_QT_TIMELOGGER_H
-#define GMIC_QT_TIMELOGGER_H
+#ifndef GMIC_QT_PERFORMANCEPANEL_H
+#define GMIC_QT_PERFORMANCEPANEL_H
 
-#include <cstdio>
-#include <memory>
+#include <QTimer>
+#include <QWidget>
+#include "PerformanceStats.h"
+
+class QLabel;
 
 namespace GmicQt
 {
 
-class TimeLogger {
+/**
+ * Developer panel showing PerformanceStats figures for the current and
+ * the last run. Refreshed periodically while visible.
+ */
+class PerformancePanel : public QWidget {
+  Q_OBJECT
+
 public:
-  ~TimeLogger();
-  static TimeLogger * getInstance();
-  void step(const char * function, int line, const char * filename);
+  explicit PerformancePanel(QWidget * parent);
+  ~PerformancePanel() override;
+
+public slots:
+  void refresh();
+
+protected:
+  void showEvent(QShowEvent *) override;
+  void hideEvent(QHideEvent *) override;
 
 private:
-  TimeLogger();
-  TimeLogger(const TimeLogger &) = delete;
-  TimeLogger & operator=(const TimeLogger &) = delete;
-  FILE * _file;
-  static std::unique_ptr<TimeLogger> _instance;
+  static QString runColumn(const PerformanceStats::Run & run, int row);
+  QLabel * _label;
+  QTimer _timer;
 };
 
 } // namespace GmicQt
 
-#endif // GMIC_QT_TIMELOGGER_H
+#endif // GMIC_QT_PERFORMANCEPANEL_H
@@ -49,10 +49,6 @@ const PreviewWidget::PreviewRect PreviewWidget::PreviewRect::Full{0.0, 0.0, 1.0,
 PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent)
 {
   setAutoFillBackground(false);
-  _image = new gmic_library::gmic_image<float>;
-  _image->assign();
-  _savedPreview = new gmic_library::gmic_image<float>;
-  _savedPreview->assign();
   _transparency.load(":resources/transparency.png");
 
   _visibleRect = PreviewRect::Full;
@@ -81,22 +77,22 @@ PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent)
 PreviewWidget::~PreviewWidget()
 {
   QSettings().setValue(PREVIEW_SPLITTER_KEY, static_cast<int>(_savedPreviewType));
-  delete _image;
-  delete _savedPreview;
 }
 
-const gmic_library::gmic_image<float> & PreviewWidget::image() const
+const QImage & PreviewWidget::image() const
 {
-  return *_image;
+  return _image;
 }
 
-void PreviewWidget::setPreviewImage(const gmic_library::gmic_image<float> & image)
+void PreviewWidget::setPreviewImage(const QImage & image, const QSize & imageSize)
 {
   _errorMessage.clear();
   _errorImage = QImage();
   _overlayMessage.clear();
-  *_image = image;
-  *_savedPreview = image;
+  _image = image;
+  _imageSize = imageSize;
+  _savedPreview = image;
+  _savedPreviewSize = imageSize;
   _savedPreviewIsValid = true;
   updateOriginalImagePosition();
   _paintOriginalImage = false;
@@ -216,7 +212,7 @@ void PreviewWidget::updatePreviewImagePosition()
    *  we are at "full image" zoom of an image smaller than the widget,
    *  then the image should fit the widget size.
    */
-  const QSize previewImageSize(_image->width(), _image->height());
+  const QSize previewImageSize(_imageSize);
   if ((previewImageSize != _originalImageScaledSize) || (isAtFullZoom() && (_currentZoomFactor > 1.0))) {
     QSize imageSize;
     if (previewImageSize != _originalImageScaledSize) {
@@ -417,7 +413,7 @@ void PreviewWidget::paintPreview(QPainter & painter)
     return;
   }
 
-  if (!_image->width() && !_image->height()) {
+  if (_imageSize.isEmpty() || _image.isNull()) {
     painter.fillRect(rect(), QBrush(_transparency));
     paintKeypoints(painter);
     return;
@@ -425,12 +421,11 @@ void PreviewWidget::paintPreview(QPainter & painter)
 
   updatePreviewImagePosition();
 
-  if (hasAlphaChannel(*_image)) {
+  if (_image.hasAlphaChannel()) {
     painter.fillRect(_imagePosition, QBrush(_transparency));
   }
-  QImage qimage;
-  convertGmicImageToQImage(_image->get_resize(_imagePosition.width(), _imagePosition.height(), 1, -100, 1), qimage);
-  painter.drawImage(_imagePosition, qimage);
+  // The image was converted to display size by the filter thread
+  painter.drawImage(_imagePosition, _image);
   paintKeypoints(painter);
 }
 
@@ -574,6 +569,7 @@ void PreviewWidget::paintSplittedPreview(QPainter & painter)
 
 void PreviewWidget::paintEvent(QPaintEvent * e)
 {
+  TRACE_SPAN("Preview paint", "display");
   QPainter painter(this);
   if (_paintOriginalImage) {
     paintOriginalImage(painter);
@@ -1093,6 +1089,11 @@ void PreviewWidget::setZoomLevel(double zoom)
   emit zoomChanged(_currentZoomFactor);
 }
 
+float PreviewWidget::previewFactor() const
+{
+  return _previewFactor;
+}
+
 double PreviewWidget::defaultZoomFactor() const
 {
   if (_fullImageSize.isNull()) {
@@ -1254,7 +1255,8 @@ void PreviewWidget::invalidateSavedPreview()
 
 void PreviewWidget::restorePreview()
 {
-  *_image = *_savedPreview;
+  _image = _savedPreview;
+  _imageSize = _savedPreviewSize;
 }
 
 void PreviewWidget::enableRightClick()
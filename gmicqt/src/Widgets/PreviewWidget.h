@@ -61,13 +61,14 @@ public:
   void getPositionStringCorrection(double & xFactor, double & yFactor) const;
   double currentZoomFactor() const;
   double defaultZoomFactor() const;
+  float previewFactor() const;
   void updateVisibleRect();
   void centerVisibleRect();
-  void setPreviewImage(const gmic_library::gmic_image<float> & image);
+  void setPreviewImage(const QImage & image, const QSize & imageSize);
   void setOverlayMessage(const QString &);
   void clearOverlayMessage();
   void setPreviewErrorMessage(const QString &);
-  const gmic_library::gmic_image<float> & image() const;
+  const QImage & image() const;
   void translateNormalized(double dx, double dy);
   void translateFullImage(double dx, double dy);
   void setPreviewEnabled(bool on);
@@ -182,8 +183,10 @@ private:
 
   QSize originalImageCropSize();
   void saveVisibleCenter();
-  gmic_library::gmic_image<float> * _image;
-  gmic_library::gmic_image<float> * _savedPreview;
+  QImage _image;     // Display-sized preview
+  QSize _imageSize;  // Size of the filter output
+  QImage _savedPreview;
+  QSize _savedPreviewSize;
   QSize _fullImageSize;
   double _currentZoomFactor;
   ZoomConstraint _zoomConstraint;
@@ -23,25 +23,21 @@
  *
  */
 #include "Widgets/ProgressInfoWidget.h"
-#include <QFile>
 #include <QFontMetrics>
 #include <QGuiApplication>
 #include <QScreen>
 #include "GmicProcessor.h"
 #include "IconLoader.h"
 #include "Misc.h"
+#include "PerformanceStats.h"
+#include "Settings.h"
+#include "Widgets/PerformancePanel.h"
 #include "ui_progressinfowidget.h"
 
-#ifdef _IS_WINDOWS_
-#include <windows.h>
-#include <process.h>
-#include <psapi.h>
-#endif
-
 namespace GmicQt
 {
 
-ProgressInfoWidget::ProgressInfoWidget(QWidget * parent) : QWidget(parent), ui(new Ui::ProgressInfoWidget), _gmicProcessor(nullptr)
+ProgressInfoWidget::ProgressInfoWidget(QWidget * parent) : QWidget(parent), ui(new Ui::ProgressInfoWidget), _gmicProcessor(nullptr), _performancePanel(nullptr)
 {
   ui->setupUi(this);
   _mode = Mode::GmicProcessing;
@@ -139,6 +135,7 @@ void ProgressInfoWidget::startFilterThreadAnimationAndShow()
   _timer.setInterval(250);
   _timer.start();
   show();
+  updatePerformancePanelVisibility();
 }
 
 void ProgressInfoWidget::startFiltersUpdateAnimationAndShow()
@@ -178,6 +175,21 @@ void ProgressInfoWidget::showBusyIndicator()
   ui->progressBar->setRange(0, 0);
 }
 
+void ProgressInfoWidget::updatePerformancePanelVisibility()
+{
+  if (!Settings::performancePanelEnabled()) {
+    if (_performancePanel) {
+      _performancePanel->hide();
+    }
+    return;
+  }
+  if (!_performancePanel) {
+    _performancePanel = new PerformancePanel(this);
+    _performancePanel->setWindowFlags(Qt::Tool);
+  }
+  _performancePanel->show();
+}
+
 void ProgressInfoWidget::updateThreadInformation()
 {
   int ms = _gmicProcessor->duration();
@@ -198,26 +210,10 @@ void ProgressInfoWidget::updateThreadInformation()
     }
   }
   QString durationStr = readableDuration(ms);
-#ifdef _IS_UNIX_
+#if defined(_IS_UNIX_) || defined(_IS_WINDOWS_)
   // Get memory usage
-  QString memoryStr("? KiB");
-  QFile status("/proc/self/status");
-  if (status.open(QFile::ReadOnly)) {
-    QByteArray text = status.readAll();
-    const char * str = strstr(text.constData(), "VmRSS:");
-    quint64 kiB;
-    if (str && sscanf(str + 7, "%llu", &kiB)) {
-      memoryStr = readableSize(kiB * 1024);
-    }
-  }
-  ui->label->setText(QString(tr("[Processing %1 | %2]")).arg(durationStr).arg(memoryStr));
-#elif defined(_IS_WINDOWS_)
-  PROCESS_MEMORY_COUNTERS counters;
-  quint64 kiB = 0;
-  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
-    kiB = static_cast<quint64>(counters.WorkingSetSize / 1024);
-  }
-  QString memoryStr = readableSize(kiB * 1024);
+  const quint64 memory = PerformanceStats::residentSetSize();
+  QString memoryStr = memory ? readableSize(memory) : QString("? KiB");
   ui->label->setText(QString(tr("[Processing %1 | %2]")).arg(durationStr).arg(memoryStr));
 #else
   ui->label->setText(QString(tr("[Processing %1]")).arg(durationStr));
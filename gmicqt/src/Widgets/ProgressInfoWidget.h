@@ -35,6 +35,7 @@ class ProgressInfoWidget;
 namespace GmicQt
 {
 class GmicProcessor;
+class PerformancePanel;
 
 class ProgressInfoWidget : public QWidget {
   Q_OBJECT
@@ -61,6 +62,7 @@ public slots:
   void startFilterThreadAnimationAndShow();
   void startFiltersUpdateAnimationAndShow();
   void showBusyIndicator();
+  void updatePerformancePanelVisibility();
 signals:
   void canceled();
 
@@ -70,6 +72,7 @@ private:
 
   Ui::ProgressInfoWidget * ui;
   const GmicProcessor * _gmicProcessor;
+  PerformancePanel * _performancePanel;
   QTimer _timer;
   QTimer _showingTimer;
   Mode _mode;
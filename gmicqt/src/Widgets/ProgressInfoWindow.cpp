@@ -37,6 +37,7 @@
 #include "HeadlessProcessor.h"
 #include "Settings.h"
 #include "Updater.h"
+#include "Widgets/PerformancePanel.h"
 #include "ui_progressinfowindow.h"
 #include "gmic.h"
 
@@ -58,6 +59,9 @@ ProgressInfoWindow::ProgressInfoWindow(HeadlessProcessor * processor) : QMainWin
   connect(processor, &HeadlessProcessor::progression, this, &ProgressInfoWindow::onProgress);
   connect(processor, &HeadlessProcessor::done, this, &ProgressInfoWindow::onProcessingFinished);
   _isShown = false;
+  if (Settings::performancePanelEnabled()) {
+    ui->centralwidget->layout()->addWidget(new PerformancePanel(ui->centralwidget));
+  }
 
 #ifndef _GMIC_QT_DISABLE_THEMING_
   if (Settings::darkThemeEnabled()) {
@@ -19,6 +19,7 @@ set(gmic_bqm_SRCS
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterwidget.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterdialog.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmprocessor.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmpipeline.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmtool.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmplugin.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterchain.cpp
@@ -0,0 +1,271 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2019-11-28
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Pipelined load and filter stages of queue items.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#include "gmicbqmpipeline.h"
+
+// Qt includes
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QWaitCondition>
+
+// digikam includes
+
+#include "digikam_debug.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+namespace
+{
+
+struct PipelineState
+{
+    QMutex                        mutex;
+    QWaitCondition                released;
+    int                           capacity[GmicBqmPipeline::NumberOfStages] = { 2, 1 };
+    int                           occupied[GmicBqmPipeline::NumberOfStages] = { 0, 0 };
+    GmicBqmPipeline::StageMetrics metrics[GmicBqmPipeline::NumberOfStages];
+    QElapsedTimer                 timer;                ///< Started by the first item entering the pipeline.
+    int                           inFlight = 0;         ///< Items between beginItem() and endItem().
+    quint64                       batch    = 0;         ///< Current batch number.
+    quint64                       reported = 0;         ///< Last batch logged.
+    QElapsedTimer                 idle;                 ///< Started when the last item in flight leaves.
+};
+
+PipelineState& state()
+{
+    static PipelineState pipeline;
+
+    return pipeline;
+}
+
+const char* const s_stageNames[GmicBqmPipeline::NumberOfStages] = { "load", "filter" };
+
+/**
+ * Idle time after which the pipeline is considered done with a batch. It covers
+ * the gap between two items of a queue processed by a single worker.
+ */
+const int s_batchIdleMS = 2000;
+
+void resetMetricsLocked(PipelineState& s)
+{
+    for (int i = 0 ; i < GmicBqmPipeline::NumberOfStages ; ++i)
+    {
+        s.metrics[i] = GmicBqmPipeline::StageMetrics();
+    }
+
+    s.timer.invalidate();
+}
+
+void reportBatch(quint64 batch)
+{
+    PipelineState& s = state();
+
+    {
+        QMutexLocker lock(&s.mutex);
+
+        if (
+            (s.inFlight != 0)                                    ||
+            (s.batch    != batch)                                ||
+            (s.reported == batch)                                ||
+            (s.idle.isValid() && (s.idle.elapsed() < s_batchIdleMS))
+           )
+        {
+            return;
+        }
+
+        s.reported = batch;
+    }
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: pipeline:" << GmicBqmPipeline::report();
+}
+
+} // namespace
+
+void GmicBqmPipeline::beginItem()
+{
+    PipelineState& s = state();
+    QMutexLocker lock(&s.mutex);
+
+    if ((s.inFlight == 0) && (!s.idle.isValid() || (s.idle.elapsed() >= s_batchIdleMS)))
+    {
+        resetMetricsLocked(s);
+        ++s.batch;
+    }
+
+    ++s.inFlight;
+}
+
+void GmicBqmPipeline::endItem()
+{
+    PipelineState& s = state();
+    quint64 batch    = 0;
+
+    {
+        QMutexLocker lock(&s.mutex);
+
+        s.inFlight = qMax(0, s.inFlight - 1);
+
+        if (s.inFlight != 0)
+        {
+            return;
+        }
+
+        s.idle.start();
+        batch = s.batch;
+    }
+
+    // The worker threads have no event loop: the end of batch check runs in the main thread.
+
+    QCoreApplication* const app = QCoreApplication::instance();
+
+    if (!app)
+    {
+        return;
+    }
+
+    QMetaObject::invokeMethod(app, [app, batch]()
+        {
+            QTimer::singleShot(s_batchIdleMS + 100, app, [batch]()
+                {
+                    reportBatch(batch);
+                }
+            );
+        },
+        Qt::QueuedConnection
+    );
+}
+
+bool GmicBqmPipeline::enter(Stage stage, const std::atomic<bool>& cancelled)
+{
+    PipelineState& s = state();
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+
+    QMutexLocker lock(&s.mutex);
+
+    if (!s.timer.isValid())
+    {
+        s.timer.start();
+    }
+
+    while (s.occupied[stage] >= s.capacity[stage])
+    {
+        if (cancelled)
+        {
+            return false;
+        }
+
+        // Wake up regularly to check for cancellation.
+
+        s.released.wait(&s.mutex, 100);
+    }
+
+    if (cancelled)
+    {
+        return false;
+    }
+
+    ++s.occupied[stage];
+    s.metrics[stage].waitMS += waitTimer.elapsed();
+
+    return true;
+}
+
+void GmicBqmPipeline::leave(Stage stage, qint64 busyMS, quint64 bytes)
+{
+    PipelineState& s = state();
+
+    {
+        QMutexLocker lock(&s.mutex);
+
+        s.occupied[stage]         = qMax(0, s.occupied[stage] - 1);
+        s.metrics[stage].items   += 1;
+        s.metrics[stage].busyMS  += busyMS;
+        s.metrics[stage].bytes   += bytes;
+    }
+
+    s.released.wakeAll();
+}
+
+void GmicBqmPipeline::setCapacity(Stage stage, int capacity)
+{
+    PipelineState& s = state();
+
+    {
+        QMutexLocker lock(&s.mutex);
+        s.capacity[stage] = qMax(1, capacity);
+    }
+
+    s.released.wakeAll();
+}
+
+int GmicBqmPipeline::capacity(Stage stage)
+{
+    PipelineState& s = state();
+    QMutexLocker lock(&s.mutex);
+
+    return s.capacity[stage];
+}
+
+GmicBqmPipeline::StageMetrics GmicBqmPipeline::metrics(Stage stage)
+{
+    PipelineState& s = state();
+    QMutexLocker lock(&s.mutex);
+
+    return s.metrics[stage];
+}
+
+void GmicBqmPipeline::resetMetrics()
+{
+    PipelineState& s = state();
+    QMutexLocker lock(&s.mutex);
+
+    resetMetricsLocked(s);
+}
+
+QString GmicBqmPipeline::report()
+{
+    PipelineState& s = state();
+    QMutexLocker lock(&s.mutex);
+
+    const qint64 wallMS = s.timer.isValid() ? s.timer.elapsed() : 0;
+    QString text        = QString::fromLatin1("%1 item(s) in %2 ms")
+                              .arg(s.metrics[Filter].items)
+                              .arg(wallMS);
+
+    for (int i = 0 ; i < NumberOfStages ; ++i)
+    {
+        const StageMetrics& m = s.metrics[i];
+        const double busy     = qMax<qint64>(1, m.busyMS) / 1000.0;
+
+        text += QString::fromLatin1(" | %1: %2 item(s), %3 items/s, %4 MB/s, busy %5 ms, waiting %6 ms")
+                    .arg(QLatin1String(s_stageNames[i]))
+                    .arg(m.items)
+                    .arg(m.items / busy, 0, 'f', 2)
+                    .arg((m.bytes / (1024.0 * 1024.0)) / busy, 0, 'f', 1)
+                    .arg(m.busyMS)
+                    .arg(m.waitMS);
+    }
+
+    return text;
+}
+
+} // namespace DigikamBqmGmicQtPlugin
@@ -0,0 +1,100 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2019-11-28
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Pipelined load and filter stages of queue items.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#pragma once
+
+// C++ includes
+
+#include <atomic>
+
+// Qt includes
+
+#include <QString>
+#include <QtGlobal>
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+/**
+ * Coordinates the load and filter stages of the queue items processed
+ * concurrently by the Batch Queue Manager worker threads, so that decoding of
+ * the next items and encoding of the previous ones overlap with filtering.
+ *
+ * An item keeps its load slot until it gets a filter slot, so the number of
+ * decoded images waiting for the filter is bounded by the load capacity.
+ * Encoding is not a stage: the output is written by the Batch Queue Manager
+ * after the tool returns, out of the pipeline control, and it is bounded by
+ * the number of worker threads only.
+ */
+class GmicBqmPipeline
+{
+
+public:
+
+    enum Stage
+    {
+        Load = 0,
+        Filter,
+
+        NumberOfStages      ///< The last one to enumerate
+    };
+
+    struct StageMetrics
+    {
+        int     items   = 0;    ///< Items which left the stage.
+        qint64  busyMS  = 0;    ///< Time spent doing the stage work, all items.
+        qint64  waitMS  = 0;    ///< Time spent waiting for a slot of the stage.
+        quint64 bytes   = 0;    ///< Image bytes handled by the stage.
+    };
+
+public:
+
+    /**
+     * Wait for a slot in a stage. Returns false if cancelled meanwhile.
+     */
+    static bool enter(Stage stage, const std::atomic<bool>& cancelled);
+
+    /**
+     * Release a slot of a stage, and account for the work done in it.
+     */
+    static void leave(Stage stage, qint64 busyMS, quint64 bytes);
+
+    static void setCapacity(Stage stage, int capacity);
+    static int  capacity(Stage stage);
+
+    /**
+     * Account for an item entering and leaving the pipeline. The first item
+     * entering an idle pipeline starts a new batch and resets the metrics; once
+     * the pipeline stays idle for a while, the batch report is logged.
+     */
+    static void beginItem();
+    static void endItem();
+
+    static StageMetrics metrics(Stage stage);
+    static void resetMetrics();
+
+    /**
+     * Throughput of each stage (items/s and MB/s of busy time, waiting time).
+     */
+    static QString report();
+
+private:
+
+    // Disable
+    GmicBqmPipeline()  = delete;
+    ~GmicBqmPipeline() = delete;
+};
+
+} // namespace DigikamBqmGmicQtPlugin
@@ -14,6 +14,17 @@
 
 #include "gmicbqmprocessor.h"
 
+// C++ includes
+
+#include <list>
+#include <map>
+
+// Qt includes
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTimer>
+
 // digiKam includes
 
 #include "digikam_debug.h"
@@ -34,6 +45,126 @@ using namespace GmicQt;
 namespace DigikamBqmGmicQtPlugin
 {
 
+namespace
+{
+
+/**
+ * Images produced by the intermediate stages of the chains run with an input
+ * identity, least recently used first. The total size is bounded by the capacity.
+ */
+class StageCache
+{
+public:
+
+    bool get(const QString& key, gmic_library::gmic_list<float>& images)
+    {
+        QMutexLocker lock(&mutex);
+        auto it = entries.find(key);
+
+        if (it == entries.end())
+        {
+            return false;
+        }
+
+        images.assign(it->second.images);
+        touch(key);
+
+        return true;
+    }
+
+    void put(const QString& key, const gmic_library::gmic_list<float>& images)
+    {
+        quint64 bytes = 0;
+
+        for (unsigned int i = 0 ; i < images.size() ; ++i)
+        {
+            bytes += images[i].size() * sizeof(float);
+        }
+
+        QMutexLocker lock(&mutex);
+
+        if (!bytes || (bytes > capacity / 2))
+        {
+            return;
+        }
+
+        remove(key);
+
+        while (!order.empty() && ((totalBytes + bytes) > capacity))
+        {
+            remove(order.front());
+        }
+
+        Entry& entry = entries[key];
+        entry.images.assign(images);
+        entry.bytes  = bytes;
+        totalBytes  += bytes;
+        order.push_back(key);
+    }
+
+    void clear()
+    {
+        QMutexLocker lock(&mutex);
+        entries.clear();
+        order.clear();
+        totalBytes = 0;
+    }
+
+    void setCapacity(quint64 bytes)
+    {
+        QMutexLocker lock(&mutex);
+        capacity = bytes;
+
+        while (!order.empty() && (totalBytes > capacity))
+        {
+            remove(order.front());
+        }
+    }
+
+private:
+
+    struct Entry
+    {
+        gmic_library::gmic_list<float> images;
+        quint64                        bytes = 0;
+    };
+
+    void touch(const QString& key)
+    {
+        order.remove(key);
+        order.push_back(key);
+    }
+
+    void remove(const QString& key)
+    {
+        auto it = entries.find(key);
+
+        if (it != entries.end())
+        {
+            totalBytes -= it->second.bytes;
+            entries.erase(it);
+            order.remove(key);
+        }
+    }
+
+private:
+
+    QMutex                       mutex;
+    std::map<QString, Entry>     entries;
+    std::list<QString>           order;
+    quint64                      totalBytes = 0;
+    quint64                      capacity   = 512 * 1024 * 1024;
+};
+
+StageCache& stageCache()
+{
+    static StageCache cache;
+
+    return cache;
+}
+
+} // namespace
+
 class Q_DECL_HIDDEN GmicBqmProcessor::Private
 {
 public:
@@ -53,6 +184,24 @@ public:
 
     DImg                            inImage;
     DImg                            outImage;
+    bool                            sixteenBit   = false;
+
+    QStringList                     stages;
+    int                             stage        = 0;
+    QString                         identity;
+    int                             reusedStages = 0;
+
+    GmicQt::RunResources            resources;
+
+public:
+
+    /**
+     * Stage cache key of the image produced by the first 'count' stages.
+     */
+    QString stageKey(int count) const
+    {
+        return (identity + QLatin1Char('\n') + stages.mid(0, count).join(QLatin1Char('\n')));
+    }
 };
 
 GmicBqmProcessor::GmicBqmProcessor(QObject* const parent)
@@ -84,36 +233,113 @@ bool GmicBqmProcessor::setProcessingCommand(const QString& command)
     else
     {
         d->command    = command;
+        d->stages     = QStringList() << command;
         d->filterName = QString::fromLatin1("Custom command (%1)").arg(elided(d->command, 35));
     }
 
     return true;
 }
 
+bool GmicBqmProcessor::setProcessingCommands(const QStringList& commands)
+{
+    if (!setProcessingCommand(commands.join(QLatin1Char(' ')).trimmed()))
+    {
+        return false;
+    }
+
+    d->stages = commands;
+
+    return true;
+}
+
+void GmicBqmProcessor::setInputIdentity(const QString& identity)
+{
+    d->identity = identity;
+}
+
+int GmicBqmProcessor::reusedStages() const
+{
+    return d->reusedStages;
+}
+
+void GmicBqmProcessor::clearStageCache()
+{
+    stageCache().clear();
+}
+
+void GmicBqmProcessor::setStageCacheCapacity(quint64 bytes)
+{
+    stageCache().setCapacity(bytes);
+}
+
 void GmicBqmProcessor::startProcessing()
 {
-    gmic_list<char> imageNames;
+    d->completed    = false;
+    d->resources    = GmicQt::RunResources();
+    d->stage        = 0;
+    d->reusedStages = 0;
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Processing image size"
+                                     << d->inImage.size();
+
+    d->sixteenBit   = d->inImage.sixteenBit();
+
+    // Resume after the longest prefix of the chain found in the stage cache (the
+    // output of the last stage is never cached).
+
+    if (!d->identity.isEmpty())
+    {
+        for (int count = d->stages.size() - 1 ; count > 0 ; --count)
+        {
+            if (stageCache().get(d->stageKey(count), *d->gmicImages))
+            {
+                d->stage        = count;
+                d->reusedStages = count;
+
+                qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC: reusing" << count
+                                                 << "cached stage(s) of" << d->stages.size();
+
+                break;
+            }
+        }
+    }
+
+    if (d->stage == 0)
+    {
+        d->gmicImages->assign(1);
 
-    d->gmicImages->assign(1);
+        // Convert straight from the input image data, without an intermediate DImg copy.
+
+        GMicQtImageConverter::convertDImgtoCImg(d->inImage, (*d->gmicImages)[0]);
+    }
+
+    // The input pixels now live in the G'MIC image list: release our reference.
+
+    d->inImage = DImg();
+
+    d->timer.setInterval(250);
+
+    connect(&d->timer, &QTimer::timeout,
+            this, &GmicBqmProcessor::slotSendProgressInformation,
+            Qt::UniqueConnection);
+
+    d->timer.start();
+
+    startStage();
+}
+
+void GmicBqmProcessor::startStage()
+{
+    gmic_list<char> imageNames;
     imageNames.assign(1);
 
     QString name  = QString::fromUtf8("pos(0,0),name(%1)").arg(QLatin1String("Batch Queue Manager"));
     QByteArray ba = name.toUtf8();
     gmic_image<char>::string(ba.constData()).move_to(imageNames[0]);
 
-    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Processing image size"
-                                     << d->inImage.size();
-
-    GMicQtImageConverter::convertDImgtoCImg(
-                                            d->inImage.copy(
-                                                            0, 0,
-                                                            d->inImage.width(),
-                                                            d->inImage.height()
-                                                           ),
-                                            *d->gmicImages[0]
-                                           );
+    const QString& command = d->stages[d->stage];
 
-    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << QString::fromUtf8("G'MIC: %1").arg(d->command);
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << QString::fromUtf8("G'MIC: %1").arg(command);
 
     QString env = QString::fromLatin1("_input_layers=%1").arg((int)DefaultInputMode);
     env        += QString::fromLatin1(" _output_mode=%1").arg((int)DefaultOutputMode);
@@ -121,23 +347,16 @@ void GmicBqmProcessor::startProcessing()
 
     d->filterThread = new FilterThread(this,
                                        QLatin1String("skip 0"),
-                                       d->command,
+                                       command,
                                        env);
 
-    d->filterThread->swapImages(*d->gmicImages);
+    d->filterThread->giveImages(*d->gmicImages);
     d->filterThread->setImageNames(imageNames);
-
-    d->completed = false;
+    d->filterThread->setBudgetPriority(ThreadBudget::Priority::Batch);
 
     connect(d->filterThread, &FilterThread::finished,
             this, &GmicBqmProcessor::slotProcessingFinished);
 
-    d->timer.setInterval(250);
-
-    connect(&d->timer, &QTimer::timeout,
-            this, &GmicBqmProcessor::slotSendProgressInformation);
-
-    d->timer.start();
     d->filterThread->start();
 }
 
@@ -151,51 +370,110 @@ void GmicBqmProcessor::slotSendProgressInformation()
 
 void GmicBqmProcessor::slotProcessingFinished()
 {
-    d->timer.stop();
     QString errorMessage;
-    QStringList status = d->filterThread->gmicStatus();
-
-    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter status" << status;
 
-    if (d->filterThread->failed())
+    if (d->filterThread)
     {
-        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution failed!";
+        QStringList status                     = d->filterThread->gmicStatus();
+        const GmicQt::RunResources& resources  = d->filterThread->resources();
+
+        // Resources of the whole chain.
+
+        d->resources.wallTimeMS               += resources.wallTimeMS;
+        d->resources.cpuTimeMS                += resources.cpuTimeMS;
+        d->resources.inputBytes                = d->resources.inputBytes ? d->resources.inputBytes : resources.inputBytes;
+        d->resources.outputBytes               = resources.outputBytes;
+        d->resources.peakMemoryDelta           = qMax(d->resources.peakMemoryDelta, resources.peakMemoryDelta);
+        d->resources.threadCount               = resources.threadCount;
+        d->resources.failed                    = resources.failed;
+        d->resources.aborted                   = resources.aborted;
+
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter resources:"
+                                         << "wall" << resources.wallTimeMS << "ms,"
+                                         << "cpu" << resources.cpuTimeMS << "ms,"
+                                         << "in" << resources.inputBytes << "bytes,"
+                                         << "out" << resources.outputBytes << "bytes,"
+                                         << "peak memory +" << resources.peakMemoryDelta << "bytes,"
+                                         << resources.threadCount << "thread(s)";
+
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter status" << status;
+
+        const bool failed  = d->filterThread->failed();
+        const bool aborted = d->filterThread->aborted();
+
+        if (failed)
+        {
+            qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution failed!";
+
+            errorMessage = d->filterThread->errorMessage();
 
-        errorMessage = d->filterThread->errorMessage();
+            if (errorMessage.isEmpty())
+            {
+                errorMessage = QLatin1String("G'MIC Filter execution failed without error message.");
+            }
 
-        if (errorMessage.isEmpty())
+            qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << errorMessage;
+        }
+        else
         {
-            errorMessage = QLatin1String("G'MIC Filter execution failed without error message.");
+            d->filterThread->takeImages(*d->gmicImages);
         }
 
-        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << errorMessage;
-        d->completed = false;
-    }
-    else
-    {
-        gmic_list<gmic_pixel_type> images = d->filterThread->images();
+        d->filterThread->deleteLater();
+        d->filterThread = nullptr;
+
+        if (aborted)
+        {
+            qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution aborted...";
+        }
 
-        if (!d->filterThread->aborted())
+        if (failed || aborted)
         {
-            GMicQtImageConverter::convertCImgtoDImg(
-                                                    images[0],
-                                                    d->outImage,
-                                                    d->inImage.sixteenBit()
-                                                   );
+            d->timer.stop();
+            d->gmicImages->assign();
+            d->completed = false;
 
-            qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution completed!";
+            Q_EMIT signalDone(errorMessage);
 
-            d->completed = true;
+            return;
         }
-        else
+
+        ++d->stage;
+
+        if (d->stage < d->stages.size())
         {
-            qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution aborted...";
+            if (!d->identity.isEmpty())
+            {
+                stageCache().put(d->stageKey(d->stage), *d->gmicImages);
+            }
+
+            startStage();
+
+            return;
         }
+    }
+
+    d->timer.stop();
+
+    if (d->gmicImages->size())
+    {
+        GMicQtImageConverter::convertCImgtoDImg(
+                                                (*d->gmicImages)[0],
+                                                d->outImage,
+                                                d->sixteenBit
+                                               );
 
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution completed!";
+
+        d->completed = true;
+    }
+    else
+    {
+        errorMessage = QLatin1String("G'MIC Filter returned no image.");
+        d->completed = false;
     }
 
-    d->filterThread->deleteLater();
-    d->filterThread = nullptr;
+    d->gmicImages->assign();
 
     Q_EMIT signalDone(errorMessage);
 }
@@ -213,6 +491,14 @@ DImg GmicBqmProcessor::outputImage() const
     return d->outImage;
 }
 
+DImg GmicBqmProcessor::takeOutputImage()
+{
+    DImg out    = d->outImage;
+    d->outImage = DImg();
+
+    return out;
+}
+
 QString GmicBqmProcessor::processingCommand() const
 {
     return d->command;
@@ -228,6 +514,11 @@ bool GmicBqmProcessor::processingComplete() const
     return d->completed;
 }
 
+GmicQt::RunResources GmicBqmProcessor::resources() const
+{
+    return d->resources;
+}
+
 } // namespace DigikamBqmGmicQtPlugin
 
 #include "moc_gmicbqmprocessor.cpp"
@@ -18,11 +18,16 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 
 // digiKam includes
 
 #include "dimg.h"
 
+// Local includes
+
+#include "GmicQt.h"
+
 using namespace Digikam;
 
 namespace DigikamBqmGmicQtPlugin
@@ -42,11 +47,56 @@ public:
     bool processingComplete()       const;
     DImg outputImage()              const;
 
+    /**
+     * Release the output image: the processor keeps no reference to its data
+     * afterwards, so that the caller can take ownership of the pixels
+     * (see DImg::stripImageData()).
+     */
+    DImg takeOutputImage();
+
+    /**
+     * Resources used by the last processing (wall and CPU time, image bytes,
+     * peak memory growth, thread count).
+     */
+    GmicQt::RunResources resources() const;
+
+    /**
+     * Set the image to process. DImg data are shared, not copied. The reference
+     * is released as soon as the pixels have been converted for G'MIC.
+     */
     void setInputImage(const DImg& inImage);
     bool setProcessingCommand(const QString& command);
+
+    /**
+     * Run a chain of commands stage by stage. If an input identity is set (see
+     * setInputIdentity()), the image produced by each stage but the last one is
+     * kept in a cache shared by all processors, keyed by the identity and the
+     * commands of the stages run so far. A later run with the same input only
+     * computes the stages after the longest cached prefix of its chain.
+     *
+     * Meant for interactive chain previews and tests, where the same input is
+     * processed again after an edit of the chain. The caller clears the cache
+     * (see clearStageCache()) when it is done.
+     */
+    bool setProcessingCommands(const QStringList& commands);
+
+    /**
+     * Identity of the input image for the stage cache (e.g. file path and
+     * modification time). Empty (the default) disables the cache.
+     */
+    void setInputIdentity(const QString& identity);
+
+    /**
+     * Number of stages of the last processing taken from the stage cache.
+     */
+    int reusedStages()              const;
+
     void startProcessing();
     void cancel();
 
+    static void clearStageCache();
+    static void setStageCacheCapacity(quint64 bytes);
+
 Q_SIGNALS:
 
     void signalDone(const QString& errorMessage);
@@ -59,6 +109,8 @@ private Q_SLOTS:
 
 private:
 
+    void startStage();
+
     class Private;
     Private* const d = nullptr;
 };
@@ -14,10 +14,15 @@
 
 #include "gmicbqmtool.h"
 
+// C++ includes
+
+#include <atomic>
+
 // Qt includes
 
 #include <QWidget>
 #include <QEventLoop>
+#include <QElapsedTimer>
 
 // digikam includes
 
@@ -29,6 +34,7 @@
 
 #include "gmicfilterwidget.h"
 #include "gmicbqmprocessor.h"
+#include "gmicbqmpipeline.h"
 #include "gmicqtcommon.h"
 #include "GmicQt.h"
 
@@ -37,6 +43,87 @@ using namespace DigikamGmicQtPluginCommon;
 namespace DigikamBqmGmicQtPlugin
 {
 
+namespace
+{
+
+/**
+ * Stage of the pipeline held by the item processed by a tool. Moving to the
+ * next stage waits for a slot in it before releasing the current one.
+ */
+class PipelineSlot
+{
+public:
+
+    explicit PipelineSlot(bool enabled)
+        : m_enabled(enabled)
+    {
+        if (m_enabled)
+        {
+            GmicBqmPipeline::beginItem();
+        }
+    }
+
+    ~PipelineSlot()
+    {
+        release();
+
+        if (m_enabled)
+        {
+            GmicBqmPipeline::endItem();
+        }
+    }
+
+    bool moveTo(GmicBqmPipeline::Stage stage, const std::atomic<bool>& cancelled)
+    {
+        if (!m_enabled)
+        {
+            return true;
+        }
+
+        const qint64 busyMS = m_held ? m_timer.elapsed() : 0;
+
+        if (!GmicBqmPipeline::enter(stage, cancelled))
+        {
+            return false;
+        }
+
+        if (m_held)
+        {
+            GmicBqmPipeline::leave(m_stage, busyMS, m_bytes);
+        }
+
+        m_stage = stage;
+        m_held  = true;
+        m_timer.start();
+
+        return true;
+    }
+
+    void setBytes(quint64 bytes)
+    {
+        m_bytes = bytes;
+    }
+
+    void release()
+    {
+        if (m_held)
+        {
+            GmicBqmPipeline::leave(m_stage, m_timer.elapsed(), m_bytes);
+            m_held = false;
+        }
+    }
+
+private:
+
+    bool                   m_enabled = false;
+    bool                   m_held    = false;
+    GmicBqmPipeline::Stage m_stage   = GmicBqmPipeline::Load;
+    quint64                m_bytes   = 0;
+    QElapsedTimer          m_timer;
+};
+
+} // namespace
+
 class Q_DECL_HIDDEN GmicBqmTool::Private
 {
 public:
@@ -49,6 +136,7 @@ public:
     GmicBqmProcessor* gmicProcessor  = nullptr;
 
     bool              changeSettings = true;
+    std::atomic<bool> cancelled      { false };
 };
 
 GmicBqmTool::GmicBqmTool(QObject* const parent)
@@ -59,6 +147,13 @@ GmicBqmTool::GmicBqmTool(QObject* const parent)
 
 GmicBqmTool::~GmicBqmTool()
 {
+    if (d->gmicWidget)
+    {
+        // The registered tool goes away with the plugin: drop the chain stages kept around.
+
+        GmicBqmProcessor::clearStageCache();
+    }
+
     delete d;
 }
 
@@ -83,8 +178,9 @@ BatchToolSettings GmicBqmTool::defaultSettings()
 {
     BatchToolSettings settings;
 
-    settings.insert(QLatin1String("GmicBqmToolCommand"), QString());
-    settings.insert(QLatin1String("GmicBqmToolPath"),    QString());
+    settings.insert(QLatin1String("GmicBqmToolCommand"),   QString());
+    settings.insert(QLatin1String("GmicBqmToolPath"),      QString());
+    settings.insert(QLatin1String("GmicBqmToolPipelined"), true);
 
     return settings;
 }
@@ -96,6 +192,7 @@ void GmicBqmTool::slotAssignSettings2Widget()
     QString path      = settings().value(QLatin1String("GmicBqmToolPath")).toString();
 
     d->gmicWidget->setCurrentPath(path);
+    d->gmicWidget->setPipelined(settings().value(QLatin1String("GmicBqmToolPipelined"), true).toBool());
 
     d->changeSettings = true;
 }
@@ -106,8 +203,9 @@ void GmicBqmTool::slotSettingsChanged()
     {
         BatchToolSettings settings;
 
-        settings.insert(QLatin1String("GmicBqmToolCommand"), d->gmicWidget->currentGmicChainedCommands());
-        settings.insert(QLatin1String("GmicBqmToolPath"),    d->gmicWidget->currentPath());
+        settings.insert(QLatin1String("GmicBqmToolCommand"),   d->gmicWidget->currentGmicChainedCommands());
+        settings.insert(QLatin1String("GmicBqmToolPath"),      d->gmicWidget->currentPath());
+        settings.insert(QLatin1String("GmicBqmToolPipelined"), d->gmicWidget->pipelined());
 
         BatchTool::slotSettingsChanged(settings);
     }
@@ -115,6 +213,19 @@ void GmicBqmTool::slotSettingsChanged()
 
 bool GmicBqmTool::toolOperations()
 {
+    // In pipelined mode, the items processed by the concurrent BQM workers go
+    // through bounded load and filter stages (see GmicBqmPipeline).
+    // The tool is cloned for each item: a cancel() received before this point
+    // is kept and stops the item at the first stage.
+
+    const bool pipelined = settings().value(QLatin1String("GmicBqmToolPipelined"), true).toBool();
+    PipelineSlot slot(pipelined);
+
+    if (!slot.moveTo(GmicBqmPipeline::Load, d->cancelled))
+    {
+        return false;
+    }
+
     if (!loadToDImg())
     {
         qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: cannot load image!";
@@ -122,6 +233,8 @@ bool GmicBqmTool::toolOperations()
         return false;
     }
 
+    slot.setBytes(image().numBytes());
+
     QString path     = settings().value(QLatin1String("GmicBqmToolPath")).toString();
     qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: running G'MIC filter" << path;
 
@@ -134,6 +247,9 @@ bool GmicBqmTool::toolOperations()
         return false;
     }
 
+    // A queue item is processed once, and its input also depends on the previous
+    // tools of the queue: the chain runs as a single command, without the stage cache.
+
     d->gmicProcessor = new GmicBqmProcessor();
     d->gmicProcessor->setInputImage(image());
 
@@ -146,6 +262,14 @@ bool GmicBqmTool::toolOperations()
         return false;
     }
 
+    if (!slot.moveTo(GmicBqmPipeline::Filter, d->cancelled))
+    {
+        delete d->gmicProcessor;
+        d->gmicProcessor = nullptr;
+
+        return false;
+    }
+
     d->gmicProcessor->startProcessing();
 
     QEventLoop loop;
@@ -157,9 +281,25 @@ bool GmicBqmTool::toolOperations()
 
     loop.exec();
 
-    bool b   = d->gmicProcessor->processingComplete();
-    DImg out = d->gmicProcessor->outputImage();
-    image().putImageData(out.width(), out.height(), out.sixteenBit(), out.hasAlpha(), out.bits());
+    bool b = d->gmicProcessor->processingComplete();
+
+    // Leave the pipeline: the output is encoded out of its control.
+
+    slot.release();
+
+    if (b)
+    {
+        // Hand over the output pixels to the tool image without copying them.
+
+        DImg out              = d->gmicProcessor->takeOutputImage();
+        const uint width      = out.width();
+        const uint height     = out.height();
+        const bool sixteenBit = out.sixteenBit();
+        const bool hasAlpha   = out.hasAlpha();
+        uchar* const data     = out.stripImageData();
+
+        image().putImageData(width, height, sixteenBit, hasAlpha, data, false);
+    }
 
     FilterAction action = s_gmicQtFilterAction(
                                                command,
@@ -188,6 +328,8 @@ bool GmicBqmTool::toolOperations()
 
 void GmicBqmTool::cancel()
 {
+    d->cancelled = true;
+
     if (d->gmicProcessor)
     {
         d->gmicProcessor->cancel();
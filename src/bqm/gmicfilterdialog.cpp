@@ -53,6 +53,8 @@ namespace DigikamBqmGmicQtPlugin
 
 extern BqmInfoIface* s_infoIface;
 
+void clearHostPreviewCache();
+
 class Q_DECL_HIDDEN GmicFilterDialog::Private
 {
 public:
@@ -218,6 +220,10 @@ void GmicFilterDialog::slotGmicQt(const QString& command)
                                              command                          // The G'MIC command in Edit mode, else empty in ADD mode.
                                             );
 
+    // The queue selection can change before the next G'MIC-Qt session.
+
+    clearHostPreviewCache();
+
     if (!clipboard->text().isEmpty() && !fname.isEmpty())
     {
         if (command.isEmpty())
@@ -25,6 +25,7 @@
 #include <QAction>
 #include <QObject>
 #include <QApplication>
+#include <QCheckBox>
 #include <QGridLayout>
 
 // digiKam includes
@@ -72,6 +73,7 @@ public:
     QAction*              edit             = nullptr;
     QAction*              importdb         = nullptr;
     QAction*              exportdb         = nullptr;
+    QCheckBox*            pipelined        = nullptr;
     DPluginBqm*           plugin           = nullptr;
 };
 
@@ -146,6 +148,11 @@ GmicFilterWidget::GmicFilterWidget(QWidget* const parent)
     d->search           = new SearchTextBar(this, QLatin1String("DigikamGmicFilterSearchBar"));
     d->search->setObjectName(QLatin1String("search"));
 
+    d->pipelined        = new QCheckBox(tr("Overlap loading, filtering and saving of items"), this);
+    d->pipelined->setToolTip(tr("Load the next items and save the previous ones while an item is filtered. "
+                                "Only one item is filtered at a time."));
+    d->pipelined->setChecked(true);
+
     QGridLayout* const grid = new QGridLayout(this);
     grid->addWidget(d->tree,      0, 0, 1, 6);
     grid->addWidget(d->addButton, 1, 0, 1, 1);
@@ -153,6 +160,7 @@ GmicFilterWidget::GmicFilterWidget(QWidget* const parent)
     grid->addWidget(d->edtButton, 1, 2, 1, 1);
     grid->addWidget(d->dbButton,  1, 3, 1, 1);
     grid->addWidget(d->search,    1, 5, 1, 1);
+    grid->addWidget(d->pipelined, 2, 0, 1, 6);
     grid->setColumnStretch(4, 2);
     grid->setColumnStretch(5, 8);
 
@@ -164,6 +172,9 @@ GmicFilterWidget::GmicFilterWidget(QWidget* const parent)
     d->tree->setExpanded(d->proxyModel->index(0, 0), true);
     d->tree->header()->setSectionResizeMode(QHeaderView::Stretch);
 
+    connect(d->pipelined, SIGNAL(toggled(bool)),
+            this, SIGNAL(signalSettingsChanged()));
+
     connect(d->search, SIGNAL(textChanged(QString)),
             d->proxyModel, SLOT(setFilterFixedString(QString)));
 
@@ -485,6 +496,16 @@ void GmicFilterWidget::saveSettings()
     }
 }
 
+bool GmicFilterWidget::pipelined() const
+{
+    return d->pipelined->isChecked();
+}
+
+void GmicFilterWidget::setPipelined(bool pipelined)
+{
+    d->pipelined->setChecked(pipelined);
+}
+
 QMap<QString, QVariant> GmicFilterWidget::currentGmicFilters() const
 {
     QModelIndex index = d->tree->currentIndex();
@@ -505,7 +526,12 @@ QMap<QString, QVariant> GmicFilterWidget::currentGmicFilters() const
 
 QString GmicFilterWidget::currentGmicChainedCommands() const
 {
-    QString chained;
+    return currentGmicCommands().join(QLatin1Char(' '));
+}
+
+QStringList GmicFilterWidget::currentGmicCommands() const
+{
+    QStringList commands;
     QMap<QString, QVariant> filters = currentGmicFilters();
 
     if (!filters.isEmpty())
@@ -514,12 +540,16 @@ QString GmicFilterWidget::currentGmicChainedCommands() const
 
         for (const QVariant& v : qAsConst(lst))
         {
-            chained.append(QLatin1Char(' '));
-            chained.append(v.toString());
+            const QString command = v.toString().trimmed();
+
+            if (!command.isEmpty())
+            {
+                commands.append(command);
+            }
         }
     }
 
-    return chained.trimmed();
+    return commands;
 }
 
 QString GmicFilterWidget::currentPath() const
@@ -53,6 +53,14 @@ public:
 
     QString currentGmicChainedCommands()            const;
 
+    /**
+     * The commands of the current chain, one per stage (see GmicBqmProcessor::setProcessingCommands()).
+     */
+    QStringList currentGmicCommands()               const;
+
+    bool pipelined()                                const;
+    void setPipelined(bool pipelined);
+
 Q_SIGNALS:
 
     void signalSettingsChanged();
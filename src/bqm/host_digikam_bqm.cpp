@@ -15,6 +15,10 @@
 // Qt includes
 
 #include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QTextStream>
 #include <QStringList>
 
@@ -35,11 +39,95 @@ namespace DigikamBqmGmicQtPlugin
 
 extern BqmInfoIface* s_infoIface;
 
+namespace
+{
+
+/**
+ * Size of the preview image loaded for the filter selection dialog.
+ */
+const int s_previewSize = 1024;
+
+/**
+ * Last decoded preview image, shared by getImageSize() and getCroppedImages().
+ * A request for another file (the queue selection changed), another size, or a
+ * file modified since the decoding reloads it.
+ */
+struct PreviewCache
+{
+    QMutex    mutex;
+    QString   path;
+    int       size     = 0;
+    QDateTime modified;
+    DImg      image;
+};
+
+PreviewCache& previewCache()
+{
+    static PreviewCache cache;
+
+    return cache;
+}
+
+} // namespace
+
+void clearHostPreviewCache()
+{
+    PreviewCache& cache = previewCache();
+    QMutexLocker lock(&cache.mutex);
+
+    cache.path.clear();
+    cache.size     = 0;
+    cache.modified = QDateTime();
+    cache.image    = DImg();
+}
+
 } // namespace DigikamBqmGmicQtPlugin
 
 using namespace DigikamBqmGmicQtPlugin;
 using namespace DigikamGmicQtPluginCommon;
 
+namespace
+{
+
+/**
+ * File path of the queue item used as preview: the first selected item, else
+ * the first item of the current queue (empty if the queue is empty).
+ */
+QString previewItemPath()
+{
+    QueuePoolItemsList list = s_infoIface->selectedItemInfoListFromCurrentQueue();
+
+    if (list.isEmpty())
+    {
+        list = s_infoIface->allItemInfoListFromCurrentQueue();
+    }
+
+    return (list.isEmpty() ? QString() : list.first().info.filePath());
+}
+
+DImg previewImage(const QString& path, int size)
+{
+    PreviewCache& cache      = previewCache();
+    const QDateTime modified = QFileInfo(path).lastModified();
+    QMutexLocker lock(&cache.mutex);
+
+    if ((path == cache.path) && (size == cache.size) && (modified == cache.modified) && !cache.image.isNull())
+    {
+        return cache.image;
+    }
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Loading preview image" << path << "at size" << size;
+
+    cache.image    = PreviewLoadThread::loadFastSynchronously(path, size);
+    cache.path     = path;
+    cache.size     = size;
+    cache.modified = modified;
+
+    return cache.image;
+}
+
+} // namespace
+
 /**
  * GMic-Qt plugin functions
  * See documentation from GmicQtHost.h for details.
@@ -57,12 +145,11 @@ void getImageSize(int* width,
 {
     qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Calling GmicQt getImageSize()";
 
-    QueuePoolItemsList list = s_infoIface->selectedItemInfoListFromCurrentQueue();
+    const QString path = previewItemPath();
 
-    if (!list.isEmpty())
+    if (!path.isEmpty())
     {
-        DImg img = PreviewLoadThread::loadFastSynchronously(list.first().info.filePath(),
-                                                            1024);
+        DImg img = previewImage(path, s_previewSize);
         *width   = img.width();
         *height  = img.height();
     }
@@ -96,14 +183,9 @@ void getCroppedImages(cimg_library::CImgList<gmic_pixel_type>& images,
 {
     qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Calling GmicQt getCroppedImages()";
 
-    QueuePoolItemsList list = s_infoIface->selectedItemInfoListFromCurrentQueue();
-
-    if (list.isEmpty())
-    {
-        list = s_infoIface->allItemInfoListFromCurrentQueue();
-    }
+    const QString path = previewItemPath();
 
-    if (mode == GmicQt::InputMode::NoInput || list.isEmpty())
+    if (mode == GmicQt::InputMode::NoInput || path.isEmpty())
     {
         images.assign();
         imageNames.assign();
@@ -111,8 +193,7 @@ void getCroppedImages(cimg_library::CImgList<gmic_pixel_type>& images,
         return;
     }
 
-    DImg input_image       = PreviewLoadThread::loadFastSynchronously(list.first().info.filePath(),
-                                                                      1024);
+    DImg input_image       = previewImage(path, s_previewSize);
     const bool entireImage = (
                               (x      < 0.0) &&
                               (y      < 0.0) &&
@@ -153,7 +234,7 @@ void getCroppedImages(cimg_library::CImgList<gmic_pixel_type>& images,
                                           static_cast<int>(1 + std::ceil(height * input_image.height()))
                                          );
 
-    GMicQtImageConverter::convertDImgtoCImg(input_image.copy(ix, iy, iw, ih), images[0]);
+    GMicQtImageConverter::convertDImgtoCImg(input_image, QRect(ix, iy, iw, ih), images[0]);
 }
 
 void applyColorProfile(cimg_library::CImg<gmic_pixel_type>& images) // cppcheck-suppress constParameterReference
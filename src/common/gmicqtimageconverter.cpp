@@ -18,6 +18,10 @@
 
 #include "digikam_debug.h"
 
+// Local includes
+
+#include "Tracer.h"
+
 namespace DigikamGmicQtPluginCommon
 {
 
@@ -42,6 +46,8 @@ inline unsigned short GMicQtImageConverter::float2ushortBounded(const float& in)
 void GMicQtImageConverter::convertCImgtoDImg(const cimg_library::CImg<float>& in,
                                              DImg& out, bool sixteenBit)
 {
+    TRACE_SPAN("Convert CImg to DImg", "conversion");
+
     Q_ASSERT_X(
                (in.spectrum() <= 4),
                "GMicQtImageConverter::convertCImgtoDImg()",
@@ -226,8 +232,28 @@ void GMicQtImageConverter::convertCImgtoDImg(const cimg_library::CImg<float>& in
 void GMicQtImageConverter::convertDImgtoCImg(const DImg& in,
                                              cimg_library::CImg<float>& out)
 {
-    const int w      = in.width();
-    const int h      = in.height();
+    convertDImgtoCImg(in, QRect(0, 0, in.width(), in.height()), out);
+}
+
+void GMicQtImageConverter::convertDImgtoCImg(const DImg& in,
+                                             const QRect& region,
+                                             cimg_library::CImg<float>& out,
+                                             int step)
+{
+    TRACE_SPAN("Convert DImg to CImg", "conversion");
+
+    const QRect rect = region.intersected(QRect(0, 0, in.width(), in.height()));
+
+    if (rect.isEmpty())
+    {
+        out.assign();
+
+        return;
+    }
+
+    step             = qMax(1, step);
+    const int w      = (rect.width()  + step - 1) / step;
+    const int h      = (rect.height() + step - 1) / step;
     const bool alpha = in.hasAlpha();
     out.assign(w, h, 1, alpha ? 4 : 3);
 
@@ -243,14 +269,21 @@ void GMicQtImageConverter::convertDImgtoCImg(const DImg& in,
 
     qCDebug(DIGIKAM_DPLUGIN_LOG) << "GMicQt: convert DImg to CImg:"
                                  << (in.sixteenBit() + 1) * 8 << "bits image"
-                                 << "with alpha channel:" << alpha;
+                                 << "with alpha channel:" << alpha
+                                 << "region:" << rect << "step:" << step;
+
+    // Distance between two pixels read in a scanline, in channels.
+
+    const int stride = 4 * step;
 
     for (int y = 0 ; y < h ; ++y)
     {
+        const int sy = rect.y() + y * step;
+
         if (in.sixteenBit())
         {
-            const unsigned short* src = reinterpret_cast<unsigned short*>(in.scanLine(y));
-            int n                     = in.width();
+            const unsigned short* src = reinterpret_cast<const unsigned short*>(in.scanLine(sy)) + 4 * rect.x();
+            int n                     = w;
 
             while (n--)
             {
@@ -263,13 +296,13 @@ void GMicQtImageConverter::convertDImgtoCImg(const DImg& in,
                     *dstA++ = static_cast<float>(src[3] / 255.0);
                 }
 
-                src    += 4;
+                src    += stride;
             }
         }
         else
         {
-            const unsigned char* src = in.scanLine(y);
-            int n                    = in.width();
+            const unsigned char* src = in.scanLine(sy) + 4 * rect.x();
+            int n                    = w;
 
             while (n--)
             {
@@ -282,7 +315,7 @@ void GMicQtImageConverter::convertDImgtoCImg(const DImg& in,
                     *dstA++ = static_cast<float>(src[3]);
                 }
 
-                src    += 4;
+                src    += stride;
             }
         }
     }
@@ -14,6 +14,10 @@
 
 #pragma once
 
+// Qt includes
+
+#include <QRect>
+
 // digiKam includes
 
 #include "dimg.h"
@@ -41,6 +45,17 @@ public:
     static void convertDImgtoCImg(const DImg& in,
                                   cimg_library::CImg<float>& out);
 
+    /**
+     * Convert the region of 'in' to 'out', reading the source scanlines directly
+     * (no intermediate DImg copy). The region is clipped to the image bounds.
+     * With a step greater than 1, only one pixel out of 'step' is read in each
+     * direction (nearest decimation).
+     */
+    static void convertDImgtoCImg(const DImg& in,
+                                  const QRect& region,
+                                  cimg_library::CImg<float>& out,
+                                  int step = 1);
+
 private:
 
     static unsigned char  float2ucharBounded(const float& in);
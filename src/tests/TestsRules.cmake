@@ -61,3 +61,120 @@ target_link_libraries(GmicQt_Processor_test
 
                       ${gmic_qt_LIBRARIES}
 )
+
+###
+
+set(BqmAllocations_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmprocessor.cpp
+
+    ${CMAKE_SOURCE_DIR}/src/tests/host_test.cpp
+    ${CMAKE_SOURCE_DIR}/src/tests/main_bqmallocations.cpp
+)
+
+foreach(_file ${BqmAllocations_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_BqmAllocations_test
+               ${gmic_qt_QRC}
+               ${gmic_qt_QM}
+               ${BqmAllocations_test_SRCS}
+)
+
+target_link_libraries(GmicQt_BqmAllocations_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+###
+
+set(FilterRegression_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/tests/host_test.cpp
+    ${CMAKE_SOURCE_DIR}/src/tests/main_filterregression.cpp
+)
+
+foreach(_file ${FilterRegression_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_FilterRegression_test
+               ${gmic_qt_QRC}
+               ${gmic_qt_QM}
+               ${FilterRegression_test_SRCS}
+)
+
+target_link_libraries(GmicQt_FilterRegression_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+# Output hashes are checked against the baseline of the source tree.
+
+target_compile_definitions(GmicQt_FilterRegression_test
+                           PRIVATE
+                           FILTERREGRESSION_BASELINE="${CMAKE_SOURCE_DIR}/src/tests/filterregression_baseline.json"
+)
+
+###
+
+set(InterpreterBench_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/tests/host_test.cpp
+    ${CMAKE_SOURCE_DIR}/src/tests/main_interpreterbench.cpp
+)
+
+foreach(_file ${InterpreterBench_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_InterpreterBench_test
+               ${gmic_qt_QRC}
+               ${gmic_qt_QM}
+               ${InterpreterBench_test_SRCS}
+)
+
+target_link_libraries(GmicQt_InterpreterBench_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+###
+
+set(Updater_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/tests/host_test.cpp
+    ${CMAKE_SOURCE_DIR}/src/tests/main_updater.cpp
+)
+
+foreach(_file ${Updater_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_Updater_test
+               ${gmic_qt_QRC}
+               ${gmic_qt_QM}
+               ${Updater_test_SRCS}
+)
+
+target_link_libraries(GmicQt_Updater_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
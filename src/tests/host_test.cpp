@@ -142,7 +142,7 @@ void getCroppedImages(cimg_library::CImgList<gmic_pixel_type>& images,
                                           static_cast<int>(1 + std::ceil(height * input_image->height()))
                                          );
 
-    GMicQtImageConverter::convertDImgtoCImg(input_image->copy(ix, iy, iw, ih), images[0]);
+    GMicQtImageConverter::convertDImgtoCImg(*input_image, QRect(ix, iy, iw, ih), images[0]);
 
     delete input_image;
 }
@@ -0,0 +1,202 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2019-11-28
+ * Description : digiKam GmicQt tests.
+ *                Count the full-frame allocations done while processing
+ *                one Batch Queue Manager item.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Qt includes
+
+#include <QEventLoop>
+#include <QApplication>
+#include <QCommandLineParser>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+#include "dimg.h"
+
+// local includes
+
+#include "gmicbqmprocessor.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+QString s_imagePath;
+
+} // namespace DigikamBqmGmicQtPlugin
+
+using namespace Digikam;
+using namespace DigikamBqmGmicQtPlugin;
+
+namespace
+{
+
+/**
+ * Expected full-frame allocations per item: the float image handed to G'MIC,
+ * and the output DImg. Any extra copy of the frame makes the test fail.
+ */
+const int s_expectedFrameAllocations = 2;
+
+std::atomic<bool>   s_counting(false);
+std::atomic<size_t> s_frameBytes(0);
+std::atomic<int>    s_frameAllocations(0);
+
+void* countedAllocation(std::size_t size)
+{
+    if (s_counting && s_frameBytes && (size >= s_frameBytes))
+    {
+        ++s_frameAllocations;
+    }
+
+    return std::malloc(size ? size : 1);
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    void* const ptr = countedAllocation(size);
+
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocation(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addVersionOption();
+    parser.addHelpOption();
+    parser.addPositionalArgument(QString::fromLatin1("image"), QLatin1String("Image file path (optional)"), QString::fromLatin1("[image]"));
+    parser.process(app);
+
+    DImg img;
+
+    if (!parser.positionalArguments().isEmpty())
+    {
+        s_imagePath = parser.positionalArguments().constFirst();
+        img.load(s_imagePath);
+    }
+
+    if (img.isNull())
+    {
+        // Large enough for the G'MIC interpreter setup (command definitions) to stay below one frame.
+
+        img = DImg(4000, 3000, false, true);
+        img.fill(DColor(128, 64, 32, 255, false));
+    }
+
+    qCDebug(DIGIKAM_TESTS_LOG) << "Image to process:" << img.size() << "16 bits:" << img.sixteenBit();
+
+    GmicBqmProcessor* const gmicProcessor = new GmicBqmProcessor();
+
+    // A command which leaves the image untouched: only the pipeline is measured.
+
+    if (!gmicProcessor->setProcessingCommand(QLatin1String("skip 0")))
+    {
+        delete gmicProcessor;
+        qCWarning(DIGIKAM_TESTS_LOG) << "Cannot setup G'MIC command!";
+
+        return (-1);
+    }
+
+    // Smallest full frame: one byte per pixel.
+
+    s_frameBytes = (size_t)img.width() * (size_t)img.height();
+    s_counting   = true;
+
+    gmicProcessor->setInputImage(img);
+    img = DImg();
+    gmicProcessor->startProcessing();
+
+    QEventLoop loop;
+
+    QObject::connect(gmicProcessor, SIGNAL(signalDone(QString)),
+                     &loop, SLOT(quit()));
+
+    loop.exec();
+
+    DImg out       = gmicProcessor->takeOutputImage();
+    s_counting     = false;
+    const bool b   = gmicProcessor->processingComplete();
+
+    delete gmicProcessor;
+
+    qCDebug(DIGIKAM_TESTS_LOG) << "G'MIC processing completed:" << b
+                               << "output:" << out.size()
+                               << "full-frame allocations:" << s_frameAllocations
+                               << "(expected:" << s_expectedFrameAllocations << ")";
+
+    if (!b || out.isNull())
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "G'MIC processing failed!";
+
+        return (-1);
+    }
+
+    if (s_frameAllocations != s_expectedFrameAllocations)
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "Unexpected number of full-frame allocations:" << s_frameAllocations;
+
+        return (-1);
+    }
+
+    return 0;
+}
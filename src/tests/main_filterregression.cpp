@@ -0,0 +1,479 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2019-11-28
+ * Description : digiKam GmicQt tests.
+ *                Golden output and timing regression checks of stdlib
+ *                filters run with their default parameters. Output hashes
+ *                are checked against the committed baseline, timings
+ *                against a machine-local record.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <cmath>
+
+// Qt includes
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// local includes
+
+#include "Common.h"
+#include "FilterParameters/FilterParametersWidget.h"
+#include "FilterSelector/FiltersPresenter.h"
+#include "FilterThread.h"
+#include "GmicStdlib.h"
+#include "Misc.h"
+#include "Updater.h"
+#include "gmic.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+QString s_imagePath;
+
+} // namespace DigikamBqmGmicQtPlugin
+
+using namespace GmicQt;
+
+namespace
+{
+
+/**
+ * Filters checked when no list is given: fast ones, covering color, tone and
+ * neighborhood operations.
+ */
+const char* const s_defaultFilters[] =
+{
+    "fx_blackandwhite",
+    "fx_pencilbw",
+    "fx_posterize",
+    "fx_sepia",
+    "fx_unsharp",
+    "fx_vignette",
+    nullptr
+};
+
+const int s_imageWidth  = 512;
+const int s_imageHeight = 384;
+
+/**
+ * Deterministic RGB test image: smooth gradients, a few hard edges, and
+ * pseudo-random noise from a fixed seed.
+ */
+void buildSyntheticImage(unsigned int seed, gmic_library::gmic_image<float>& image)
+{
+    image.assign(s_imageWidth, s_imageHeight, 1, 3);
+    unsigned int state = seed;
+
+    for (int y = 0 ; y < s_imageHeight ; ++y)
+    {
+        for (int x = 0 ; x < s_imageWidth ; ++x)
+        {
+            state                = state * 1664525u + 1013904223u;
+            const float noise    = static_cast<float>((state >> 24) & 0x1F) - 16.0f;
+            const bool  square   = (((x / 64) + (y / 64)) % 2) == 0;
+            image(x, y, 0, 0)    = 255.0f * x / (s_imageWidth - 1);
+            image(x, y, 0, 1)    = 255.0f * y / (s_imageHeight - 1);
+            image(x, y, 0, 2)    = (square ? 200.0f : 40.0f) + noise;
+        }
+    }
+}
+
+/**
+ * FNV-1a hash of the output geometry and values rounded to integers, so that
+ * tiny floating point differences below the output precision do not count.
+ */
+QString imageListHash(const gmic_library::gmic_list<float>& images)
+{
+    quint64 hash   = 14695981039346656037ULL;
+    auto feed      = [&hash](qint64 value)
+    {
+        for (int i = 0 ; i < 8 ; ++i)
+        {
+            hash ^= static_cast<quint64>((value >> (8 * i)) & 0xFF);
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    feed(images.size());
+
+    for (unsigned int i = 0 ; i < images.size() ; ++i)
+    {
+        const gmic_library::gmic_image<float>& image = images[i];
+        feed(image.width());
+        feed(image.height());
+        feed(image.depth());
+        feed(image.spectrum());
+
+        for (size_t n = 0 ; n < image.size() ; ++n)
+        {
+            feed(static_cast<qint64>(std::lround(image[n])));
+        }
+    }
+
+    return QString::fromLatin1("%1").arg(hash, 16, 16, QLatin1Char('0'));
+}
+
+QStringList readFilterList(const QString& path)
+{
+    QStringList list;
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "Cannot read filter list" << path;
+
+        return list;
+    }
+
+    QTextStream stream(&file);
+
+    while (!stream.atEnd())
+    {
+        const QString line = stream.readLine().trimmed();
+
+        if (!line.isEmpty() && !line.startsWith(QLatin1Char('#')))
+        {
+            list << line;
+        }
+    }
+
+    return list;
+}
+
+QJsonObject readJsonObject(const QString& path)
+{
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QJsonObject();
+    }
+
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+bool writeJsonObject(const QString& path, const QJsonObject& object)
+{
+    QFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "Cannot write" << path;
+
+        return false;
+    }
+
+    file.write(QJsonDocument(object).toJson());
+    qCDebug(DIGIKAM_TESTS_LOG) << "Written to" << path;
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addVersionOption();
+    parser.addHelpOption();
+
+    QCommandLineOption baselineOption(QStringList() << QLatin1String("b") << QLatin1String("baseline"),
+                                      QLatin1String("Baseline JSON file of the output hashes (default: the one of the source tree)."),
+                                      QLatin1String("file"),
+                                      QLatin1String(FILTERREGRESSION_BASELINE));
+
+    QCommandLineOption timingsOption(QStringList() << QLatin1String("m") << QLatin1String("timings"),
+                                     QLatin1String("Machine-local JSON file of the reference timings, recorded by the first run "
+                                                   "(default: filterregression_timings.json)."),
+                                     QLatin1String("file"),
+                                     QLatin1String("filterregression_timings.json"));
+
+    QCommandLineOption filtersOption(QStringList() << QLatin1String("f") << QLatin1String("filters"),
+                                     QLatin1String("Text file with one filter command per line (default: built-in list)."),
+                                     QLatin1String("file"));
+
+    QCommandLineOption updateOption(QStringList() << QLatin1String("u") << QLatin1String("update"),
+                                    QLatin1String("Record the current output hashes and timings as the new references "
+                                                  "(also enabled by the GMIC_QT_RECORD_BASELINE environment variable)."));
+
+    QCommandLineOption thresholdOption(QStringList() << QLatin1String("t") << QLatin1String("threshold"),
+                                       QLatin1String("Accepted slowdown ratio over the local timing (default: 1.5)."),
+                                       QLatin1String("ratio"),
+                                       QLatin1String("1.5"));
+
+    QCommandLineOption runsOption(QStringList() << QLatin1String("r") << QLatin1String("runs"),
+                                  QLatin1String("Runs per filter, the fastest one is kept (default: 3)."),
+                                  QLatin1String("count"),
+                                  QLatin1String("3"));
+
+    QCommandLineOption seedOption(QStringList() << QLatin1String("s") << QLatin1String("seed"),
+                                  QLatin1String("Seed of the test image and of the G'MIC random generator (default: 2019)."),
+                                  QLatin1String("value"),
+                                  QLatin1String("2019"));
+
+    parser.addOption(baselineOption);
+    parser.addOption(timingsOption);
+    parser.addOption(filtersOption);
+    parser.addOption(updateOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(runsOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    const QString baselinePath = parser.value(baselineOption);
+    const QString timingsPath  = parser.value(timingsOption);
+    const double threshold     = qMax(1.0, parser.value(thresholdOption).toDouble());
+    const int runs             = qMax(1, parser.value(runsOption).toInt());
+    const unsigned int seed    = parser.value(seedOption).toUInt();
+
+    // Timings below this difference are noise, whatever the ratio.
+
+    const double minimalSlowdownMS = 20.0;
+
+    QStringList commands;
+
+    if (parser.isSet(filtersOption))
+    {
+        commands = readFilterList(parser.value(filtersOption));
+    }
+    else
+    {
+        for (int i = 0 ; s_defaultFilters[i] ; ++i)
+        {
+            commands << QLatin1String(s_defaultFilters[i]);
+        }
+    }
+
+    // Baseline: output hashes only, so that the committed file does not depend on the machine.
+
+    const QJsonObject baseline = readJsonObject(baselinePath);
+
+    // A baseline is only recorded on request: a missing or unreadable baseline is a failure,
+    // not a silent pass with freshly recorded values.
+
+    const bool recordBaseline = parser.isSet(updateOption) || !qgetenv("GMIC_QT_RECORD_BASELINE").isEmpty();
+
+    if (!recordBaseline && baseline.isEmpty())
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "No baseline found in" << baselinePath
+                                     << ": run with --update, or set GMIC_QT_RECORD_BASELINE, to record it.";
+
+        return (-1);
+    }
+
+    if (!recordBaseline && (baseline.value(QLatin1String("seed")).toInt() != static_cast<int>(seed)))
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "Baseline was recorded with another seed:"
+                                     << baseline.value(QLatin1String("seed")).toInt();
+
+        return (-1);
+    }
+
+    const QJsonObject baselineFilters = baseline.value(QLatin1String("filters")).toObject();
+
+    // Timings are only comparable on the same machine: a filter without a local timing is
+    // recorded by this run, and its slowdown is checked by the next ones.
+
+    QJsonObject timings = recordBaseline ? QJsonObject() : readJsonObject(timingsPath);
+    bool newTimings     = false;
+
+    // Filters are run as in the plugin: full stdlib, default parameters.
+
+    GmicStdLib::Array = Updater::getInstance()->buildFullStdlib();
+
+    FiltersPresenter presenter(nullptr);
+    presenter.readFilters();
+
+    gmic_library::gmic_image<float> input;
+    buildSyntheticImage(seed, input);
+
+    QJsonObject results;
+    int failures = 0;
+
+    for (const QString& command : qAsConst(commands))
+    {
+        presenter.selectFilterFromCommand(command);
+        const FiltersPresenter::Filter& filter = presenter.currentFilter();
+
+        if (filter.isInvalid() || (filter.command != command))
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << command << ": FAILED, filter not found in stdlib";
+            ++failures;
+
+            continue;
+        }
+
+        QString error;
+        QVector<bool> quoted;
+        const QStringList defaults = FilterParametersWidget::defaultParameterList(filter.parameters, &error, &quoted);
+
+        if (!error.isEmpty())
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << command << ": FAILED, cannot get default parameters:" << error;
+            ++failures;
+
+            continue;
+        }
+
+        const QString arguments = flattenGmicParameterList(defaults, quoted);
+        QString hash;
+        double bestMS           = -1.0;
+        bool ok                 = true;
+
+        for (int run = 0 ; run < runs ; ++run)
+        {
+            gmic_library::gmic_list<float> images;
+            images.assign(1);
+            images[0].assign(input);
+
+            gmic_library::gmic_list<char> imageNames;
+            imageNames.assign(1);
+            gmic_library::gmic_image<char>::string("pos(0,0),name(regression)").move_to(imageNames[0]);
+
+            // Reset the random generator so that filters using noise are deterministic.
+
+            FilterThread thread(nullptr,
+                                QString::fromLatin1("srand %1 %2").arg(seed).arg(filter.command),
+                                arguments,
+                                QString::fromLatin1("_input_layers=%1 _output_mode=%2").arg((int)DefaultInputMode).arg((int)DefaultOutputMode));
+
+            thread.giveImages(images);
+            thread.setImageNames(imageNames);
+
+            QElapsedTimer timer;
+            timer.start();
+            thread.start();
+            thread.wait();
+            const double elapsedMS = timer.nsecsElapsed() / 1.0e6;
+
+            if (thread.failed())
+            {
+                qCWarning(DIGIKAM_TESTS_LOG) << command << ": FAILED," << thread.errorMessage();
+                ok = false;
+
+                break;
+            }
+
+            thread.takeImages(images);
+            const QString runHash = imageListHash(images);
+
+            if (!hash.isEmpty() && (runHash != hash))
+            {
+                qCWarning(DIGIKAM_TESTS_LOG) << command << ": FAILED, output is not deterministic";
+                ok = false;
+
+                break;
+            }
+
+            hash   = runHash;
+            bestMS = (bestMS < 0.0) ? elapsedMS : qMin(bestMS, elapsedMS);
+        }
+
+        if (!ok)
+        {
+            ++failures;
+
+            continue;
+        }
+
+        QJsonObject result;
+        result.insert(QLatin1String("hash"), hash);
+        results.insert(command, result);
+
+        if (recordBaseline)
+        {
+            timings.insert(command, bestMS);
+            qCDebug(DIGIKAM_TESTS_LOG) << command << ": recorded" << hash << bestMS << "ms";
+
+            continue;
+        }
+
+        const QJsonObject expected = baselineFilters.value(command).toObject();
+
+        if (expected.isEmpty())
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << command << ": FAILED, no baseline (run with --update to record it)," << bestMS << "ms";
+            ++failures;
+
+            continue;
+        }
+
+        const QString expectedHash = expected.value(QLatin1String("hash")).toString();
+
+        if (hash != expectedHash)
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << command << ": FAILED, output changed:" << hash << "expected:" << expectedHash;
+            ++failures;
+
+            continue;
+        }
+
+        if (!timings.contains(command))
+        {
+            timings.insert(command, bestMS);
+            newTimings = true;
+            qCDebug(DIGIKAM_TESTS_LOG) << command << ": passed," << bestMS << "ms, recorded as the local timing";
+
+            continue;
+        }
+
+        const double expectedMS = timings.value(command).toDouble();
+
+        if ((bestMS > expectedMS * threshold) && ((bestMS - expectedMS) > minimalSlowdownMS))
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << command << ": FAILED, slower:" << bestMS << "ms, local timing:" << expectedMS << "ms";
+            ++failures;
+        }
+        else
+        {
+            qCDebug(DIGIKAM_TESTS_LOG) << command << ": passed," << bestMS << "ms, local timing:" << expectedMS << "ms";
+        }
+    }
+
+    if (recordBaseline)
+    {
+        QJsonObject document;
+        document.insert(QLatin1String("seed"),    static_cast<int>(seed));
+        document.insert(QLatin1String("width"),   s_imageWidth);
+        document.insert(QLatin1String("height"),  s_imageHeight);
+        document.insert(QLatin1String("gmic"),    GmicQt::gmicVersionString());
+        document.insert(QLatin1String("filters"), results);
+
+        if (!writeJsonObject(baselinePath, document))
+        {
+            return (-1);
+        }
+    }
+
+    if ((recordBaseline || newTimings) && !writeJsonObject(timingsPath, timings))
+    {
+        return (-1);
+    }
+
+    qCDebug(DIGIKAM_TESTS_LOG) << commands.size() << "filter(s) checked," << failures << "failure(s)";
+
+    return (failures ? (-1) : 0);
+}
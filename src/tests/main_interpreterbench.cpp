@@ -0,0 +1,243 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2019-11-28
+ * Description : digiKam GmicQt tests.
+ *                Micro-benchmark of the G'MIC interpreter running loops
+ *                of custom commands over small images.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <cstring>
+
+// Qt includes
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QElapsedTimer>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// local includes
+
+#include "gmic.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+QString s_imagePath;
+
+} // namespace DigikamBqmGmicQtPlugin
+
+namespace
+{
+
+/**
+ * Custom commands called by the benchmarks: a body without any '$' item, a body
+ * with arguments, and a command calling both.
+ */
+const char* const s_benchCommands =
+    "_bench_inc :\n"
+    "  add 1 mul 0.5\n"
+    "_bench_scale :\n"
+    "  mul $1 add ${2=0}\n"
+    "_bench_nested :\n"
+    "  _bench_inc _bench_scale 2,$1\n";
+
+struct Benchmark
+{
+    const char* name;
+    const char* script;
+};
+
+const Benchmark s_benchmarks[] =
+{
+    { "constant body",     "1,1,1,3 repeat $1 { _bench_inc }"                               },
+    { "same arguments",    "1,1,1,3 repeat $1 { _bench_scale 0.5,1 }"                       },
+    { "varying arguments", "1,1,1,3 repeat $1 { _bench_scale 0.5,{$>%4} }"                  },
+    { "nested commands",   "1,1,1,3 repeat $1 { _bench_nested 1 }"                          },
+    { "stdlib commands",   "repeat {round($1/50)} { 16,16,1,3,'x*y' sepia to_gray rm }"     },
+    { nullptr,             nullptr                                                          }
+};
+
+/**
+ * Redefinition of a custom command between two runs of the same interpreter:
+ * the second run must not reuse the expansion of the first definition.
+ */
+const char* const s_redefinedCommands   = "_bench_redefined :\n  add 1\n_bench_redefined_args :\n  add $1\n";
+const char* const s_redefinitionCommands = "_bench_redefined :\n  add 100\n_bench_redefined_args :\n  mul $1\n";
+const char* const s_redefinitionScript   = "repeat 3 { _bench_redefined _bench_redefined_args 2 }";
+
+bool sameImages(const gmic_library::gmic_list<float>& a, const gmic_library::gmic_list<float>& b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0 ; i < a.size() ; ++i)
+    {
+        if (
+            !a[i].is_sameXYZC(b[i]) ||
+            (memcmp(a[i].data(), b[i].data(), a[i].size() * sizeof(float)) != 0)
+           )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Check the redefinition case, returns the number of failures.
+ */
+int checkRedefinition()
+{
+    try
+    {
+        gmic_library::gmic_list<float> images;
+        gmic_library::gmic_list<char> imageNames;
+        images.assign(1);
+        images[0].assign(1, 1, 1, 1, 0.0f);
+
+        gmic gmicInstance(nullptr, s_redefinedCommands, true, nullptr, nullptr, 0.0f);
+        gmicInstance.run(s_redefinitionScript, images, imageNames);
+
+        // ((((0 + 1) + 2) + 1) + 2) + 1) + 2 = 9, then (((9 + 100) * 2 + 100) * 2 + 100) * 2 = 1472.
+
+        gmicInstance.add_commands(s_redefinitionCommands);
+        gmicInstance.run(s_redefinitionScript, images, imageNames);
+
+        if (images.size() != 1 || images[0](0) != 1472.0f)
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << "redefined commands : FAILED, got"
+                                         << (images.size() ? images[0](0) : 0.0f) << "instead of 1472";
+
+            return 1;
+        }
+    }
+    catch (gmic_exception& e)
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "redefined commands : FAILED," << e.what();
+
+        return 1;
+    }
+
+    qCDebug(DIGIKAM_TESTS_LOG) << "redefined commands : passed";
+
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addVersionOption();
+    parser.addHelpOption();
+
+    QCommandLineOption iterationsOption(QStringList() << QLatin1String("i") << QLatin1String("iterations"),
+                                        QLatin1String("Loop iterations per benchmark (default: 20000)."),
+                                        QLatin1String("count"),
+                                        QLatin1String("20000"));
+
+    QCommandLineOption runsOption(QStringList() << QLatin1String("r") << QLatin1String("runs"),
+                                  QLatin1String("Runs per benchmark, the fastest one is kept (default: 3)."),
+                                  QLatin1String("count"),
+                                  QLatin1String("3"));
+
+    parser.addOption(iterationsOption);
+    parser.addOption(runsOption);
+    parser.process(app);
+
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const int runs       = qMax(1, parser.value(runsOption).toInt());
+    int failures         = 0;
+
+    for (int b = 0 ; s_benchmarks[b].name ; ++b)
+    {
+        const QByteArray script = QString::fromLatin1(s_benchmarks[b].script)
+                                  .replace(QLatin1String("$1"), QString::number(iterations))
+                                  .toLatin1();
+        double bestMS           = -1.0;
+        double uncachedMS       = -1.0;
+        gmic_library::gmic_list<float> output;
+        gmic_library::gmic_list<float> uncachedOutput;
+
+        // The last run is done without the expansion cache of the custom commands: its output is the reference.
+
+        for (int run = 0 ; run <= runs ; ++run)
+        {
+            const bool uncached = (run == runs);
+            gmic_library::gmic_list<float> images;
+            gmic_library::gmic_list<char> imageNames;
+
+            try
+            {
+                // The interpreter setup (stdlib parsing) is not part of the measure.
+
+                gmic gmicInstance(nullptr, s_benchCommands, true, nullptr, nullptr, 0.0f);
+                gmicInstance.is_expansion_cache = !uncached;
+
+                QElapsedTimer timer;
+                timer.start();
+                gmicInstance.run(script.constData(), images, imageNames);
+                const double elapsedMS = timer.nsecsElapsed() / 1.0e6;
+
+                if (uncached)
+                {
+                    uncachedMS = elapsedMS;
+                }
+                else
+                {
+                    bestMS     = (bestMS < 0.0) ? elapsedMS : qMin(bestMS, elapsedMS);
+                }
+            }
+            catch (gmic_exception& e)
+            {
+                qCWarning(DIGIKAM_TESTS_LOG) << s_benchmarks[b].name << ": FAILED," << e.what();
+                ++failures;
+                bestMS = -1.0;
+
+                break;
+            }
+
+            images.move_to(uncached ? uncachedOutput : output);
+        }
+
+        if (bestMS < 0.0)
+        {
+            continue;
+        }
+
+        if (!sameImages(output, uncachedOutput))
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << s_benchmarks[b].name << ": FAILED, output differs without the expansion cache";
+            ++failures;
+
+            continue;
+        }
+
+        qCDebug(DIGIKAM_TESTS_LOG) << s_benchmarks[b].name << ":" << bestMS << "ms,"
+                                   << (1.0e3 * bestMS / iterations) << "us per iteration,"
+                                   << uncachedMS << "ms without the expansion cache";
+    }
+
+    failures += checkRedefinition();
+
+    return (failures ? -1 : 0);
+}
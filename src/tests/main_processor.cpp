@@ -12,12 +12,17 @@
  *
  * ============================================================ */
 
+// C++ includes
+
+#include <cstring>
+
 // Qt includes
 
 #include <QEventLoop>
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
+#include <QElapsedTimer>
 
 // digiKam includes
 
@@ -39,6 +44,74 @@ QString s_imagePath;
 using namespace Digikam;
 using namespace DigikamBqmGmicQtPlugin;
 
+namespace
+{
+
+/**
+ * Run a chain of commands on an image. With a non empty identity, the stages
+ * are taken from (and stored to) the stage cache.
+ */
+bool runChain(const DImg& img, const QStringList& commands, const QString& identity, DImg& output, int* reusedStages = nullptr)
+{
+    GmicBqmProcessor* const gmicProcessor = new GmicBqmProcessor();
+    gmicProcessor->setInputImage(img);
+    gmicProcessor->setInputIdentity(identity);
+
+    if (!gmicProcessor->setProcessingCommands(commands))
+    {
+        delete gmicProcessor;
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: cannot setup G'MIC filter!";
+
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    gmicProcessor->startProcessing();
+
+    QEventLoop loop;
+
+    QObject::connect(gmicProcessor, SIGNAL(signalDone(QString)),
+                     &loop, SLOT(quit()));
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: started G'MIC filter...";
+
+    loop.exec();
+
+    bool b = gmicProcessor->processingComplete();
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: G'MIC filter completed:" << b
+                                     << "in" << timer.elapsed() << "ms,"
+                                     << "reused stages:" << gmicProcessor->reusedStages();
+
+    if (reusedStages)
+    {
+        *reusedStages = gmicProcessor->reusedStages();
+    }
+
+    output = gmicProcessor->outputImage().copy();
+
+    delete gmicProcessor;
+
+    return b;
+}
+
+bool sameImage(const DImg& a, const DImg& b)
+{
+    return (
+            !a.isNull()                         &&
+            (a.width()      == b.width())       &&
+            (a.height()     == b.height())      &&
+            (a.sixteenBit() == b.sixteenBit())  &&
+            (a.hasAlpha()   == b.hasAlpha())    &&
+            (a.numBytes()   == b.numBytes())    &&
+            (memcmp(a.bits(), b.bits(), a.numBytes()) == 0)
+           );
+}
+
+} // namespace
+
 int main(int argc, char* argv[])
 {
     QApplication app(argc, argv);
@@ -53,51 +126,65 @@ int main(int argc, char* argv[])
 
     DImg img;
 
-    if (!parser.positionalArguments().isEmpty())
+    if (parser.positionalArguments().isEmpty())
     {
-        QString path = parser.positionalArguments().constFirst();
-        qCDebug(DIGIKAM_TESTS_LOG) << "Image to Process:" << path;
+        qCDebug(DIGIKAM_TESTS_LOG) << "Image path is missing...";
 
-        GmicBqmProcessor* const gmicProcessor = new GmicBqmProcessor();
-        img.load(path);
-        gmicProcessor->setInputImage(img);
+        return 0;
+    }
 
-        QStringList chainedCommands;
-        chainedCommands << QLatin1String("gcd_aurora 6,1,0");               // Apply Aurora FX.
-        chainedCommands << QLatin1String("gcd_auto_balance 30,0,0,1,0");    // Apply auto color balance.
-        chainedCommands << QLatin1String("fx_old_photo 200,50,85");         // Add old photo frame.
+    QString path = parser.positionalArguments().constFirst();
+    qCDebug(DIGIKAM_TESTS_LOG) << "Image to Process:" << path;
 
-        if (!gmicProcessor->setProcessingCommand(chainedCommands.join(QLatin1Char(' '))))
-        {
-            delete gmicProcessor;
-            qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: cannot setup G'MIC filter!";
+    img.load(path);
 
-            return (-1);
-        }
+    // Deterministic filters only (no random noise), so that outputs can be compared exactly.
 
-        gmicProcessor->startProcessing();
+    QStringList chainedCommands;
+    chainedCommands << QLatin1String("blur 2");                         // Smooth.
+    chainedCommands << QLatin1String("sharpen 100");                    // Sharpen back.
+    chainedCommands << QLatin1String("mirror x");                       // Flip horizontally.
 
-        QEventLoop loop;
+    // Second run: only the last filter of the chain is edited, the first stages come from the cache.
 
-        QObject::connect(gmicProcessor, SIGNAL(signalDone(QString)),
-                         &loop, SLOT(quit()));
+    QStringList editedCommands = chainedCommands;
+    editedCommands.last()      = QLatin1String("mirror y");
 
-        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: started G'MIC filter...";
+    GmicBqmProcessor::clearStageCache();
 
-        loop.exec();
+    DImg reference;
+    DImg first;
+    DImg cached;
+    int  reusedStages = 0;
 
-        bool b = gmicProcessor->processingComplete();
+    if (!runChain(img, editedCommands, QString(), reference)         ||
+        !runChain(img, chainedCommands, path, first)                 ||
+        !runChain(img, editedCommands, path, cached, &reusedStages))
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "G'MIC chain processing failed!";
 
-        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: G'MIC filter completed:" << b;
+        return (-1);
+    }
 
-        gmicProcessor->outputImage().save(path + QLatin1String("_gmic.jpg"), "JPG");
+    GmicBqmProcessor::clearStageCache();
 
-        delete gmicProcessor;
+    first.save(path + QString::fromLatin1("_gmic0.jpg"), "JPG");
+    cached.save(path + QString::fromLatin1("_gmic1.jpg"), "JPG");
+
+    int failures = 0;
+
+    if (reusedStages != (editedCommands.size() - 1))
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "Cached chain prefix was not reused:" << reusedStages
+                                     << "stage(s) instead of" << (editedCommands.size() - 1);
+        ++failures;
     }
-    else
+
+    if (!sameImage(cached, reference))
     {
-        qCDebug(DIGIKAM_TESTS_LOG) << "Image path is missing...";
+        qCWarning(DIGIKAM_TESTS_LOG) << "Output computed from cached stages differs from the uncached output!";
+        ++failures;
     }
 
-    return 0;
+    return (failures ? -1 : 0);
 }
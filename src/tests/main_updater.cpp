@@ -0,0 +1,417 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2019-11-28
+ * Description : digiKam GmicQt tests.
+ *                Filter sources update against a local HTTP stand-in
+ *                server: streamed download, conditional requests,
+ *                bounded parallelism and corrupted sources.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// Qt includes
+
+#include <QApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QMap>
+#include <QSettings>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// local includes
+
+#include "Settings.h"
+#include "SourcesWidget.h"
+#include "Updater.h"
+#include "Utils.h"
+#include "gmic.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+QString s_imagePath;
+
+} // namespace DigikamBqmGmicQtPlugin
+
+using namespace GmicQt;
+
+namespace
+{
+
+/**
+ * Minimal HTTP/1.1 server standing for the filter sources host. Each source is
+ * served with an ETag, answered with "304 Not Modified" when the client sends
+ * the same one back, and written in small pieces after a short delay so that
+ * the client sees partial data and overlapping requests.
+ */
+class StandInServer
+{
+public:
+
+    struct Source
+    {
+        QByteArray body;
+        QByteArray etag;
+    };
+
+    StandInServer()
+    {
+        QObject::connect(&m_server, &QTcpServer::newConnection,
+                         [this]()
+            {
+                while (QTcpSocket* const socket = m_server.nextPendingConnection())
+                {
+                    QObject::connect(socket, &QTcpSocket::readyRead,
+                                     [this, socket]()
+                        {
+                            onReadyRead(socket);
+                        }
+                    );
+
+                    QObject::connect(socket, &QTcpSocket::disconnected,
+                                     socket, &QObject::deleteLater);
+                }
+            }
+        );
+    }
+
+    bool listen()
+    {
+        return m_server.listen(QHostAddress::LocalHost);
+    }
+
+    QString url(const QString& name) const
+    {
+        return QString::fromLatin1("http://127.0.0.1:%1/%2").arg(m_server.serverPort()).arg(name);
+    }
+
+    void setSource(const QString& name, const QByteArray& body)
+    {
+        Source& source = m_sources[QLatin1Char('/') + name];
+        source.body    = body;
+        source.etag    = QByteArray("\"") + QByteArray::number(qHash(body), 16) + QByteArray("\"");
+    }
+
+    void resetCounters()
+    {
+        m_requests    = 0;
+        m_notModified = 0;
+        m_maxInFlight = 0;
+    }
+
+    int requests()    const { return m_requests;    }
+    int notModified() const { return m_notModified; }
+    int maxInFlight() const { return m_maxInFlight; }
+
+private:
+
+    void onReadyRead(QTcpSocket* const socket)
+    {
+        QByteArray& buffer = m_buffers[socket];
+        buffer            += socket->readAll();
+        const int end      = buffer.indexOf("\r\n\r\n");
+
+        if (end < 0)
+        {
+            return;
+        }
+
+        const QList<QByteArray> lines = buffer.left(end).split('\n');
+        m_buffers.remove(socket);
+
+        const QByteArray path         = lines.first().split(' ').value(1);
+        QByteArray ifNoneMatch;
+
+        for (const QByteArray& line : lines)
+        {
+            if (line.toLower().startsWith("if-none-match:"))
+            {
+                ifNoneMatch = line.mid(line.indexOf(':') + 1).trimmed();
+            }
+        }
+
+        ++m_requests;
+        m_maxInFlight = qMax(m_maxInFlight, ++m_inFlight);
+
+        QTimer::singleShot(100, socket, [this, socket, path, ifNoneMatch]()
+            {
+                respond(socket, QString::fromLatin1(path), ifNoneMatch);
+                --m_inFlight;
+            }
+        );
+    }
+
+    void respond(QTcpSocket* const socket, const QString& path, const QByteArray& ifNoneMatch)
+    {
+        QByteArray header;
+
+        if (!m_sources.contains(path))
+        {
+            header = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            socket->write(header);
+            socket->disconnectFromHost();
+
+            return;
+        }
+
+        const Source& source = m_sources[path];
+
+        if (!ifNoneMatch.isEmpty() && (ifNoneMatch == source.etag))
+        {
+            ++m_notModified;
+            header = "HTTP/1.1 304 Not Modified\r\nETag: " + source.etag + "\r\nConnection: close\r\n\r\n";
+            socket->write(header);
+            socket->disconnectFromHost();
+
+            return;
+        }
+
+        header = "HTTP/1.1 200 OK\r\n"
+                 "Content-Type: application/octet-stream\r\n"
+                 "Content-Length: " + QByteArray::number(source.body.size()) + "\r\n"
+                 "ETag: " + source.etag + "\r\n"
+                 "Last-Modified: Thu, 28 Nov 2019 10:00:00 GMT\r\n"
+                 "Connection: close\r\n\r\n";
+        socket->write(header);
+        socket->flush();
+
+        for (int offset = 0 ; offset < source.body.size() ; offset += 512)
+        {
+            socket->write(source.body.mid(offset, 512));
+            socket->flush();
+        }
+
+        socket->disconnectFromHost();
+    }
+
+private:
+
+    QTcpServer                     m_server;
+    QMap<QString, Source>          m_sources;
+    QMap<QTcpSocket*, QByteArray>  m_buffers;
+    int                            m_requests    = 0;
+    int                            m_notModified = 0;
+    int                            m_inFlight    = 0;
+    int                            m_maxInFlight = 0;
+};
+
+/**
+ * A filter definition file, as published on the filter sources servers.
+ */
+QByteArray filterDefinitions(int index)
+{
+    QByteArray text;
+
+    for (int i = 0 ; i < 200 ; ++i)
+    {
+        text += "#@gui Stand-in filter " + QByteArray::number(index) + "." + QByteArray::number(i) +
+                " : fx_standin_" + QByteArray::number(index) + "_" + QByteArray::number(i) +
+                ", fx_standin_preview\n"
+                "#@gui : Amount = float(" + QByteArray::number(i) + ",0,1000)\n"
+                "fx_standin_" + QByteArray::number(index) + "_" + QByteArray::number(i) + " :\n"
+                "  mul $1\n";
+    }
+
+    return text;
+}
+
+/**
+ * The same file in the serialized, zlib compressed, CImg format served for the
+ * official filters.
+ */
+QByteArray serializedCImg(const QByteArray& text)
+{
+    gmic_library::gmic_list<unsigned char> list(1);
+    list[0].assign((const unsigned char*)text.constData(), (unsigned int)text.size());
+
+    const gmic_library::gmic_image<unsigned char> serialized = list.get_serialize(true);
+
+    return QByteArray((const char*)serialized.data(), (int)serialized.size());
+}
+
+QByteArray readFile(const QString& filename)
+{
+    QFile file(filename);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+
+    return file.readAll();
+}
+
+bool writeFile(const QString& filename, const QByteArray& data)
+{
+    QFile file(filename);
+
+    return (file.open(QIODevice::WriteOnly) && (file.write(data) == data.size()));
+}
+
+/**
+ * Run a full update of the configured sources and return its status.
+ */
+int runUpdate()
+{
+    int status = -1;
+    QEventLoop loop;
+
+    QMetaObject::Connection connection = QObject::connect(Updater::getInstance(), &Updater::updateIsDone,
+                                                          [&status, &loop](int s)
+        {
+            status = s;
+            loop.quit();
+        }
+    );
+
+    // Age limit of zero: every source is checked against the server.
+
+    Updater::getInstance()->startUpdate(0, 10, true);
+
+    if (status < 0)
+    {
+        loop.exec();
+    }
+
+    QObject::disconnect(connection);
+
+    return status;
+}
+
+int s_failures = 0;
+
+void check(bool condition, const char* what)
+{
+    if (condition)
+    {
+        qCDebug(DIGIKAM_TESTS_LOG) << what << ": OK";
+    }
+    else
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << what << ": FAILED";
+        ++s_failures;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // Downloaded sources and validators must not touch the user configuration.
+
+    QTemporaryDir configDir;
+
+    if (!configDir.isValid())
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "Cannot create a temporary directory";
+
+        return (-1);
+    }
+
+    qputenv("GMIC_PATH", QFile::encodeName(configDir.path()));
+
+    QApplication app(argc, argv);
+    QCoreApplication::setOrganizationName(QLatin1String("digikam-tests"));
+    QCoreApplication::setApplicationName(QLatin1String("gmic-qt-updater"));
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, configDir.path());
+
+    StandInServer server;
+
+    if (!server.listen())
+    {
+        qCWarning(DIGIKAM_TESTS_LOG) << "Cannot start the local HTTP server";
+
+        return (-1);
+    }
+
+    Settings::setOfficialFilterSource(SourcesWidget::OfficialFilters::Disabled);
+
+    const QString configPath = gmicConfigPath(true);
+
+    // First download: the compressed source is inflated while it is received.
+
+    const QByteArray text = filterDefinitions(0);
+    server.setSource(QLatin1String("standin.cimgz"), serializedCImg(text));
+    Settings::setFilterSources(QStringList() << server.url(QLatin1String("standin.cimgz")));
+
+    server.resetCounters();
+    int status = runUpdate();
+
+    check(status == (int)Updater::UpdateStatus::Successful, "First download succeeds");
+    check(Updater::getInstance()->someNetworkUpdateAchieved(), "First download updates the source");
+    check(readFile(configPath + QLatin1String("standin.cimgz")) == text, "Source is stored decompressed");
+
+    // Second check: nothing changed, a single round-trip without content.
+
+    server.resetCounters();
+    status = runUpdate();
+
+    check(status == (int)Updater::UpdateStatus::Successful, "Unchanged source check succeeds");
+    check((server.requests() == 1) && (server.notModified() == 1), "Unchanged source answered with 304");
+    check(!Updater::getInstance()->someNetworkUpdateAchieved(), "Unchanged source is not reported as updated");
+    check(readFile(configPath + QLatin1String("standin.cimgz")) == text, "Unchanged source is kept");
+
+    // Parallel downloads are bounded.
+
+    QStringList sources;
+    QList<QByteArray> texts;
+
+    for (int i = 1 ; i <= 3 * Updater::MaxParallelDownloads ; ++i)
+    {
+        const QString name = QString::fromLatin1("standin%1.gmic").arg(i);
+        texts << filterDefinitions(i);
+        server.setSource(name, (i % 2) ? serializedCImg(texts.last()) : texts.last());
+        sources << server.url(name);
+    }
+
+    Settings::setFilterSources(sources);
+
+    server.resetCounters();
+    status = runUpdate();
+
+    check(status == (int)Updater::UpdateStatus::Successful, "Parallel downloads succeed");
+    check(server.maxInFlight() <= Updater::MaxParallelDownloads, "Parallel downloads are bounded");
+    check(server.maxInFlight() > 1, "Downloads run in parallel");
+
+    bool allStored = true;
+
+    for (int i = 0 ; i < sources.size() ; ++i)
+    {
+        allStored &= (readFile(configPath + QString::fromLatin1("standin%1.gmic").arg(i + 1)) == texts[i]);
+    }
+
+    check(allStored, "All parallel downloads are stored");
+
+    // A corrupted source is reported and does not replace the previous file.
+
+    const QByteArray previous = filterDefinitions(100);
+    QByteArray corrupted      = serializedCImg(filterDefinitions(101));
+    corrupted.truncate(corrupted.size() / 2);
+    corrupted.append(QByteArray(1024, '\x5a'));
+
+    check(writeFile(configPath + QLatin1String("corrupted.cimgz"), previous), "Previous corrupted source is written");
+    server.setSource(QLatin1String("corrupted.cimgz"), corrupted);
+    Settings::setFilterSources(QStringList() << server.url(QLatin1String("corrupted.cimgz")));
+
+    server.resetCounters();
+    status = runUpdate();
+
+    check(status == (int)Updater::UpdateStatus::SomeFailed, "Corrupted source is reported");
+    check(!Updater::getInstance()->errorMessages().isEmpty(), "Corrupted source has an error message");
+    check(readFile(configPath + QLatin1String("corrupted.cimgz")) == previous, "Previous file is kept");
+
+    return (s_failures ? -1 : 0);
+}